@@ -0,0 +1,25 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef CLIENT_TESTS_CLIENTTEST_H
+#define CLIENT_TESTS_CLIENTTEST_H
+
+#include <stdio.h>
+
+// The checks shared by the tests in this directory. A failed CHECK() reports where it failed
+// and the test goes on, so one run lists every mismatch; main() returns TEST_RESULT().
+static int g_testFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            ++g_testFailures; \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+#define TEST_RESULT(name) \
+    (fprintf(stderr, "%s: %s\n", name, g_testFailures ? "FAILED" : "passed"), g_testFailures ? 1 : 0)
+
+#endif
@@ -0,0 +1,329 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "ClientTest.h"
+
+#include "DefaultEWrapper.h"
+#include "EDecoder.h"
+#include "EStaticDecoder.h"
+#include "EWrapperView.h"
+
+#include <stdarg.h>
+#include <string>
+#include <vector>
+
+// Decodes every message type EStaticDecoder handles, at server versions on both sides of each
+// feature check and cut short at every byte, through EDecoder and through EStaticDecoder, and
+// checks that both consume the same bytes and make the same callbacks with the same values.
+
+namespace {
+
+class Transcript
+{
+	std::string m_text;
+
+public:
+	void add(const char *fmt, ...) {
+		char line[512];
+		va_list args;
+
+		va_start(args, fmt);
+		vsnprintf(line, sizeof(line), fmt, args);
+		va_end(args);
+
+		m_text += line;
+		m_text += '\n';
+	}
+
+	void clear() { m_text.clear(); }
+	const std::string &text() const { return m_text; }
+
+	// only the lines of one callback
+	std::string filter(const char *callback) const {
+		std::string prefix = std::string(callback) + ' ';
+		std::string result;
+		size_t pos = 0;
+
+		while (pos < m_text.size()) {
+			size_t end = m_text.find('\n', pos) + 1;
+
+			if (m_text.compare(pos, prefix.size(), prefix) == 0)
+				result.append(m_text, pos, end - pos);
+
+			pos = end;
+		}
+
+		return result;
+	}
+};
+
+// what EDecoder calls, also the fallback of EStaticDecoder
+class RecordingWrapper : public DefaultEWrapper
+{
+	Transcript &m_out;
+
+public:
+	explicit RecordingWrapper(Transcript &out) : m_out(out) {}
+
+	void tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attrib) {
+		m_out.add("tickPrice %ld %d %.17g %d%d%d", tickerId, (int)field, price, attrib.canAutoExecute, attrib.pastLimit, attrib.preOpen);
+	}
+	void tickSize(TickerId tickerId, TickType field, int size) {
+		m_out.add("tickSize %ld %d %d", tickerId, (int)field, size);
+	}
+	void tickGeneric(TickerId tickerId, TickType tickType, double value) {
+		m_out.add("tickGeneric %ld %d %.17g", tickerId, (int)tickType, value);
+	}
+	void tickString(TickerId tickerId, TickType tickType, const std::string& value) {
+		m_out.add("tickString %ld %d [%s]", tickerId, (int)tickType, value.c_str());
+	}
+	void updateMktDepth(TickerId id, int position, int operation, int side, double price, int size) {
+		m_out.add("updateMktDepth %ld %d %d %d %.17g %d", id, position, operation, side, price, size);
+	}
+	void updateMktDepthL2(TickerId id, int position, const std::string& marketMaker, int operation,
+		int side, double price, int size, bool isSmartDepth) {
+		m_out.add("updateMktDepthL2 %ld %d [%s] %d %d %.17g %d %d", id, position, marketMaker.c_str(), operation, side, price, size, isSmartDepth);
+	}
+	void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size, const TickAttribLast& attribs,
+		const std::string& exchange, const std::string& specialConditions) {
+		m_out.add("tickByTickAllLast %d %d %lld %.17g %d %d%d [%s] [%s]", reqId, tickType, (long long)time, price, size,
+			attribs.pastLimit, attribs.unreported, exchange.c_str(), specialConditions.c_str());
+	}
+	void tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize, int askSize,
+		const TickAttribBidAsk& attribs) {
+		m_out.add("tickByTickBidAsk %d %lld %.17g %.17g %d %d %d%d", reqId, (long long)time, bidPrice, askPrice, bidSize, askSize,
+			attribs.bidPastLow, attribs.askPastHigh);
+	}
+	void tickByTickMidPoint(int reqId, time_t time, double midPoint) {
+		m_out.add("tickByTickMidPoint %d %lld %.17g", reqId, (long long)time, midPoint);
+	}
+	void pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) {
+		m_out.add("pnl %d %.17g %.17g %.17g", reqId, dailyPnL, unrealizedPnL, realizedPnL);
+	}
+	void pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {
+		m_out.add("pnlSingle %d %d %.17g %.17g %.17g %.17g", reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
+	}
+	void nextValidId(OrderId orderId) {
+		m_out.add("nextValidId %ld", orderId);
+	}
+	void error(int id, int errorCode, const std::string& errorString) {
+		m_out.add("error %d %d %s", id, errorCode, errorString.c_str());
+	}
+};
+
+// an EStaticDecoder handler taking the string fields as EStringView
+struct ViewHandler
+{
+	RecordingWrapper &w;
+
+	void tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attrib) { w.tickPrice(tickerId, field, price, attrib); }
+	void tickSize(TickerId tickerId, TickType field, int size) { w.tickSize(tickerId, field, size); }
+	void tickGeneric(TickerId tickerId, TickType tickType, double value) { w.tickGeneric(tickerId, tickType, value); }
+	void tickString(TickerId tickerId, TickType tickType, const EStringView& value) { w.tickString(tickerId, tickType, value.str()); }
+	void updateMktDepth(TickerId id, int position, int operation, int side, double price, int size) {
+		w.updateMktDepth(id, position, operation, side, price, size);
+	}
+	void updateMktDepthL2(TickerId id, int position, const EStringView& marketMaker, int operation,
+		int side, double price, int size, bool isSmartDepth) {
+		w.updateMktDepthL2(id, position, marketMaker.str(), operation, side, price, size, isSmartDepth);
+	}
+	void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size, const TickAttribLast& attribs,
+		const EStringView& exchange, const EStringView& specialConditions) {
+		w.tickByTickAllLast(reqId, tickType, time, price, size, attribs, exchange.str(), specialConditions.str());
+	}
+	void tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize, int askSize,
+		const TickAttribBidAsk& attribs) {
+		w.tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, attribs);
+	}
+	void tickByTickMidPoint(int reqId, time_t time, double midPoint) { w.tickByTickMidPoint(reqId, time, midPoint); }
+	void pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) { w.pnl(reqId, dailyPnL, unrealizedPnL, realizedPnL); }
+	void pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {
+		w.pnlSingle(reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
+	}
+};
+
+// the same, with the EWrapper signatures
+struct CopyHandler
+{
+	RecordingWrapper &w;
+
+	void tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attrib) { w.tickPrice(tickerId, field, price, attrib); }
+	void tickSize(TickerId tickerId, TickType field, int size) { w.tickSize(tickerId, field, size); }
+	void tickGeneric(TickerId tickerId, TickType tickType, double value) { w.tickGeneric(tickerId, tickType, value); }
+	void tickString(TickerId tickerId, TickType tickType, const std::string& value) { w.tickString(tickerId, tickType, value); }
+	void updateMktDepth(TickerId id, int position, int operation, int side, double price, int size) {
+		w.updateMktDepth(id, position, operation, side, price, size);
+	}
+	void updateMktDepthL2(TickerId id, int position, const std::string& marketMaker, int operation,
+		int side, double price, int size, bool isSmartDepth) {
+		w.updateMktDepthL2(id, position, marketMaker, operation, side, price, size, isSmartDepth);
+	}
+	void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size, const TickAttribLast& attribs,
+		const std::string& exchange, const std::string& specialConditions) {
+		w.tickByTickAllLast(reqId, tickType, time, price, size, attribs, exchange, specialConditions);
+	}
+	void tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize, int askSize,
+		const TickAttribBidAsk& attribs) {
+		w.tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, attribs);
+	}
+	void tickByTickMidPoint(int reqId, time_t time, double midPoint) { w.tickByTickMidPoint(reqId, time, midPoint); }
+	void pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) { w.pnl(reqId, dailyPnL, unrealizedPnL, realizedPnL); }
+	void pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {
+		w.pnlSingle(reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
+	}
+};
+
+// wants nothing but tickPrice and the BidAsk tick-by-tick ticks, the rest is skipped unread
+struct PartialHandler
+{
+	RecordingWrapper &w;
+
+	void tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attrib) { w.tickPrice(tickerId, field, price, attrib); }
+	void tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize, int askSize,
+		const TickAttribBidAsk& attribs) {
+		w.tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, attribs);
+	}
+};
+
+class MessageBuilder
+{
+	std::string m_msg;
+
+public:
+	MessageBuilder &operator<<(const char *field) {
+		m_msg += field;
+		m_msg += '\0';
+		return *this;
+	}
+
+	const std::string &str() const { return m_msg; }
+};
+
+// one of each message EStaticDecoder takes, laid out as a server at version sends it
+std::vector<std::string> MarketDataMessages(int version) {
+	std::vector<std::string> msgs;
+	static const char *const tickPriceTypes[] = { "1", "2", "4", "9", "66", "67", "68" };
+	static const char *const attrMasks[] = { "0", "1", "2", "7" };
+
+	for (size_t i = 0; i < sizeof(tickPriceTypes) / sizeof(tickPriceTypes[0]); ++i)
+		for (size_t j = 0; j < sizeof(attrMasks) / sizeof(attrMasks[0]); ++j)
+			msgs.push_back((MessageBuilder() << "1" << "6" << "1001" << tickPriceTypes[i] << "4012.25" << "17" << attrMasks[j]).str());
+
+	msgs.push_back((MessageBuilder() << "2" << "6" << "1001" << "8" << "123456").str());
+	msgs.push_back((MessageBuilder() << "45" << "6" << "1001" << "49" << "0.5").str());
+	msgs.push_back((MessageBuilder() << "46" << "6" << "1001" << "45" << "1767225600").str());
+	msgs.push_back((MessageBuilder() << "46" << "6" << "1001" << "32" << "").str());
+	msgs.push_back((MessageBuilder() << "12" << "1" << "1002" << "3" << "1" << "0" << "4012.5" << "25").str());
+
+	MessageBuilder l2;
+	l2 << "13" << "1" << "1002" << "3" << "NSDQ" << "1" << "1" << "4012.75" << "30";
+	if (version >= MIN_SERVER_VER_SMART_DEPTH)
+		l2 << "1";
+	msgs.push_back(l2.str());
+
+	msgs.push_back((MessageBuilder() << "99" << "1003" << "1" << "1767225600" << "4012.5" << "3" << "2" << "CME" << "").str());
+	msgs.push_back((MessageBuilder() << "99" << "1003" << "2" << "1767225601" << "4012.75" << "1" << "3" << "GLOBEX" << "T I").str());
+	msgs.push_back((MessageBuilder() << "99" << "1003" << "3" << "1767225602" << "4012.5" << "4012.75" << "12" << "9" << "1").str());
+	msgs.push_back((MessageBuilder() << "99" << "1003" << "4" << "1767225603" << "4012.625").str());
+	msgs.push_back((MessageBuilder() << "99" << "1003" << "0" << "1767225604").str());
+
+	MessageBuilder pnl;
+	pnl << "94" << "1004" << "-125.5";
+	if (version >= MIN_SERVER_VER_UNREALIZED_PNL)
+		pnl << "250.25";
+	if (version >= MIN_SERVER_VER_REALIZED_PNL)
+		pnl << "1.7976931348623157E308";
+	msgs.push_back(pnl.str());
+
+	MessageBuilder pnlSingle;
+	pnlSingle << "95" << "1005" << "3" << "12.5";
+	if (version >= MIN_SERVER_VER_UNREALIZED_PNL)
+		pnlSingle << "-7.25";
+	if (version >= MIN_SERVER_VER_REALIZED_PNL)
+		pnlSingle << "0.125";
+	pnlSingle << "12037.75";
+	msgs.push_back(pnlSingle.str());
+
+	// not a market data message, goes to the fallback
+	msgs.push_back((MessageBuilder() << "9" << "1" << "42").str());
+
+	return msgs;
+}
+
+int DecodeWithEDecoder(int version, const std::string &msg, size_t size, Transcript &out) {
+	RecordingWrapper wrapper(out);
+	EDecoder decoder(version, &wrapper);
+	const char *begin = msg.data();
+
+	return decoder.parseAndProcessMsg(begin, begin + size);
+}
+
+template<class Handler>
+int DecodeWithStaticDecoder(int version, const std::string &msg, size_t size, Transcript &out) {
+	RecordingWrapper wrapper(out);
+	Handler handler = { wrapper };
+	EStaticDecoder<Handler> decoder(handler);
+	EDecoder fallback(version, &wrapper);
+	const char *begin = msg.data();
+
+	return decoder.parseAndProcessMsg(begin, begin + size, fallback);
+}
+
+template<class Handler>
+void CheckEquivalent(int version, const std::string &msg, const char *handlerName) {
+	Transcript expected;
+	Transcript actual;
+
+	// the whole message, then cut short at every byte
+	for (size_t size = msg.size(); size > 0; --size) {
+		expected.clear();
+		actual.clear();
+
+		int expectedSize = DecodeWithEDecoder(version, msg, size, expected);
+		int actualSize = DecodeWithStaticDecoder<Handler>(version, msg, size, actual);
+
+		CHECK(expectedSize == actualSize);
+		CHECK(expected.text() == actual.text());
+
+		if (expectedSize != actualSize || expected.text() != actual.text()) {
+			fprintf(stderr, "  %s, version %d, msgId %s, %zu of %zu bytes: %d vs %d\n%s  vs\n%s", handlerName, version,
+				msg.c_str(), size, msg.size(), expectedSize, actualSize, expected.text().c_str(), actual.text().c_str());
+			return;
+		}
+	}
+}
+
+void CheckPartial(int version, const std::string &msg) {
+	Transcript expected;
+	Transcript actual;
+
+	int expectedSize = DecodeWithEDecoder(version, msg, msg.size(), expected);
+	int actualSize = DecodeWithStaticDecoder<PartialHandler>(version, msg, msg.size(), actual);
+
+	// skipped messages still consume the whole frame, the fallback keeps its callbacks
+	CHECK(actualSize == (int)msg.size());
+	CHECK(expectedSize == actualSize);
+	CHECK(actual.text() == expected.filter("tickPrice") + expected.filter("tickByTickBidAsk") + expected.filter("nextValidId"));
+}
+
+}
+
+int main() {
+	static const int versions[] = {
+		MIN_SERVER_VER_PAST_LIMIT - 1, MIN_SERVER_VER_PAST_LIMIT, MIN_SERVER_VER_UNREALIZED_PNL, MIN_SERVER_VER_PRE_OPEN_BID_ASK,
+		MIN_SERVER_VER_REALIZED_PNL, MIN_SERVER_VER_SMART_DEPTH - 1, MIN_SERVER_VER_SMART_DEPTH, MAX_CLIENT_VER
+	};
+
+	for (size_t i = 0; i < sizeof(versions) / sizeof(versions[0]); ++i) {
+		std::vector<std::string> msgs = MarketDataMessages(versions[i]);
+
+		for (size_t j = 0; j < msgs.size(); ++j) {
+			CheckEquivalent<ViewHandler>(versions[i], msgs[j], "EStringView handler");
+			CheckEquivalent<CopyHandler>(versions[i], msgs[j], "std::string handler");
+			CheckPartial(versions[i], msgs[j]);
+		}
+	}
+
+	return TEST_RESULT("DecoderEquivalenceTest");
+}
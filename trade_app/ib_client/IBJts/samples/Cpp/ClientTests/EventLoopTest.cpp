@@ -0,0 +1,161 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "ClientTest.h"
+#include "FakeGateway.h"
+
+#include "DefaultEWrapper.h"
+#include "EClientSocket.h"
+#include "EReader.h"
+#include "EReaderEventLoop.h"
+#include "EReaderOSSignal.h"
+
+#include <atomic>
+#include <chrono>
+#include <signal.h>
+#include <thread>
+#include <unistd.h>
+
+// Several connections on one EReaderEventLoop. The gateway of one of them resets it; the
+// EWrapper callback the loop makes for that removes its reader and adds a reader for a new
+// connection. The loop has to come back from the callback, and keep serving the connection
+// left alone as well as the one added.
+
+namespace {
+
+const int WAIT_MS = 5000;
+const unsigned long SIGNAL_WAIT_MS = 100;
+
+class LoopWrapper : public DefaultEWrapper
+{
+public:
+	std::atomic<int> m_currentTimes;
+	std::atomic<bool> m_callbackDone;
+	bool m_added;
+	bool m_onLoopThread;
+
+	// what the first error() or connectionClosed() does
+	EReaderEventLoop *m_pLoop;
+	EReader *m_pRemove;
+	EReader *m_pAdd;
+	std::thread::id m_testThread;
+
+	LoopWrapper() : m_currentTimes(0), m_callbackDone(false), m_added(false), m_onLoopThread(false),
+		m_pLoop(0), m_pRemove(0), m_pAdd(0), m_testThread(std::this_thread::get_id()) {}
+
+	void currentTime(long time) {
+		if (time == FakeGateway::CURRENT_TIME_REPLY)
+			++m_currentTimes;
+	}
+
+	void error(int id, int errorCode, const std::string& errorString) {
+		onConnectionLost();
+	}
+
+	void connectionClosed() {
+		onConnectionLost();
+	}
+
+private:
+	void onConnectionLost() {
+		if (!m_pLoop || m_callbackDone)
+			return;
+
+		m_onLoopThread = std::this_thread::get_id() != m_testThread;
+		m_pLoop->remove(m_pRemove);
+		m_added = m_pLoop->add(m_pAdd);
+		m_callbackDone = true;
+	}
+};
+
+struct Connection
+{
+	FakeGateway gateway;
+	LoopWrapper wrapper;
+	EClientSocket client;
+	EReaderOSSignal signal;
+	EReader *reader;     // takes the server version, so only made once connected
+
+	explicit Connection(FakeGateway::Mode mode)
+		: gateway(mode), client(&wrapper, &signal), signal(SIGNAL_WAIT_MS), reader(0) {}
+
+	~Connection() {
+		delete reader;
+	}
+
+	bool connect() {
+		if (gateway.port() == 0 || !client.eConnect("127.0.0.1", gateway.port(), 0, false))
+			return false;
+
+		reader = new EReader(&client, &signal);
+		return true;
+	}
+
+	// a reqCurrentTime() answered through the reader
+	bool roundTrip() {
+		const int before = wrapper.m_currentTimes;
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(WAIT_MS);
+
+		client.reqCurrentTime();
+
+		while (wrapper.m_currentTimes == before && client.isConnected() && std::chrono::steady_clock::now() < deadline) {
+			signal.waitForSignal();
+			reader->processMsgs();
+		}
+
+		return wrapper.m_currentTimes > before;
+	}
+
+private:
+	// disable copy (compatible with pre C++11 compiler hence =delete not used)
+	Connection(const Connection&);
+	Connection& operator=(const Connection&);
+};
+
+}
+
+int main(int argc, char** argv)
+{
+	signal(SIGPIPE, SIG_IGN);
+
+	EReaderEventLoop loop;
+	Connection reset(FakeGateway::RESET), kept(FakeGateway::RECORD), added(FakeGateway::RECORD);
+
+	if (!reset.connect() || !kept.connect() || !added.connect()) {
+		CHECK(!"connected to the fake gateways");
+		return TEST_RESULT("EventLoopTest");
+	}
+
+	loop.start();
+	reset.reader->start(&loop);
+	kept.reader->start(&loop);
+
+	CHECK(kept.roundTrip());
+
+	reset.wrapper.m_pRemove = reset.reader;
+	reset.wrapper.m_pAdd = added.reader;
+	reset.wrapper.m_pLoop = &loop;
+	reset.gateway.release();
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(WAIT_MS);
+
+	while (!reset.wrapper.m_callbackDone && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	if (!reset.wrapper.m_callbackDone) {
+		CHECK(!"the loop came back from the callback");
+
+		// the loop is stuck in it, tearing down would wait for it forever
+		_exit(TEST_RESULT("EventLoopTest"));
+	}
+
+	CHECK(reset.wrapper.m_onLoopThread);
+	CHECK(reset.wrapper.m_added);
+	CHECK(kept.roundTrip());
+	CHECK(added.roundTrip());
+	CHECK(kept.client.isConnected());
+	CHECK(added.client.isConnected());
+
+	return TEST_RESULT("EventLoopTest");
+}
@@ -0,0 +1,190 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef CLIENT_TESTS_FAKEGATEWAY_H
+#define CLIENT_TESTS_FAKEGATEWAY_H
+
+#include "EClient.h"
+#include "EDecoder.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Accepts one client on a loopback port, announces MAX_CLIENT_VER and records every message
+// the client sends after the handshake until it disconnects, answering reqCurrentTime() with
+// CURRENT_TIME_REPLY. Once the client's startApi is in,
+// HOLD stops reading until release(), so the client's sends back up; RESET waits for release()
+// and then drops the connection with a reset.
+class FakeGateway
+{
+public:
+	enum Mode { RECORD, HOLD, RESET };
+
+	static const long CURRENT_TIME_REPLY = 1767225600;
+
+private:
+	int m_listenFd;
+	int m_port;
+	Mode m_mode;
+	std::vector<std::string> m_msgs;
+	std::mutex m_mutex;
+	std::condition_variable m_released;
+	bool m_isReleased;
+	std::thread m_thread;
+
+	static bool readFully(int fd, char *buf, size_t size) {
+		while (size > 0) {
+			ssize_t n = ::recv(fd, buf, size, 0);
+
+			if (n <= 0)
+				return false;
+
+			buf += n;
+			size -= n;
+		}
+
+		return true;
+	}
+
+	static bool readFrame(int fd, std::string &body) {
+		unsigned char header[4];
+
+		if (!readFully(fd, (char *)header, sizeof(header)))
+			return false;
+
+		size_t size = ((size_t)header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+
+		body.resize(size);
+		return size == 0 || readFully(fd, &body[0], size);
+	}
+
+	static void writeFrame(int fd, const std::string &body) {
+		std::string frame(4, '\0');
+
+		frame[0] = (char)(body.size() >> 24);
+		frame[1] = (char)(body.size() >> 16);
+		frame[2] = (char)(body.size() >> 8);
+		frame[3] = (char)body.size();
+		frame += body;
+
+		::send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+	}
+
+	void waitForRelease() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (!m_isReleased)
+			m_released.wait(lock);
+	}
+
+	void serve() {
+		int fd = ::accept(m_listenFd, 0, 0);
+
+		if (fd < 0)
+			return;
+
+		char prefix[4];
+		std::string body;
+
+		// "API\0", then the client's version range
+		if (readFully(fd, prefix, sizeof(prefix)) && readFrame(fd, body)) {
+			std::string ack = std::to_string(MAX_CLIENT_VER);
+
+			ack += '\0';
+			ack += "20260101 00:00:00 EST";
+			ack += '\0';
+			writeFrame(fd, ack);
+
+			// startApi
+			if (m_mode != RECORD && readFrame(fd, body)) {
+				m_msgs.push_back(body);
+				waitForRelease();
+			}
+
+			if (m_mode == RESET) {
+				struct linger reset = { 1, 0 };
+
+				setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+			}
+			else {
+				while (readFrame(fd, body)) {
+					m_msgs.push_back(body);
+
+					// the message id is the first field
+					if (atoi(body.c_str()) == ibapi::client_constants::REQ_CURRENT_TIME) {
+						std::string reply = std::to_string(CURRENT_TIME);
+
+						reply += '\0';
+						reply += "1";
+						reply += '\0';
+						reply += std::to_string(CURRENT_TIME_REPLY);
+						reply += '\0';
+						writeFrame(fd, reply);
+					}
+				}
+			}
+		}
+
+		::close(fd);
+	}
+
+	// disable copy (compatible with pre C++11 compiler hence =delete not used)
+	FakeGateway(const FakeGateway&);
+	FakeGateway& operator=(const FakeGateway&);
+
+public:
+	// rcvBuf > 0 shrinks the receive buffer of the accepted connection, bytes
+	explicit FakeGateway(Mode mode = RECORD, int rcvBuf = -1)
+		: m_listenFd(::socket(AF_INET, SOCK_STREAM, 0)), m_port(0), m_mode(mode), m_isReleased(false) {
+		sockaddr_in addr = {};
+
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		socklen_t addrLen = sizeof(addr);
+
+		// inherited by the accepted socket, and only honoured when set before the handshake
+		if (rcvBuf > 0)
+			setsockopt(m_listenFd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+
+		if (::bind(m_listenFd, (sockaddr *)&addr, sizeof(addr)) == 0 && ::listen(m_listenFd, 1) == 0
+			&& ::getsockname(m_listenFd, (sockaddr *)&addr, &addrLen) == 0) {
+			m_port = ntohs(addr.sin_port);
+			m_thread = std::thread(&FakeGateway::serve, this);
+		}
+	}
+
+	~FakeGateway() {
+		release();
+		join();
+		::close(m_listenFd);
+	}
+
+	int port() const { return m_port; }
+
+	void release() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_isReleased = true;
+		m_released.notify_all();
+	}
+
+	// the messages received, complete once the client has disconnected
+	const std::vector<std::string> &join() {
+		if (m_thread.joinable())
+			m_thread.join();
+
+		return m_msgs;
+	}
+};
+
+#endif
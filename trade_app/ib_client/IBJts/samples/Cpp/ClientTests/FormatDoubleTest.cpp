@@ -0,0 +1,220 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <string.h>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "EClient.h"
+#include "ClientTest.h"
+
+// EClient::EncodeField<double> formats the values it can with integer arithmetic instead of
+// snprintf("%.10g"), which TWS has always been sent. This holds it to snprintf() on a fixed
+// set of values: the edges of the range it handles itself, the rounding ties it must leave to
+// snprintf(), the carry of 9999999999.5 into an 11th digit, and prices on the usual tick grids.
+
+namespace {
+
+long long g_checked = 0;
+int g_reported = 0;
+
+std::string Expected(double value)
+{
+	char str[128];
+	snprintf(str, sizeof(str), "%.10g", value);
+	char *point = strchr(str, ',');
+	if (point)
+		*point = '.';
+	return std::string(str);
+}
+
+void Check(double value)
+{
+	std::ostringstream os;
+	EClient::EncodeFieldMax(os, value);   // EncodeField<double> for anything but DBL_MAX
+	const std::string field = os.str();
+
+	const std::string expected = Expected(value);
+	++g_checked;
+
+	// the field and its terminating 0, nothing else
+	if (field.size() != expected.size() + 1 || field.compare(0, expected.size(), expected) != 0 || field[expected.size()] != 0) {
+		++g_testFailures;
+		if (g_reported++ < 20)
+			fprintf(stderr, "%.17g: encoded \"%s\", snprintf \"%s\"\n", value, field.c_str(), expected.c_str());
+	}
+}
+
+void CheckBothSigns(double value)
+{
+	Check(value);
+	Check(-value);
+}
+
+// a value whose 10 significant digits are digits, plus fraction of a unit in the last place
+double ScaledValue(double digits, double fraction, int exp)
+{
+	return (digits + fraction) / pow(10.0, 9 - exp);
+}
+
+void CheckSpecialValues()
+{
+	Check(0.0);
+	Check(-0.0);
+	Check(INFINITY);
+	Check(-INFINITY);
+	Check(NAN);
+	Check(-DBL_MAX);
+	Check(DBL_MIN);
+	Check(nextafter(0.0, 1.0));
+	CheckBothSigns(1.0);
+	CheckBothSigns(0.1);
+	CheckBothSigns(1.0 / 3);
+	CheckBothSigns(2.0 / 3);
+}
+
+// 1e-4 and 1e10 bound the fast path, every other power of ten changes the digits kept
+void CheckBoundaries()
+{
+	for (int e = -6; e <= 11; ++e) {
+		const double p = pow(10.0, e);
+		CheckBothSigns(p);
+
+		double below = p, above = p;
+		for (int i = 0; i < 200; ++i) {
+			below = nextafter(below, 0);
+			above = nextafter(above, DBL_MAX);
+			CheckBothSigns(below);
+			CheckBothSigns(above);
+		}
+		for (int i = 1; i <= 1000; ++i) {
+			CheckBothSigns(p * (1 - i * 1e-11));
+			CheckBothSigns(p * (1 + i * 1e-11));
+		}
+	}
+}
+
+// the 10 digit integer rounds up past 9999999999: %.10g goes to the next power of ten
+void CheckRoundingOverflow()
+{
+	for (int exp = -4; exp <= 9; ++exp) {
+		CheckBothSigns(ScaledValue(9999999999.0, 0.5, exp));
+		CheckBothSigns(ScaledValue(9999999999.0, 0.9, exp));
+		CheckBothSigns(ScaledValue(9999999999.0, 0.49, exp));
+		CheckBothSigns(ScaledValue(9999999998.0, 0.5, exp));
+	}
+	CheckBothSigns(9999999999.5);
+	CheckBothSigns(9999999999.4999);
+	CheckBothSigns(0.99999999995);
+	CheckBothSigns(0.000099999999995);
+}
+
+// a scaled value within 1e-5 of a tie is left to snprintf(), which rounds the exact binary
+// value; just outside the margin the fast path rounds it itself
+void CheckTies()
+{
+	static const double offsets[] = { 0, 1e-7, -1e-7, 1e-6, -1e-6, 9e-6, -9e-6, 1.1e-5, -1.1e-5, 2e-5, -2e-5, 1e-4, -1e-4 };
+
+	for (int exp = -4; exp <= 9; ++exp) {
+		for (int d = 0; d < 200; ++d) {
+			const double digits = 1000000000.0 + d * 44444443.0;
+			for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i)
+				CheckBothSigns(ScaledValue(digits, 0.5 + offsets[i], exp));
+		}
+	}
+
+	for (int i = 0; i < 100000; ++i) {
+		CheckBothSigns((i * 2 + 1) * 0.5e-10 * pow(10.0, i % 14));
+		CheckBothSigns(12345.678905 + i * 1e-6);
+	}
+}
+
+// prices on tick grids, computed both as k * tick and accumulated the way a strategy steps
+// through a book, and order quantities
+void CheckTickGrids()
+{
+	static const double ticks[] = { 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.2, 0.25, 0.5, 1, 5, 10,
+		1.0 / 32, 1.0 / 64, 1.0 / 128 };
+
+	for (size_t t = 0; t < sizeof(ticks) / sizeof(ticks[0]); ++t) {
+		const double tick = ticks[t];
+		for (int k = 0; k <= 100000; ++k)
+			CheckBothSigns(k * tick);
+
+		const double high = floor(100000 / tick);
+		for (int k = 0; k <= 10000; ++k)
+			Check((high + k) * tick);
+
+		double price = 0;
+		for (int k = 0; k < 100000; ++k) {
+			price += tick;
+			Check(price);
+		}
+	}
+
+	for (int q = 0; q <= 100000; ++q)
+		Check((double)q);
+	for (long long q = 9999990000LL; q <= 10000010000LL; ++q)
+		Check((double)q);
+}
+
+// fixed seed, so every run checks the same values
+void CheckPseudoRandom()
+{
+	std::mt19937_64 rng(20191017);
+
+	for (int i = 0; i < 500000; ++i) {
+		const double e = -20 + 31 * ((rng() >> 11) * (1.0 / 9007199254740992.0));
+		CheckBothSigns(pow(10.0, e));
+	}
+	for (int i = 0; i < 500000; ++i) {
+		const unsigned long long bits = rng();
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		Check(value);
+	}
+}
+
+// TWS wants '.' however the locale writes a decimal point
+void CheckLocale()
+{
+	static const char *locales[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "fr_FR" };
+
+	for (size_t i = 0; i < sizeof(locales) / sizeof(locales[0]); ++i) {
+		if (!setlocale(LC_NUMERIC, locales[i]))
+			continue;
+
+		CheckBothSigns(3e-7);
+		CheckBothSigns(1.5e12);
+		CheckBothSigns(123.45);
+		CheckBothSigns(ScaledValue(1234567890.0, 0.5, 2));
+
+		setlocale(LC_NUMERIC, "C");
+		return;
+	}
+	fprintf(stderr, "FormatDoubleTest: no comma locale installed, decimal point check skipped\n");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	CheckSpecialValues();
+	CheckBoundaries();
+	CheckRoundingOverflow();
+	CheckTies();
+	CheckTickGrids();
+	CheckPseudoRandom();
+	CheckLocale();
+
+	CHECK(g_checked > 0);
+	fprintf(stderr, "FormatDoubleTest: %lld values checked\n", g_checked);
+
+	return TEST_RESULT("FormatDoubleTest");
+}
@@ -0,0 +1,76 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "ClientTest.h"
+
+#include "EMessage.h"
+#include "EMessagePool.h"
+#include "ESpscQueue.h"
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// EMessagePool the way the reader uses it: messages allocated on one thread and freed on
+// another. The freeing thread hands them back to the allocating one without a lock, so most
+// allocations have to be served from the pool, and the counts have to add up once both
+// threads have exited and given their caches back.
+
+namespace {
+
+const int MESSAGES = 200000;
+const size_t QUEUE_SIZE = 1024;
+
+void Produce(ESpscQueue<EMessage*> &queue) {
+	const std::vector<char> data(16, 'x');
+
+	for (int i = 0; i < MESSAGES; ++i) {
+		EMessage *msg = new EMessage(data);
+
+		while (!queue.tryPush(msg))
+			std::this_thread::yield();
+	}
+}
+
+void Consume(ESpscQueue<EMessage*> &queue) {
+	for (int i = 0; i < MESSAGES; ++i) {
+		EMessage *msg = 0;
+
+		while (!queue.tryPop(msg))
+			std::this_thread::yield();
+
+		delete msg;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const EMessagePoolStats before = EMessagePool::instance().messageStats();
+	ESpscQueue<EMessage*> queue(QUEUE_SIZE);
+
+	std::thread producer(Produce, std::ref(queue));
+	std::thread consumer(Consume, std::ref(queue));
+
+	producer.join();
+	consumer.join();
+
+	const EMessagePoolStats after = EMessagePool::instance().messageStats();
+	const unsigned long long hits = after.hits - before.hits;
+	const unsigned long long misses = after.misses - before.misses;
+
+	CHECK(hits + misses == (unsigned long long)MESSAGES);
+	CHECK(hits > misses);
+	CHECK(after.inUse == before.inUse);
+	CHECK(after.highWater > 0);
+	CHECK(after.highWater <= (size_t)MESSAGES);
+
+	fprintf(stderr, "MessagePoolTest: %llu hits, %llu misses, high water %lu\n", hits, misses, (unsigned long)after.highWater);
+
+	EMessagePool::instance().trim();
+	CHECK(EMessagePool::instance().messageStats().inUse == before.inUse);
+
+	return TEST_RESULT("MessagePoolTest");
+}
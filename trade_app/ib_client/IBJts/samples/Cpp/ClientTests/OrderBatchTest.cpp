@@ -0,0 +1,198 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "ClientTest.h"
+#include "FakeGateway.h"
+
+#include "DefaultEWrapper.h"
+#include "EClientSocket.h"
+#include "EOrderRequest.h"
+#include "SocketOptions.h"
+#include "Contract.h"
+#include "Order.h"
+
+#include <chrono>
+#include <signal.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// EClient::placeOrders() and cancelOrders() status reporting. A batch larger than both socket
+// buffers, to a gateway that does not read, is only partly written: every request stays SENT
+// and the rest goes out once the gateway reads again. A batch flushed into a reset connection
+// is FAILED, one issued while disconnected REJECTED.
+
+namespace {
+
+const int BATCH_SIZE = 2000;
+const int SMALL_BUFFER = 4096;
+
+class ErrorWrapper : public DefaultEWrapper
+{
+public:
+	std::vector<int> m_errorCodes;
+
+	void error(int id, int errorCode, const std::string& errorString) {
+		m_errorCodes.push_back(errorCode);
+	}
+};
+
+Contract TestContract() {
+	Contract contract;
+
+	contract.symbol = "ES";
+	contract.secType = "FUT";
+	contract.lastTradeDateOrContractMonth = "20261218";
+	contract.exchange = "CME";
+	contract.currency = "USD";
+
+	return contract;
+}
+
+Order TestOrder() {
+	Order order;
+
+	order.action = "BUY";
+	order.orderType = "LMT";
+	order.totalQuantity = 1;
+	order.lmtPrice = 4012.25;
+
+	return order;
+}
+
+bool Connect(EClientSocket &client, const FakeGateway &gateway) {
+	SocketOptions options;
+
+	options.sndBuf = SMALL_BUFFER;
+
+	return gateway.port() != 0 && client.eConnect("127.0.0.1", gateway.port(), 0, false, options);
+}
+
+int CountMessages(const std::vector<std::string> &msgs, const char *msgId) {
+	int count = 0;
+
+	// the message id is the first field
+	for (size_t i = 0; i < msgs.size(); ++i) {
+		if (strcmp(msgs[i].c_str(), msgId) == 0)
+			++count;
+	}
+
+	return count;
+}
+
+int CountStatus(const std::vector<OrderRequest> &requests, OrderRequestStatus status) {
+	int count = 0;
+
+	for (size_t i = 0; i < requests.size(); ++i) {
+		if (requests[i].status == status)
+			++count;
+	}
+
+	return count;
+}
+
+void CheckShortSend() {
+	FakeGateway gateway(FakeGateway::HOLD, SMALL_BUFFER);
+	ErrorWrapper wrapper;
+	EClientSocket client(&wrapper);
+
+	if (!Connect(client, gateway)) {
+		CHECK(!"connected to the fake gateway");
+		return;
+	}
+
+	const Contract contract = TestContract();
+	const Order order = TestOrder();
+	std::vector<OrderRequest> places, cancels;
+
+	for (int i = 0; i < 2 * BATCH_SIZE; ++i)
+		places.push_back(OrderRequest(i + 1, contract, order));
+	for (int i = 0; i < BATCH_SIZE; ++i)
+		cancels.push_back(OrderRequest(i + 1));
+
+	// far more than the socket buffers hold while the gateway does not read: a short write
+	CHECK(client.placeOrders(&places[0], BATCH_SIZE) == BATCH_SIZE);
+	CHECK(client.isConnected());
+	CHECK(!client.getTransport()->isOutBufferEmpty());
+
+	// with the socket about full, these get little or nothing written: EWOULDBLOCK
+	CHECK(client.placeOrders(&places[BATCH_SIZE], BATCH_SIZE) == BATCH_SIZE);
+	CHECK(CountStatus(places, ORDER_REQUEST_SENT) == 2 * BATCH_SIZE);
+	CHECK(client.isConnected());
+
+	CHECK(client.cancelOrders(&cancels[0], cancels.size()) == BATCH_SIZE);
+	CHECK(CountStatus(cancels, ORDER_REQUEST_SENT) == BATCH_SIZE);
+	CHECK(client.isConnected());
+
+	// what the socket did not take goes out once the gateway reads again
+	gateway.release();
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+	while (!client.getTransport()->isOutBufferEmpty() && std::chrono::steady_clock::now() < deadline) {
+		client.onSend();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	CHECK(client.getTransport()->isOutBufferEmpty());
+	CHECK(client.isConnected());
+	CHECK(wrapper.m_errorCodes.empty());
+
+	client.eDisconnect();
+
+	const std::vector<std::string> &msgs = gateway.join();
+
+	// startApi, then every order and every cancel
+	CHECK(msgs.size() == 1 + 3 * (size_t)BATCH_SIZE);
+	CHECK(CountMessages(msgs, "3") == 2 * BATCH_SIZE);
+	CHECK(CountMessages(msgs, "4") == BATCH_SIZE);
+}
+
+void CheckConnectionLost() {
+	FakeGateway gateway(FakeGateway::RESET);
+	ErrorWrapper wrapper;
+	EClientSocket client(&wrapper);
+
+	if (!Connect(client, gateway)) {
+		CHECK(!"connected to the fake gateway");
+		return;
+	}
+
+	gateway.release();
+	gateway.join();
+
+	// let the reset arrive before the batch is flushed
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	const Contract contract = TestContract();
+	const Order order = TestOrder();
+	std::vector<OrderRequest> places(3, OrderRequest(0, contract, order));
+
+	for (size_t i = 0; i < places.size(); ++i)
+		places[i].orderId = i + 1;
+
+	CHECK(client.placeOrders(&places[0], places.size()) == 0);
+	CHECK(CountStatus(places, ORDER_REQUEST_FAILED) == (int)places.size());
+	CHECK(!client.isConnected());
+	CHECK(!wrapper.m_errorCodes.empty());
+
+	// nothing is encoded once disconnected
+	std::vector<OrderRequest> cancels(2, OrderRequest(1));
+
+	CHECK(client.cancelOrders(&cancels[0], cancels.size()) == 0);
+	CHECK(CountStatus(cancels, ORDER_REQUEST_REJECTED) == (int)cancels.size());
+}
+
+}
+
+int main(int argc, char **argv) {
+	// a send into the reset connection must fail with EPIPE, not end the test
+	signal(SIGPIPE, SIG_IGN);
+
+	CheckShortSend();
+	CheckConnectionLost();
+
+	return TEST_RESULT("OrderBatchTest");
+}
@@ -0,0 +1,210 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "ClientTest.h"
+
+#include "EDecoder.h"
+#include "EOrderDecoder.h"
+#include "Contract.h"
+#include "Order.h"
+#include "OrderState.h"
+#include "OrderCondition.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// EOrderDecoder::summarizeOpenOrder() and summarizeCompletedOrder() step over the fields
+// decodeOpenOrder() and decodeCompletedOrder() decode, by count. This decodes OPEN_ORDER and
+// COMPLETED_ORDER bodies both ways at server and message versions on both sides of each check
+// they make, and needs the same end of message and the same OrderSummary fields from both.
+//
+// Every field of the body is "1.<position>": 1 as a count, flag or id, a price that tells the
+// fields apart, a string that is not empty. Each field in turn is then replaced by values that
+// switch the optional groups: empty, zero and negative counts, a scale price increment that is
+// not positive, a PEG BENCH order type.
+
+namespace {
+
+const int BODY_FIELDS = 400;
+const char *const MUTATIONS[] = { "", "0", "2", "-1", "3.25", "PEG BENCH" };
+
+// every server version the decoders check, with the one before it
+const int SERVER_VERSIONS[] = { 50, MIN_SERVER_VER_SSHORTX_OLD, 52, 100, MIN_SERVER_VER_FRACTIONAL_POSITIONS,
+	MIN_SERVER_VER_PEGGED_TO_BENCHMARK, MIN_SERVER_VER_MODELS_SUPPORT, 105, MIN_SERVER_VER_SOFT_DOLLAR_TIER,
+	110, MIN_SERVER_VER_CASH_QTY, 140, MIN_SERVER_VER_AUTO_PRICE_FOR_HEDGE, MIN_SERVER_VER_WHAT_IF_EXT_FIELDS,
+	144, MIN_SERVER_VER_ORDER_CONTAINER, 147, MIN_SERVER_VER_D_PEG_ORDERS, 150, MIN_SERVER_VER_PRICE_MGMT_ALGO,
+	MAX_CLIENT_VER };
+
+// OPEN_ORDER carries its own version below MIN_SERVER_VER_ORDER_CONTAINER, checked from 20 to 34
+const int FIRST_MESSAGE_VERSION = 19;
+const int LAST_MESSAGE_VERSION = 34;
+
+long long g_checked = 0;
+long long g_resized = 0;
+int g_reported = 0;
+
+std::string Body(const std::vector<std::string> &fields) {
+	std::string body;
+
+	for (size_t i = 0; i < fields.size(); ++i) {
+		body += fields[i];
+		body += '\0';
+	}
+
+	return body;
+}
+
+void Report(const char *what, bool completed, int serverVersion, int version, int position, const char *value) {
+	++g_testFailures;
+
+	if (g_reported++ < 20)
+		fprintf(stderr, "%s order, server version %d, version %d, field %d = \"%s\": %s differs\n",
+			completed ? "completed" : "open", serverVersion, version, position, value, what);
+}
+
+#define CHECK_SAME(what, cond) if (!(cond)) Report(what, completed, serverVersion, version, position, value)
+
+// how many bytes the full decode consumed, 0 if the summary failed
+size_t Check(const std::vector<std::string> &fields, bool completed, int serverVersion, int version, int position, const char *value) {
+	const std::string body = Body(fields);
+	const char *begin = body.data();
+	const char *endPtr = begin + body.size();
+
+	Contract contract;
+	Order order;
+	OrderState orderState;
+	EOrderDecoder decoder(&contract, &order, &orderState, version, serverVersion);
+	const char *ptr = begin;
+
+	if (completed)
+		decoder.decodeCompletedOrder(ptr, endPtr);
+	else
+		decoder.decodeOpenOrder(ptr, endPtr);
+
+	OrderSummary summary;
+	const char *summaryPtr = begin;
+	bool summarized = completed
+		? EOrderDecoder(0, 0, 0, version, serverVersion).summarizeCompletedOrder(summary, summaryPtr, endPtr)
+		: EOrderDecoder(0, 0, 0, version, serverVersion).summarizeOpenOrder(summary, summaryPtr, endPtr);
+
+	++g_checked;
+
+	if (!summarized)
+		return 0;
+
+	CHECK_SAME("end of message", summaryPtr == ptr);
+	CHECK_SAME("message length", ptr < endPtr);
+	CHECK_SAME("orderId", summary.orderId == (completed ? 0 : order.orderId));
+	CHECK_SAME("conId", summary.conId == contract.conId);
+	CHECK_SAME("permId", summary.permId == order.permId);
+	CHECK_SAME("clientId", summary.clientId == (completed ? 0 : order.clientId));
+	CHECK_SAME("parentId", summary.parentId == (completed ? 0 : order.parentId));
+	CHECK_SAME("action", summary.action == order.action.c_str());
+	CHECK_SAME("orderType", summary.orderType == order.orderType.c_str());
+	CHECK_SAME("totalQuantity", summary.totalQuantity == order.totalQuantity);
+	CHECK_SAME("filledQuantity", summary.filledQuantity == (completed ? order.filledQuantity : UNSET_DOUBLE));
+	CHECK_SAME("lmtPrice", summary.lmtPrice == order.lmtPrice);
+	CHECK_SAME("auxPrice", summary.auxPrice == order.auxPrice);
+	CHECK_SAME("status", summary.status == orderState.status.c_str());
+
+	return ptr - begin;
+}
+
+// whether the full decode reads the field at position as a condition type: as 3 it makes a
+// time condition, where every field of the unmutated body makes price conditions
+bool IsConditionType(std::vector<std::string> fields, bool completed, int serverVersion, int version, int position) {
+	fields[position] = "3";
+
+	const std::string body = Body(fields);
+	const char *ptr = body.data();
+
+	Contract contract;
+	Order order;
+	OrderState orderState;
+	EOrderDecoder decoder(&contract, &order, &orderState, version, serverVersion);
+
+	if (completed)
+		decoder.decodeCompletedOrder(ptr, body.data() + body.size());
+	else
+		decoder.decodeOpenOrder(ptr, body.data() + body.size());
+
+	for (size_t i = 0; i < order.conditions.size(); ++i) {
+		if (order.conditions[i]->type() == OrderCondition::Time)
+			return true;
+	}
+
+	return false;
+}
+
+void CheckVersion(bool completed, int serverVersion, int version) {
+	std::vector<std::string> fields;
+	char field[32];
+
+	for (int i = 0; i < BODY_FIELDS; ++i) {
+		snprintf(field, sizeof(field), "1.%04d", i + 1);
+		fields.push_back(field);
+	}
+
+	const size_t length = Check(fields, completed, serverVersion, version, -1, "");
+
+	if (!length) {
+		Report("summary", completed, serverVersion, version, -1, "");
+		return;
+	}
+
+	// the fields the full decode consumed, and the one after them
+	const int consumed = (int)(length / (fields[0].size() + 1));
+
+	for (int position = 0; position <= consumed; ++position) {
+		const std::string original = fields[position];
+
+		for (size_t i = 0; i < sizeof(MUTATIONS) / sizeof(MUTATIONS[0]); ++i) {
+			const char *value = MUTATIONS[i];
+
+			fields[position] = value;
+
+			const size_t mutated = Check(fields, completed, serverVersion, version, position, value);
+
+			// both decoders give up on a condition type the API does not know, nothing else
+			if (!mutated) {
+				CHECK_SAME("summary", IsConditionType(fields, completed, serverVersion, version, position));
+				continue;
+			}
+
+			// a shorter field consumed makes a shorter body, anything else switched a group
+			const size_t expected = position < consumed ? length - original.size() + fields[position].size() : length;
+
+			if (mutated != expected)
+				++g_resized;
+		}
+
+		fields[position] = original;
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	for (size_t s = 0; s < sizeof(SERVER_VERSIONS) / sizeof(SERVER_VERSIONS[0]); ++s) {
+		const int serverVersion = SERVER_VERSIONS[s];
+
+		CheckVersion(true, serverVersion, UNSET_INTEGER);
+
+		if (serverVersion >= MIN_SERVER_VER_ORDER_CONTAINER) {
+			CheckVersion(false, serverVersion, serverVersion);
+			continue;
+		}
+
+		for (int version = FIRST_MESSAGE_VERSION; version <= LAST_MESSAGE_VERSION; ++version)
+			CheckVersion(false, serverVersion, version);
+	}
+
+	// the mutations did switch optional groups on and off
+	CHECK(g_resized > 0);
+	fprintf(stderr, "OrderSummaryTest: %lld bodies checked, %lld changed length\n", g_checked, g_resized);
+
+	return TEST_RESULT("OrderSummaryTest");
+}
@@ -0,0 +1,102 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "ClientTest.h"
+#include "FakeGateway.h"
+
+#include "DefaultEWrapper.h"
+#include "EClientSocket.h"
+#include "EMessage.h"
+#include "EReader.h"
+#include "EReaderOSSignal.h"
+#include "SocketOptions.h"
+
+#include <chrono>
+#include <stdio.h>
+
+// EReader::msgReceiveTime() is on steady_clock whether the kernel stamped the read
+// (SO_TIMESTAMPNS, CLOCK_REALTIME) or the client did: a reply has to have arrived between
+// the request and the callback, on the caller's steady_clock.
+
+namespace {
+
+const int WAIT_MS = 5000;
+const unsigned long SIGNAL_WAIT_MS = 100;
+
+long long SteadyNanos() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class TimeWrapper : public DefaultEWrapper
+{
+public:
+	EReader *m_pReader;
+	bool m_received;
+	EReceiveTime m_receiveTime;
+	long long m_callbackNanos;
+
+	TimeWrapper() : m_pReader(0), m_received(false), m_callbackNanos(0) {}
+
+	void currentTime(long time) {
+		m_callbackNanos = SteadyNanos();
+		m_receiveTime = m_pReader->msgReceiveTime();
+		m_received = true;
+	}
+};
+
+void CheckReceiveTime(bool rxTimestamps) {
+	FakeGateway gateway;
+	TimeWrapper wrapper;
+	EReaderOSSignal signal(SIGNAL_WAIT_MS);
+	EClientSocket client(&wrapper, &signal);
+	SocketOptions options;
+
+	options.rxTimestamps = rxTimestamps;
+
+	if (gateway.port() == 0 || !client.eConnect("127.0.0.1", gateway.port(), 0, false, options)) {
+		CHECK(!"connected to the fake gateway");
+		return;
+	}
+
+	EReader reader(&client, &signal);
+
+	wrapper.m_pReader = &reader;
+	reader.start();
+
+	const long long requestNanos = SteadyNanos();
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(WAIT_MS);
+
+	client.reqCurrentTime();
+
+	while (!wrapper.m_received && client.isConnected() && std::chrono::steady_clock::now() < deadline) {
+		signal.waitForSignal();
+		reader.processMsgs();
+	}
+
+	CHECK(wrapper.m_received);
+
+	if (wrapper.m_received) {
+		// stamped by the kernel only if it was asked to and the socket took the option
+		CHECK(wrapper.m_receiveTime.kernel == client.effectiveSocketOptions().rxTimestamps);
+		CHECK(wrapper.m_receiveTime.nanos >= requestNanos);
+		CHECK(wrapper.m_receiveTime.nanos <= wrapper.m_callbackNanos);
+
+		if (wrapper.m_receiveTime.nanos < requestNanos || wrapper.m_receiveTime.nanos > wrapper.m_callbackNanos)
+			fprintf(stderr, "kernel %d: received at %lld, requested at %lld, callback at %lld\n", wrapper.m_receiveTime.kernel,
+				wrapper.m_receiveTime.nanos, requestNanos, wrapper.m_callbackNanos);
+	}
+
+	client.eDisconnect();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	CheckReceiveTime(true);
+	CheckReceiveTime(false);
+
+	return TEST_RESULT("ReceiveTimeTest");
+}
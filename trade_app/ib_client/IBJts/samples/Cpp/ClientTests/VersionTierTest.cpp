@@ -0,0 +1,271 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "ClientTest.h"
+#include "FakeGateway.h"
+
+#include "DefaultEWrapper.h"
+#include "EClientSocket.h"
+#include "EDecoder.h"
+#include "EOrderTemplate.h"
+#include "EVersionTier.h"
+#include "Contract.h"
+#include "Order.h"
+#include "Execution.h"
+#include "ContractSamples.h"
+#include "OrderSamples.h"
+#include "AvailableAlgoParams.h"
+#include "PriceCondition.h"
+#include "TimeCondition.h"
+#include "VolumeCondition.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Writes what a client at MAX_CLIENT_VER sends for a fixed set of orders, and what EDecoder
+// makes of the six messages it decodes through a version tier, one line per message. The
+// makefile builds it twice, as is and with IBAPI_NO_VERSION_TIERS, so the transcripts come
+// from the EVersionLatest and the EVersionAny instantiations and have to match byte for byte.
+
+namespace {
+
+void PrintFields(FILE *out, const char *tag, const char *begin, const char *end) {
+	fprintf(out, "%s ", tag);
+
+	for (const char *p = begin; p != end; ++p)
+		fputc(*p ? *p : '|', out);
+
+	fputc('\n', out);
+}
+
+// records the callbacks of the decoded messages, doubles with every digit
+class TranscriptWrapper : public DefaultEWrapper
+{
+	FILE *m_out;
+
+public:
+	explicit TranscriptWrapper(FILE *out) : m_out(out) {}
+
+	void tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attrib) {
+		fprintf(m_out, "tickPrice %ld %d %.17g %d%d%d\n", tickerId, (int)field, price,
+			attrib.canAutoExecute, attrib.pastLimit, attrib.preOpen);
+	}
+
+	void tickSize(TickerId tickerId, TickType field, int size) {
+		fprintf(m_out, "tickSize %ld %d %d\n", tickerId, (int)field, size);
+	}
+
+	void orderStatus(OrderId orderId, const std::string& status, double filled, double remaining, double avgFillPrice,
+		int permId, int parentId, double lastFillPrice, int clientId, const std::string& whyHeld, double mktCapPrice) {
+		fprintf(m_out, "orderStatus %ld %s %.17g %.17g %.17g %d %d %.17g %d %s %.17g\n", orderId, status.c_str(),
+			filled, remaining, avgFillPrice, permId, parentId, lastFillPrice, clientId, whyHeld.c_str(), mktCapPrice);
+	}
+
+	void execDetails(int reqId, const Contract& contract, const Execution& execution) {
+		fprintf(m_out, "execDetails %d %ld %s %s %s %.17g %s %s %s %s %s %s %s %s %s %s %s %.17g %.17g %ld %ld %d"
+			" %.17g %.17g %s %s %.17g %s %d\n",
+			reqId, contract.conId, contract.symbol.c_str(), contract.secType.c_str(), contract.lastTradeDateOrContractMonth.c_str(),
+			contract.strike, contract.right.c_str(), contract.multiplier.c_str(), contract.exchange.c_str(), contract.currency.c_str(),
+			contract.localSymbol.c_str(), contract.tradingClass.c_str(), execution.execId.c_str(), execution.time.c_str(),
+			execution.acctNumber.c_str(), execution.exchange.c_str(), execution.side.c_str(), execution.shares, execution.price,
+			(long)execution.permId, (long)execution.clientId, execution.liquidation, execution.cumQty, execution.avgPrice,
+			execution.orderRef.c_str(), execution.evRule.c_str(), execution.evMultiplier, execution.modelCode.c_str(),
+			execution.lastLiquidity);
+	}
+
+	void updateMktDepthL2(TickerId id, int position, const std::string& marketMaker, int operation,
+		int side, double price, int size, bool isSmartDepth) {
+		fprintf(m_out, "updateMktDepthL2 %ld %d %s %d %d %.17g %d %d\n", id, position, marketMaker.c_str(),
+			operation, side, price, size, isSmartDepth);
+	}
+
+	void pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) {
+		fprintf(m_out, "pnl %d %.17g %.17g %.17g\n", reqId, dailyPnL, unrealizedPnL, realizedPnL);
+	}
+
+	void pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {
+		fprintf(m_out, "pnlSingle %d %d %.17g %.17g %.17g %.17g\n", reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
+	}
+
+	void error(int id, int errorCode, const std::string& errorString) {
+		fprintf(m_out, "error %d %d %s\n", id, errorCode, errorString.c_str());
+	}
+};
+
+std::vector<Order> TestOrders() {
+	std::vector<Order> orders;
+
+	orders.push_back(OrderSamples::MarketOrder("BUY", 1));
+	orders.push_back(OrderSamples::LimitOrder("SELL", 2.5, 101.25));
+	orders.push_back(OrderSamples::StopLimit("BUY", 3, 99.5, 99.75));
+	orders.push_back(OrderSamples::TrailingStopLimit("SELL", 1, 0.5, 0.25, 100));
+	orders.push_back(OrderSamples::PeggedToBenchmark("BUY", 100, 33, true, 0.1, 0.2, 12345, "ISLAND", 33, 3, 4));
+	orders.push_back(OrderSamples::Volatility("SELL", 5, 5, 2));
+	orders.push_back(OrderSamples::ComboLimitOrder("BUY", 1, 1.1, false));
+	orders.push_back(OrderSamples::LimitOrderForComboWithLegPrices("BUY", 1, std::vector<double>(2, 10.5), true));
+	orders.push_back(OrderSamples::RelativePeggedToPrimary("BUY", 1, 2, 0.01));
+	orders.push_back(OrderSamples::LimitOrderWithCashQty("BUY", 1, 30, 5000));
+	orders.push_back(OrderSamples::WhatIfLimitOrder("BUY", 2, 20));
+	orders.push_back(OrderSamples::MarketFHedge(1, "BUY"));
+	orders.push_back(OrderSamples::AuctionPeggedToStock("BUY", 1, 2, 0.1));
+	orders.push_back(OrderSamples::Discretionary("SELL", 1, 45, 0.5));
+
+	Order conditional = OrderSamples::LimitOrder("BUY", 1, 10);
+	conditional.conditions.push_back(std::shared_ptr<OrderCondition>(OrderSamples::Price_Condition(208813720, "SMART", 600, false, false)));
+	conditional.conditions.push_back(std::shared_ptr<OrderCondition>(OrderSamples::Time_Condition("20260101 12:00:00", true, false)));
+	conditional.conditions.push_back(std::shared_ptr<OrderCondition>(OrderSamples::Volume_Condition(208813720, "SMART", false, 100, true)));
+	orders.push_back(conditional);
+
+	Order adaptive = OrderSamples::LimitOrder("BUY", 1, 10);
+	AvailableAlgoParams::FillAdaptiveParams(adaptive, "Normal");
+	orders.push_back(adaptive);
+
+	Order vwap = OrderSamples::LimitOrder("BUY", 1, 10);
+	AvailableAlgoParams::FillVwapParams(vwap, 0.2, "09:00:00 CET", "16:00:00 CET", true, true, true, 100000);
+	orders.push_back(vwap);
+
+	Order misc = OrderSamples::LimitOrder("BUY", 1, 10);
+	misc.notHeld = true;
+	misc.softDollarTier = SoftDollarTier("a", "b", "c");
+	misc.mifid2DecisionMaker = "dm";
+	misc.extOperator = "op";
+	misc.dontUseAutoPriceForHedge = true;
+	misc.isOmsContainer = true;
+	misc.modelCode = "m";
+	misc.usePriceMgmtAlgo = (UsePriceMmgtAlgo)1;
+	orders.push_back(misc);
+
+	return orders;
+}
+
+std::vector<Contract> TestContracts() {
+	std::vector<Contract> contracts;
+
+	contracts.push_back(ContractSamples::USStockAtSmart());
+	contracts.push_back(ContractSamples::SimpleFuture());
+	contracts.push_back(ContractSamples::OptionComboContract());
+	contracts.push_back(ContractSamples::StockComboContract());
+	contracts.push_back(ContractSamples::EurGbpFx());
+	contracts.push_back(ContractSamples::BondWithCusip());
+
+	return contracts;
+}
+
+void EncodeOrders(FILE *out) {
+	FakeGateway gateway;
+	TranscriptWrapper wrapper(out);
+	EClientSocket client(&wrapper);
+
+	CHECK(gateway.port() != 0);
+
+	if (!client.eConnect("127.0.0.1", gateway.port(), 0)) {
+		CHECK(!"connected to the fake gateway");
+		return;
+	}
+
+	CHECK(client.EClient::serverVersion() == MAX_CLIENT_VER);
+
+	std::vector<Order> orders = TestOrders();
+	std::vector<Contract> contracts = TestContracts();
+	OrderId id = 1;
+
+	for (size_t i = 0; i < orders.size(); ++i)
+		for (size_t j = 0; j < contracts.size(); ++j)
+			client.placeOrder(id++, contracts[j], orders[i]);
+
+	DeltaNeutralContract deltaNeutral;
+	deltaNeutral.conId = 1;
+	deltaNeutral.delta = 0.5;
+	deltaNeutral.price = 10;
+
+	Contract hedged = ContractSamples::USStockAtSmart();
+	hedged.deltaNeutralContract = &deltaNeutral;
+	client.placeOrder(id++, hedged, orders[1]);
+
+	// the template path encodes through the same instantiation
+	EOrderTemplate tmpl;
+	CHECK(client.prepareOrder(tmpl, contracts[1], orders[1]));
+	client.placeOrder(tmpl, id++, 7, 99.25);
+
+	while (!client.getTransport()->isOutBufferEmpty())
+		client.onSend();
+
+	client.eDisconnect();
+
+	const std::vector<std::string> &msgs = gateway.join();
+
+	// startApi, every placeOrder() above and the template
+	CHECK(msgs.size() == 1 + orders.size() * contracts.size() + 2);
+
+	for (size_t i = 0; i < msgs.size(); ++i)
+		PrintFields(out, "send", msgs[i].data(), msgs[i].data() + msgs[i].size());
+}
+
+std::string Message(const char *const *fields, size_t count) {
+	std::string msg;
+
+	for (size_t i = 0; i < count; ++i) {
+		msg += fields[i];
+		msg += '\0';
+	}
+
+	return msg;
+}
+
+void DecodeMessages(FILE *out) {
+	// the field layouts a server at MAX_CLIENT_VER sends
+	static const char *const tickPrice[] = { "1", "6", "1001", "1", "4012.25", "17", "7" };
+	static const char *const orderStatus[] = { "3", "42", "Filled", "3.5", "0", "101.125", "1234567", "0", "101.25",
+		"7", "", "101.5" };
+	static const char *const execDetails[] = { "11", "9", "42", "495512551", "ES", "FUT", "20261218", "0", "", "50",
+		"CME", "USD", "ESZ6", "ES", "0000e0d5.6540e9a2.01.01", "20260101  09:30:00", "DU123", "CME", "BOT", "3.5",
+		"4012.25", "1234567", "7", "0", "3.5", "4012.25", "ref", "", "1.7976931348623157E308", "model", "2" };
+	static const char *const mktDepthL2[] = { "13", "1", "1002", "3", "NSDQ", "1", "0", "4012.5", "25", "1" };
+	static const char *const pnl[] = { "94", "1003", "-125.5", "250.25", "1.7976931348623157E308" };
+	static const char *const pnlSingle[] = { "95", "1004", "3", "12.5", "-7.25", "0.125", "12037.75" };
+
+	const std::string msgs[] = {
+		Message(tickPrice, sizeof(tickPrice) / sizeof(tickPrice[0])),
+		Message(orderStatus, sizeof(orderStatus) / sizeof(orderStatus[0])),
+		Message(execDetails, sizeof(execDetails) / sizeof(execDetails[0])),
+		Message(mktDepthL2, sizeof(mktDepthL2) / sizeof(mktDepthL2[0])),
+		Message(pnl, sizeof(pnl) / sizeof(pnl[0])),
+		Message(pnlSingle, sizeof(pnlSingle) / sizeof(pnlSingle[0])),
+	};
+
+	TranscriptWrapper wrapper(out);
+	EDecoder decoder(MAX_CLIENT_VER, &wrapper);
+
+	for (size_t i = 0; i < sizeof(msgs) / sizeof(msgs[0]); ++i) {
+		const char *begin = msgs[i].data();
+		const char *end = begin + msgs[i].size();
+
+		PrintFields(out, "recv", begin, end);
+
+		// a field read or skipped by one tier only would show up here first
+		CHECK(decoder.parseAndProcessMsg(begin, end) == (int)msgs[i].size());
+	}
+}
+
+}
+
+int main(int argc, char **argv) {
+	FILE *out = argc > 1 ? fopen(argv[1], "w") : stdout;
+
+	if (!out) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	fprintf(out, "server version %d\n", MAX_CLIENT_VER);
+
+	EncodeOrders(out);
+	DecodeMessages(out);
+
+	if (out != stdout)
+		fclose(out);
+
+	return TEST_RESULT(IsLatestVersion(MAX_CLIENT_VER) ? "VersionTierTest (EVersionLatest)" : "VersionTierTest (EVersionAny)");
+}
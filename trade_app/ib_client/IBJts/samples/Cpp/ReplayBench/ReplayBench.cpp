@@ -0,0 +1,677 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+
+#include "DefaultEWrapper.h"
+#include "EClientSocket.h"
+#include "EReader.h"
+#include "EReaderOSSignal.h"
+#include "ERecvBuffer.h"
+#include "EIoUring.h"
+#include "SocketOptions.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// Replays one gateway stream into EReader and reports what its receive path costs. The
+// makefile builds this file three times, with the select(), epoll and io_uring receive paths,
+// and `make bench` runs the three on the same stream file.
+//
+// The stream is a recording of what a gateway sends after the handshake: v100 frames, each a
+// 4 byte big-endian length and its fields. Without -r a deterministic one is generated, shaped
+// like a busy market data session: tick-by-tick bid/ask, tick price and size, L2 depth and now
+// and then a long error notice. -w writes it out, so every build replays exactly the same bytes.
+//
+// Each mode runs two phases, each on a fresh connection to a gateway forked off on loopback:
+// - throughput: the stream as fast as the socket takes it, best of -k rounds; wall time, and
+//   the CPU the client process used per MB (the gateway runs in its own process, so that is
+//   EReader alone)
+// - latency: the stream paced in bursts, each followed by a probe stamped with CLOCK_MONOTONIC
+//   right before it is sent; percentiles of send-to-callback time of the probes
+//
+// The io_uring build adds the cost of the copy its receive path makes that the socket paths do
+// not: EIoUring::read() copies each received chunk out of the provided buffer into ERecvBuffer,
+// where recv() writes into ERecvBuffer directly. That copy is timed on its own over the stream
+// and set against the CPU per MB of the throughput phase.
+
+namespace {
+
+#if defined(IBAPI_IO_URING)
+const char *const RECV_PATH = "uring";
+#elif defined(IBAPI_EPOLL)
+const char *const RECV_PATH = "epoll";
+#else
+const char *const RECV_PATH = "select";
+#endif
+
+const char *const SERVER_TIME = "20260101 00:00:00 EST";
+
+// tickString ticker id of the latency probes, the value is the send time in nanoseconds
+const int PROBE_TICKER_ID = 999999;
+const int TICK_STRING = 46;
+
+// what EReader.cpp reads with: its default read window and the io_uring provided buffer size
+const size_t READ_WINDOW = 8192;
+const size_t URING_BUF_SIZE = READ_WINDOW * 2;
+
+struct Options
+{
+	Options() : messages(500000), chunk(65536), burst(16), intervalUs(100), bursts(10000), rounds(5), rxTimestamps(true) {}
+
+	std::string readFile;
+	std::string writeFile;
+	std::vector<std::string> modes;
+	int messages;       // generated stream length
+	size_t chunk;       // throughput phase send size
+	int burst;          // latency phase frames per burst
+	int intervalUs;     // latency phase pause between bursts
+	int bursts;         // latency phase bursts replayed, from the start of the stream
+	int rounds;         // throughput phase and copy timing repetitions, the fastest counts
+	bool rxTimestamps;
+};
+
+long long MonotonicNanos()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+double CpuSeconds()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// -------------------------------------------------------------------------------------------
+// the stream
+
+class Stream
+{
+	std::string m_data;
+	std::vector<size_t> m_frameEnds;
+
+	bool index() {
+		m_frameEnds.clear();
+
+		for (size_t pos = 0; pos < m_data.size(); ) {
+			if (m_data.size() - pos < 4)
+				return false;
+
+			const unsigned char *p = (const unsigned char *)m_data.data() + pos;
+			pos += 4 + (((size_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+
+			if (pos > m_data.size())
+				return false;
+
+			m_frameEnds.push_back(pos);
+		}
+
+		return !m_frameEnds.empty();
+	}
+
+public:
+	static std::string Frame(const std::vector<std::string> &fields) {
+		std::string body;
+
+		for (size_t i = 0; i < fields.size(); ++i) {
+			body += fields[i];
+			body += '\0';
+		}
+
+		std::string frame(4, '\0');
+
+		frame[0] = (char)(body.size() >> 24);
+		frame[1] = (char)(body.size() >> 16);
+		frame[2] = (char)(body.size() >> 8);
+		frame[3] = (char)body.size();
+
+		return frame + body;
+	}
+
+	void generate(int messages) {
+		std::mt19937 rng(1);
+		char price[32], ask[32];
+
+		m_data = Frame({ "9", "1", "1" });   // nextValidId
+
+		for (int i = 0; i < messages; ++i) {
+			const double bid = 4000 + (i % 4000) * 0.25;
+			const std::string reqId = std::to_string(1000 + i % 4);
+			snprintf(price, sizeof(price), "%.2f", bid);
+			snprintf(ask, sizeof(ask), "%.2f", bid + 0.25);
+
+			switch (rng() % 16) {
+			case 0:
+			case 1:
+				m_data += Frame({ "1", "6", reqId, "1", price, std::to_string(rng() % 200 + 1), "3" });   // tickPrice
+				break;
+			case 2:
+				m_data += Frame({ "2", "6", reqId, "8", std::to_string(rng() % 100000) });   // tickSize
+				break;
+			case 3:
+			case 4:
+			case 5:
+				m_data += Frame({ "13", "1", reqId, std::to_string(rng() % 10), "ARCA", std::to_string(rng() % 3),
+					std::to_string(rng() % 2), price, std::to_string(rng() % 500 + 1), "1" });   // updateMktDepthL2
+				break;
+			default:
+				m_data += Frame({ "99", reqId, "3", "1700000000", price, ask, std::to_string(rng() % 50 + 1),
+					std::to_string(rng() % 50 + 1), "0" });   // tickByTickBidAsk
+				break;
+			}
+
+			if (i % 5000 == 4999)
+				m_data += Frame({ "4", "2", "-1", "2104", std::string(rng() % 20000 + 1, 'x') });   // error
+		}
+
+		index();
+	}
+
+	bool read(const std::string &path) {
+		FILE *f = fopen(path.c_str(), "rb");
+
+		if (!f)
+			return false;
+
+		char buf[65536];
+		size_t n;
+
+		m_data.clear();
+		while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+			m_data.append(buf, n);
+
+		fclose(f);
+		return index();
+	}
+
+	bool write(const std::string &path) const {
+		FILE *f = fopen(path.c_str(), "wb");
+
+		if (!f)
+			return false;
+
+		bool ok = fwrite(m_data.data(), 1, m_data.size(), f) == m_data.size();
+
+		return fclose(f) == 0 && ok;
+	}
+
+	const std::string &data() const { return m_data; }
+	size_t frames() const { return m_frameEnds.size(); }
+	size_t frameEnd(size_t frame) const { return m_frameEnds[frame]; }
+};
+
+// -------------------------------------------------------------------------------------------
+// the gateway: a forked process that does the v100 handshake and replays the stream
+
+class ReplayGateway
+{
+	int m_listenFd;
+	int m_port;
+	pid_t m_pid;
+
+	static bool readFully(int fd, char *buf, size_t size) {
+		while (size > 0) {
+			ssize_t n = ::recv(fd, buf, size, 0);
+
+			if (n <= 0)
+				return false;
+
+			buf += n;
+			size -= n;
+		}
+
+		return true;
+	}
+
+	static bool readFrame(int fd) {
+		unsigned char header[4];
+
+		if (!readFully(fd, (char *)header, sizeof(header)))
+			return false;
+
+		std::string body(((size_t)header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3], '\0');
+
+		return body.empty() || readFully(fd, &body[0], body.size());
+	}
+
+	static bool sendFully(int fd, const char *buf, size_t size) {
+		while (size > 0) {
+			ssize_t n = ::send(fd, buf, size, MSG_NOSIGNAL);
+
+			if (n <= 0)
+				return false;
+
+			buf += n;
+			size -= n;
+		}
+
+		return true;
+	}
+
+	// sleeps rather than spins, so the gateway leaves the CPU to the client on a small machine;
+	// absolute deadlines keep the pace even when the sleep overshoots
+	static void pause(struct timespec &deadline, int micros) {
+		deadline.tv_nsec += micros * 1000L;
+		deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+		deadline.tv_nsec %= 1000000000L;
+
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, 0) == EINTR)
+			;
+	}
+
+	static void serve(int fd, const Stream &stream, const Options &options, bool paced) {
+		char prefix[4];
+
+		// "API\0" and the client's version range, the ack, then its startApi
+		if (!readFully(fd, prefix, sizeof(prefix)) || !readFrame(fd))
+			return;
+
+		const std::string ack = Stream::Frame({ std::to_string(MAX_CLIENT_VER), SERVER_TIME });
+
+		if (!sendFully(fd, ack.data(), ack.size()) || !readFrame(fd))
+			return;
+
+		const std::string &data = stream.data();
+
+		if (!paced) {
+			for (size_t pos = 0; pos < data.size(); pos += options.chunk) {
+				if (!sendFully(fd, data.data() + pos, std::min(options.chunk, data.size() - pos)))
+					return;
+			}
+			return;
+		}
+
+		size_t begin = 0;
+		struct timespec deadline;
+
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+		for (size_t frame = 0; frame < stream.frames() && (int)(frame / options.burst) < options.bursts; ) {
+			frame = std::min(frame + options.burst, stream.frames());
+
+			const size_t end = stream.frameEnd(frame - 1);
+			std::string burst = data.substr(begin, end - begin);
+			begin = end;
+
+			burst += Stream::Frame({ std::to_string(TICK_STRING), "6", std::to_string(PROBE_TICKER_ID), "45",
+				std::to_string(MonotonicNanos()) });
+
+			if (!sendFully(fd, burst.data(), burst.size()))
+				return;
+
+			pause(deadline, options.intervalUs);
+		}
+	}
+
+	// disable copy (compatible with pre C++11 compiler hence =delete not used)
+	ReplayGateway(const ReplayGateway&);
+	ReplayGateway& operator=(const ReplayGateway&);
+
+public:
+	ReplayGateway(const Stream &stream, const Options &options, bool paced)
+		: m_listenFd(::socket(AF_INET, SOCK_STREAM, 0)), m_port(0), m_pid(-1) {
+		sockaddr_in addr = {};
+
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		socklen_t addrLen = sizeof(addr);
+
+		if (::bind(m_listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(m_listenFd, 1) != 0
+			|| ::getsockname(m_listenFd, (sockaddr *)&addr, &addrLen) != 0)
+			return;
+
+		m_pid = fork();
+
+		if (m_pid == 0) {
+			int fd = ::accept(m_listenFd, 0, 0);
+
+			if (fd >= 0) {
+				int noDelay = 1;
+
+				// bursts go out as they are written, as from a gateway
+				setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+				serve(fd, stream, options, paced);
+				::close(fd);
+			}
+			_exit(0);
+		}
+
+		m_port = ntohs(addr.sin_port);
+	}
+
+	~ReplayGateway() {
+		::close(m_listenFd);
+
+		if (m_pid > 0) {
+			kill(m_pid, SIGTERM);
+			waitpid(m_pid, 0, 0);
+		}
+	}
+
+	int port() const { return m_pid > 0 ? m_port : 0; }
+};
+
+// -------------------------------------------------------------------------------------------
+// the client
+
+class CountingWrapper : public DefaultEWrapper
+{
+public:
+	CountingWrapper() : m_callbacks(0) {}
+
+	long long m_callbacks;
+	std::vector<long long> m_probeNanos;
+
+	void tickPrice(TickerId, TickType, double, const TickAttrib&) { ++m_callbacks; }
+	void tickSize(TickerId, TickType, int) { ++m_callbacks; }
+	void updateMktDepthL2(TickerId, int, const std::string&, int, int, double, int, bool) { ++m_callbacks; }
+	void tickByTickBidAsk(int, time_t, double, double, int, int, const TickAttribBidAsk&) { ++m_callbacks; }
+	void nextValidId(OrderId) { ++m_callbacks; }
+	void error(int, int, const std::string&) { ++m_callbacks; }
+
+	void tickString(TickerId tickerId, TickType, const std::string& value) {
+		++m_callbacks;
+
+		if (tickerId == PROBE_TICKER_ID)
+			m_probeNanos.push_back(MonotonicNanos() - atoll(value.c_str()));
+	}
+};
+
+struct PhaseResult
+{
+	PhaseResult() : ok(false), wallSeconds(0), cpuSeconds(0), callbacks(0) {}
+
+	bool ok;
+	double wallSeconds;
+	double cpuSeconds;
+	long long callbacks;
+	std::vector<long long> probeNanos;
+};
+
+PhaseResult RunPhase(const Stream &stream, const Options &options, const std::string &mode, bool paced)
+{
+	PhaseResult result;
+	ReplayGateway gateway(stream, options, paced);
+
+	if (!gateway.port())
+		return result;
+
+	CountingWrapper wrapper;
+	EReaderOSSignal signal(100);
+	EClientSocket client(&wrapper, &signal);
+	SocketOptions socketOptions;
+
+	socketOptions.rxTimestamps = options.rxTimestamps;
+
+	if (!client.eConnect("127.0.0.1", gateway.port(), 0, false, socketOptions))
+		return result;
+
+	const long long start = MonotonicNanos();
+	const double cpuStart = CpuSeconds();
+
+	{
+		EReader reader(&client, &signal);
+
+		if (mode == "inline") {
+			while (reader.pollOnce(100))
+				;
+		}
+		else {
+			reader.start();
+
+			while (client.isConnected()) {
+				signal.waitForSignal();
+				reader.processMsgs();
+			}
+		}
+		reader.processMsgs();
+	}
+
+	result.wallSeconds = (MonotonicNanos() - start) / 1e9;
+	result.cpuSeconds = CpuSeconds() - cpuStart;
+	result.callbacks = wrapper.m_callbacks;
+	result.probeNanos.swap(wrapper.m_probeNanos);
+	result.ok = true;
+
+	return result;
+}
+
+double Percentile(std::vector<long long> &sorted, double p)
+{
+	if (sorted.empty())
+		return 0;
+
+	size_t i = (size_t)(p * (sorted.size() - 1) + 0.5);
+
+	return sorted[i] / 1e3;
+}
+
+#if defined(IBAPI_IO_URING)
+// EIoUring::read() over the stream: each provided buffer's worth copied into ERecvBuffer in
+// read windows, complete frames consumed as they arrive; returns nanoseconds per MB
+double TimeUringCopy(const Stream &stream, int rounds)
+{
+	const std::string &data = stream.data();
+	double best = 0;
+
+	for (int round = 0; round < rounds; ++round) {
+		ERecvBuffer buf(READ_WINDOW * 8);
+		size_t frame = 0, consumed = 0;
+		const long long start = MonotonicNanos();
+
+		for (size_t pos = 0; pos < data.size(); ) {
+			const size_t chunkEnd = std::min(pos + URING_BUF_SIZE, data.size());
+
+			while (pos < chunkEnd) {
+				// EReader widens its window to the frame in progress
+				const size_t pending = frame < stream.frames() ? stream.frameEnd(frame) - consumed : 0;
+				size_t space;
+				char *pWrite = buf.prepareWrite(std::max(READ_WINDOW, pending), space);
+				const size_t n = std::min(space, chunkEnd - pos);
+
+				memcpy(pWrite, data.data() + pos, n);
+				buf.commit(n);
+				pos += n;
+
+				size_t frames = 0;
+				while (frame < stream.frames() && stream.frameEnd(frame) <= pos)
+					++frame, ++frames;
+
+				if (frames) {
+					buf.consume(stream.frameEnd(frame - 1) - consumed);
+					consumed = stream.frameEnd(frame - 1);
+					buf.shrink();
+				}
+			}
+		}
+
+		const double nanos = (double)(MonotonicNanos() - start);
+
+		if (round == 0 || nanos < best)
+			best = nanos;
+	}
+
+	return best / (data.size() / 1e6);
+}
+
+// EReader drops to epoll without a word when the kernel refuses io_uring, or a multishot recv
+bool UringAvailable()
+{
+	int fds[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+		return false;
+
+	bool available = false;
+	{
+		EIoUring uring;
+		char c = 0;
+
+		if (uring.init(fds[0], 2, 64) && ::send(fds[1], &c, 1, 0) == 1) {
+			uring.wait(1000);
+			available = uring.hasData() && !uring.unsupported();
+		}
+	}
+
+	::close(fds[0]);
+	::close(fds[1]);
+
+	return available;
+}
+#endif
+
+void Report(const Stream &stream, const Options &options)
+{
+	const double mb = stream.data().size() / 1e6;
+	double inlineCpuPerMb = 0;
+
+	printf("%s: %zu frames, %.1f MB, rx timestamps %s\n", RECV_PATH, stream.frames(), mb,
+		options.rxTimestamps ? "on" : "off");
+#if defined(IBAPI_IO_URING)
+	if (!UringAvailable())
+		printf("%s: io_uring is not available here, the reader runs on epoll\n", RECV_PATH);
+#endif
+
+	for (size_t i = 0; i < options.modes.size(); ++i) {
+		const std::string &mode = options.modes[i];
+
+		PhaseResult throughput;
+
+		for (int round = 0; round < options.rounds; ++round) {
+			PhaseResult result = RunPhase(stream, options, mode, false);
+
+			if (!throughput.ok || (result.ok && result.wallSeconds < throughput.wallSeconds))
+				throughput = result;
+		}
+
+		if (!throughput.ok) {
+			printf("%-6s %-6s could not replay the stream\n", RECV_PATH, mode.c_str());
+			continue;
+		}
+
+		const double cpuPerMb = throughput.cpuSeconds * 1e3 / mb;
+		if (mode == "inline")
+			inlineCpuPerMb = cpuPerMb;
+
+		printf("%-6s %-6s throughput %8.1f ms %8.2f Mmsg/s %8.1f MB/s   cpu %6.2f ms/MB %6.1f ns/msg   callbacks %lld\n",
+			RECV_PATH, mode.c_str(), throughput.wallSeconds * 1e3, throughput.callbacks / throughput.wallSeconds / 1e6,
+			mb / throughput.wallSeconds, cpuPerMb, throughput.cpuSeconds * 1e9 / stream.frames(), throughput.callbacks);
+
+		PhaseResult latency = RunPhase(stream, options, mode, true);
+		std::vector<long long> &probes = latency.probeNanos;
+
+		std::sort(probes.begin(), probes.end());
+		printf("%-6s %-6s latency    %zu probes   p50 %7.1f us   p99 %7.1f us   p99.9 %7.1f us   max %8.1f us\n",
+			RECV_PATH, mode.c_str(), probes.size(), Percentile(probes, 0.5), Percentile(probes, 0.99),
+			Percentile(probes, 0.999), probes.empty() ? 0 : probes.back() / 1e3);
+	}
+
+#if defined(IBAPI_IO_URING)
+	const double copyNanosPerMb = TimeUringCopy(stream, options.rounds);
+
+	printf("%-6s ERecvBuffer copy %6.3f ms/MB", RECV_PATH, copyNanosPerMb / 1e6);
+	if (inlineCpuPerMb > 0)
+		printf(", %.1f%% of the inline cpu per MB", copyNanosPerMb / 1e6 * 100 / inlineCpuPerMb);
+	printf("\n");
+#else
+	(void)inlineCpuPerMb;
+#endif
+}
+
+void Usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-r stream] [-w stream] [-n messages] [-c chunk] [-b burst] [-i interval_us] [-p bursts]\n"
+		"          [-k rounds] [-T] [mode...]\n"
+		"  -r  replay a recorded stream (v100 frames as the gateway sent them after the handshake)\n"
+		"  -w  write the stream, generated or read, to a file and exit\n"
+		"  -n  messages in the generated stream (500000)\n"
+		"  -c  bytes per send in the throughput phase (65536)\n"
+		"  -b  frames per burst in the latency phase (16)\n"
+		"  -i  microseconds between bursts (100)\n"
+		"  -p  bursts in the latency phase (10000)\n"
+		"  -k  rounds of the throughput phase and the copy timing, the fastest counts (5)\n"
+		"  -T  no SO_TIMESTAMPNS receive timestamps, which the socket paths read with recvmsg()\n"
+		"  modes: inline (EReader::pollOnce() on this thread), thread (EReader::start()); both by default\n",
+		argv0);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:w:n:c:b:i:p:k:Th")) != -1) {
+		switch (opt) {
+		case 'r': options.readFile = optarg; break;
+		case 'w': options.writeFile = optarg; break;
+		case 'n': options.messages = atoi(optarg); break;
+		case 'c': options.chunk = (size_t)atol(optarg); break;
+		case 'b': options.burst = atoi(optarg); break;
+		case 'i': options.intervalUs = atoi(optarg); break;
+		case 'p': options.bursts = atoi(optarg); break;
+		case 'k': options.rounds = atoi(optarg); break;
+		case 'T': options.rxTimestamps = false; break;
+		default: Usage(argv[0]); return 2;
+		}
+	}
+
+	for (int i = optind; i < argc; ++i) {
+		if (strcmp(argv[i], "inline") != 0 && strcmp(argv[i], "thread") != 0) {
+			Usage(argv[0]);
+			return 2;
+		}
+		options.modes.push_back(argv[i]);
+	}
+
+	if (options.modes.empty()) {
+		options.modes.push_back("inline");
+		options.modes.push_back("thread");
+	}
+
+	if (options.chunk == 0 || options.burst <= 0 || options.rounds <= 0) {
+		Usage(argv[0]);
+		return 2;
+	}
+
+	Stream stream;
+
+	if (options.readFile.empty())
+		stream.generate(options.messages);
+	else if (!stream.read(options.readFile)) {
+		fprintf(stderr, "%s: not a stream of v100 frames\n", options.readFile.c_str());
+		return 1;
+	}
+
+	if (!options.writeFile.empty()) {
+		if (!stream.write(options.writeFile)) {
+			fprintf(stderr, "cannot write %s\n", options.writeFile.c_str());
+			return 1;
+		}
+		return 0;
+	}
+
+	Report(stream, options);
+
+	return 0;
+}
@@ -25,6 +25,14 @@ void got_signal(int)
 }
 
 
+// optional integer setting from the environment
+static int envInt(const char* name, int dflt)
+{
+	const char* value = std::getenv(name);
+	return value && *value ? atoi(value) : dflt;
+}
+
+
 const unsigned MAX_ATTEMPTS = 50;
 const unsigned SLEEP_TIME = 50; //seconds
 // keep in mind it takes about 16 seconds per symbol to request data...
@@ -38,6 +46,14 @@ int main(int argc, char** argv)
 	const char* connectOptions = argc > 3 ? argv[3] : "";
 	int clientId = 0;
 
+	SocketOptions sockOpts;
+	sockOpts.noDelay = envInt("IB_TCP_NODELAY", 1) != 0;
+	sockOpts.rcvBuf = envInt("IB_SO_RCVBUF", -1);
+	sockOpts.sndBuf = envInt("IB_SO_SNDBUF", -1);
+	sockOpts.busyPollMicros = envInt("IB_SO_BUSY_POLL", -1);
+	sockOpts.quickAck = envInt("IB_TCP_QUICKACK", 0) != 0;
+	sockOpts.priority = envInt("IB_SO_PRIORITY", -1);
+
 	unsigned attempt = 0;
 	printf( "Start of C++ Socket Client Test %u\n", attempt);
 
@@ -59,7 +75,7 @@ int main(int argc, char** argv)
 			client.setConnectOptions( connectOptions);
 		}
 		
-		client.connect( host, port, clientId);
+		client.connect( host, port, clientId, sockOpts);
 		
 		while( client.isConnected()) {
 			client.processMessages();
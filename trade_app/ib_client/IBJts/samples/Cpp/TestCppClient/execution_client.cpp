@@ -7,10 +7,12 @@
 
 #include "EClientSocket.h"
 #include "EPosixClientSocketPlatform.h"
+#include "EMessagePool.h"
 
 #include "Contract.h"
 #include "Order.h"
 #include "OrderState.h"
+#include "EOrderRequest.h"
 #include "Execution.h"
 #include "CommissionReport.h"
 #include "ContractSamples.h"
@@ -41,13 +43,16 @@
 
 
 ExecClient::ExecClient() :
-      m_osSignal(2000)//2-seconds timeout
+      m_osSignal(2000, std::getenv("IB_SIGNAL_SPIN_US") ? atol(std::getenv("IB_SIGNAL_SPIN_US")) : 0)//2-seconds timeout, optional busy-spin before blocking
     , m_pClient(new EClientSocket(this, &m_osSignal))
 	, m_state(ST_CONNECT)
     , m_orderId(0)
     , m_pReader(0)
+    , m_tickHandler(*this)
+    , m_tickDecoder(m_tickHandler)
     , m_extraAuth(false)
     , m_printing(true)
+    , m_inlineDecode(std::getenv("IB_INLINE_DECODE") != nullptr)
     , m_maxLoss(atof(std::getenv("IB_MAX_LOSS")))
     , m_ticker_config("/usr/src/app/IBJts/samples/Cpp/TestCppClient/tickers.txt")
     , m_positions(m_ticker_config)
@@ -77,15 +82,34 @@ ExecClient::~ExecClient()
 }
 
 
-bool ExecClient::connect(const char *host, int port, int clientId)
+bool ExecClient::connect(const char *host, int port, int clientId, const SocketOptions &options)
 {
 	printf( "Connecting to %s:%d clientId:%d\n", !( host && *host) ? "127.0.0.1" : host, port, clientId);
-	bool bRes = m_pClient->eConnect( host, port, clientId, m_extraAuth);
+	if (std::getenv("IB_CONNECT_TIMEOUT_MS"))
+		m_pClient->connectTimeout(atoi(std::getenv("IB_CONNECT_TIMEOUT_MS")));
+	bool bRes = m_pClient->eConnect( host, port, clientId, m_extraAuth, options);
 	
 	if (bRes) {
+		const SocketOptions &eff = m_pClient->effectiveSocketOptions();
+
 		printf( "Connected to %s:%d clientId:%d\n", m_pClient->host().c_str(), m_pClient->port(), clientId);
-        	m_pReader = new EReader(m_pClient, &m_osSignal);
-		m_pReader->start();
+		printf( "Socket options: nodelay=%d rcvbuf=%d sndbuf=%d busy_poll=%d quickack=%d priority=%d\n",
+			eff.noDelay, eff.rcvBuf, eff.sndBuf, eff.busyPollMicros, eff.quickAck, eff.priority);
+        	m_pReader = new EReader(m_pClient, &m_osSignal, MSG_QUEUE_CAPACITY);
+		m_pReader->wrapperView(this);
+		m_pReader->orderView(this);
+		m_pReader->decoder(&m_tickDecoder);
+
+		// callbacks ExecClient stubs out, their frames are dropped before they take a queue slot
+		static const int ignoredMsgIds[] = { TICK_PRICE, TICK_SIZE, TICK_GENERIC, TICK_STRING, TICK_EFP,
+			TICK_OPTION_COMPUTATION, TICK_REQ_PARAMS, TICK_NEWS, MARKET_DEPTH, MARKET_DEPTH_L2,
+			NEWS_BULLETINS, ACCT_UPDATE_TIME };
+
+		for (size_t i = 0; i < sizeof(ignoredMsgIds) / sizeof(ignoredMsgIds[0]); ++i)
+			m_pReader->msgFilter().ignore(ignoredMsgIds[i]);
+
+		if (!m_inlineDecode)
+			m_pReader->start();
 	}
 	else
 		printf( "Cannot connect to %s:%d clientId:%d\n", m_pClient->host().c_str(), m_pClient->port(), clientId);
@@ -98,6 +122,13 @@ void ExecClient::disconnect() const
 	m_pClient->eDisconnect();
 
 	printf ( "Disconnected\n");
+
+	EMessagePoolStats messages = EMessagePool::instance().messageStats();
+	EMessagePoolStats slabs = EMessagePool::instance().slabStats();
+
+	printf( "Message pool: %llu hits, %llu misses, high water %lu; slab pool: %llu hits, %llu misses, high water %lu\n",
+		messages.hits, messages.misses, (unsigned long)messages.highWater,
+		slabs.hits, slabs.misses, (unsigned long)slabs.highWater);
 }
 
 bool ExecClient::isConnected() const
@@ -157,6 +188,11 @@ void ExecClient::processMessages()
             		break; // 
 	}
 
+	if (m_inlineDecode) {
+		m_pReader->pollOnce(2000);
+		return;
+	}
+
 	m_osSignal.waitForSignal();
 	errno = 0;
 	m_pReader->processMsgs();
@@ -191,6 +227,7 @@ void ExecClient::orderOperations()
     
     // iterate over all symbols, and send orders for the shares you want 
     std::string loc_sym;
+    m_pClient->beginBatch();
     for( unsigned int i = 0; i < m_ticker_config.size(); ++i){
             
         loc_sym = m_ticker_config.loc_syms(i);
@@ -203,7 +240,7 @@ void ExecClient::orderOperations()
                     m_positions.getActualPosition(loc_sym)-
                     m_positions.getDesiredPosition(loc_sym); 
 
-            market_sell(loc_sym, numShares); 
+            market_sell(i, numShares); 
 
             if( m_printing) std::cout << "now selling " << numShares << " shares\n";
 
@@ -213,11 +250,12 @@ void ExecClient::orderOperations()
                         m_positions.getDesiredPosition(loc_sym) -
                         m_positions.getActualPosition(loc_sym);
 
-            market_buy(loc_sym, numShares); 
+            market_buy(i, numShares); 
 
             if( m_printing) std::cout << "now buying " << numShares << " shares\n";
         }            
 	}
+    m_pClient->endBatch();
 
     // tell API to go check PNL  
     m_state = ST_CHECK_PNL;
@@ -327,12 +365,19 @@ void ExecClient::nextValidId( OrderId orderId)
         printf("Next Valid Id: %ld\n", orderId);
 	m_orderId = orderId;
 
+    prepareOrderTemplates();
+
     // the starting state after connection is achieved
     m_state = ST_REQTRADEDATA; 
 }
 
 
 void ExecClient::error(int id, int errorCode, const std::string& errorString)
+{
+	error( id, errorCode, EStringView(errorString));
+}
+
+void ExecClient::error(int id, int errorCode, const EStringView& errorString)
 {
 	printf( "Error. Id: %d, Code: %d, Msg: %s\n", id, errorCode, errorString.c_str());
 }
@@ -341,6 +386,14 @@ void ExecClient::error(int id, int errorCode, const std::string& errorString)
 void ExecClient::orderStatus(OrderId orderId, const std::string& status, double filled,
 		double remaining, double avgFillPrice, int permId, int parentId,
 		double lastFillPrice, int clientId, const std::string& whyHeld, double mktCapPrice){
+
+	orderStatus( orderId, EStringView(status), filled, remaining, avgFillPrice, permId, parentId,
+		lastFillPrice, clientId, EStringView(whyHeld), mktCapPrice);
+}
+
+void ExecClient::orderStatus(OrderId orderId, const EStringView& status, double filled,
+		double remaining, double avgFillPrice, int permId, int parentId,
+		double lastFillPrice, int clientId, const EStringView& whyHeld, double mktCapPrice){
 	
     if(m_printing)
         printf("OrderStatus. Id: %ld, Status: %s, Filled: %g, Remaining: %g, AvgFillPrice: %g, PermId: %d, LastFillPrice: %g, ClientId: %d, WhyHeld: %s, MktCapPrice: %g\n", orderId, status.c_str(), filled, remaining, avgFillPrice, permId, lastFillPrice, clientId, whyHeld.c_str(), mktCapPrice);
@@ -359,6 +412,18 @@ void ExecClient::openOrder( OrderId orderId, const Contract& contract, const Ord
 }
 
 
+void ExecClient::openOrder(const OrderSummary& summary, const EOrderMessage& message) {
+	if (m_printing) {
+		Contract contract;
+		Order order;
+		OrderState orderState;
+
+		message.decode(contract, order, orderState);
+		openOrder(summary.orderId, contract, order, orderState);
+	}
+}
+
+
 void ExecClient::openOrderEnd() {
 	if(m_printing)
         printf( "OpenOrderEnd\n");
@@ -465,6 +530,11 @@ void ExecClient::pnl(int reqId, double dailyPnL, double unrealizedPnL, double re
 
 
 void ExecClient::tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size, const TickAttribLast& tickAttribLast, const std::string& exchange, const std::string& specialConditions) {
+    tickByTickAllLast(reqId, tickType, time, price, size, tickAttribLast, EStringView(exchange), EStringView(specialConditions));
+}
+
+
+void ExecClient::tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size, const TickAttribLast& tickAttribLast, const EStringView& exchange, const EStringView& specialConditions) {
 
     std::string loc_sym = m_positions.getLocalSymbolFromID(reqId); 
 
@@ -499,6 +569,21 @@ void ExecClient::tickByTickBidAsk(int reqId, time_t time, double bidPrice, doubl
 }
 
 
+void ExecTickHandler::tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size, const TickAttribLast& tickAttribLast, const EStringView& exchange, const EStringView& specialConditions) {
+    client.ExecClient::tickByTickAllLast(reqId, tickType, time, price, size, tickAttribLast, exchange, specialConditions);
+}
+
+
+void ExecTickHandler::tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize, int askSize, const TickAttribBidAsk& tickAttribBidAsk) {
+    client.ExecClient::tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, tickAttribBidAsk);
+}
+
+
+void ExecTickHandler::pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) {
+    client.ExecClient::pnl(reqId, dailyPnL, unrealizedPnL, realizedPnL);
+}
+
+
 void ExecClient::completedOrder(const Contract& contract, const Order& order, const OrderState& orderState) {
 	printf( "CompletedOrder. PermId: %i, ParentPermId: %lld, Account: %s, Symbol: %s, SecType: %s, Exchange: %s:, Action: %s, OrderType: %s, TotalQty: %g, CashQty: %g, FilledQty: %g, "
 		"LmtPrice: %g, AuxPrice: %g, Status: %s, CompletedTime: %s, CompletedStatus: %s\n", 
@@ -510,16 +595,51 @@ void ExecClient::completedOrder(const Contract& contract, const Order& order, co
 
 
 
-inline void ExecClient::market_sell(const std::string& local_symbol, unsigned qty) {
+void ExecClient::prepareOrderTemplates() {
+
+    m_buyOrders.assign(m_ticker_config.size(), EOrderTemplate());
+    m_sellOrders.assign(m_ticker_config.size(), EOrderTemplate());
+
+    for(unsigned int i = 0; i < m_ticker_config.size(); ++i){
+        std::string loc_sym = m_ticker_config.loc_syms(i);
+        Contract contract = symbolContract(loc_sym);
+
+        // checked against placeOrder() on the way, a symbol without them falls back to it
+        if( !m_pClient->prepareOrder(m_buyOrders[i], contract, OrderSamples::MarketOrder("BUY", 1))
+            || !m_pClient->prepareOrder(m_sellOrders[i], contract, OrderSamples::MarketOrder("SELL", 1)))
+            std::cout << "no order templates for " << loc_sym << ", using placeOrder()\n";
+    }
+}
+
+
+Contract ExecClient::symbolContract(const std::string& local_symbol) {
 
-    Order le_order = OrderSamples::MarketOrder("SELL", qty);
     Contract contract;
     contract.symbol = m_positions.getNonLocalSymbol(local_symbol);
     contract.secType = m_positions.getSecType(local_symbol);
     contract.currency = m_positions.getCurrency(local_symbol);
     contract.exchange = m_positions.getExchange(local_symbol);
     contract.localSymbol = local_symbol; 
+    return contract;
+}
+
+
+void ExecClient::placeMarketOrder(const std::string& local_symbol, const std::string& action, unsigned qty) {
+
+    Order le_order = OrderSamples::MarketOrder(action, qty);
+    Contract contract = symbolContract(local_symbol);
     m_pClient->placeOrder(m_orderId++, contract, le_order);
+}
+
+
+inline void ExecClient::market_sell(unsigned sym, unsigned qty) {
+
+    const std::string local_symbol = m_ticker_config.loc_syms(sym);
+
+    if( sym < m_sellOrders.size() && m_sellOrders[sym].ready())
+        m_pClient->placeOrder(m_sellOrders[sym], m_orderId++, qty, UNSET_DOUBLE);
+    else
+        placeMarketOrder(local_symbol, "SELL", qty);
 
     // change your "actual position" 
     // this only makes sense because we're sending market orders 
@@ -531,16 +651,14 @@ inline void ExecClient::market_sell(const std::string& local_symbol, unsigned qt
 }
 
 
-inline void ExecClient::market_buy(const std::string& local_symbol, unsigned qty) {
+inline void ExecClient::market_buy(unsigned sym, unsigned qty) {
 
-    Order le_order = OrderSamples::MarketOrder("BUY", qty);
-    Contract contract;
-    contract.symbol = m_positions.getNonLocalSymbol(local_symbol);
-    contract.secType = m_positions.getSecType(local_symbol);
-    contract.currency = m_positions.getCurrency(local_symbol);
-    contract.exchange = m_positions.getExchange(local_symbol);
-    contract.localSymbol = local_symbol; 
-    m_pClient->placeOrder(m_orderId++, contract, le_order);
+    const std::string local_symbol = m_ticker_config.loc_syms(sym);
+
+    if( sym < m_buyOrders.size() && m_buyOrders[sym].ready())
+        m_pClient->placeOrder(m_buyOrders[sym], m_orderId++, qty, UNSET_DOUBLE);
+    else
+        placeMarketOrder(local_symbol, "BUY", qty);
 
     // change your "actual position" 
     // this only makes sense because we're sending market orders 
@@ -556,16 +674,44 @@ inline void ExecClient::close_all_positions() {
 
     std::cout << "NOW CLOSING ALL POSITIONS\n\n";
 
+    // every closing order goes out in one placeOrders() write
+    std::vector<OrderRequest> requests;
+    std::vector<std::string> request_syms;
+    std::vector<int> request_shares;
+
+    // symbols without templates are encoded in full; reserved so the requests can point at them
+    std::vector<Contract> contracts;
+    std::vector<Order> orders;
+    contracts.reserve(m_ticker_config.size());
+    orders.reserve(m_ticker_config.size());
+
     for(unsigned int i = 0; i < m_ticker_config.size(); ++i){
         std::string loc_sym = m_ticker_config.loc_syms(i);
         int signed_pos = m_positions.getActualPosition(loc_sym);
-        if( signed_pos > 0 ){
-            unsigned unsigned_pos = std::abs(signed_pos); 
-            market_sell(loc_sym, unsigned_pos);        
-        }else if( signed_pos < 0){
-            unsigned unsigned_pos = std::abs(signed_pos); 
-            market_buy(loc_sym, unsigned_pos);
+        if( signed_pos == 0 )
+            continue;
+
+        const std::vector<EOrderTemplate>& templates = signed_pos > 0 ? m_sellOrders : m_buyOrders;
+        unsigned unsigned_pos = std::abs(signed_pos); 
+
+        if( i < templates.size() && templates[i].ready() ){
+            requests.push_back(OrderRequest(templates[i], m_orderId++, unsigned_pos, UNSET_DOUBLE));
+        }else{
+            contracts.push_back(symbolContract(loc_sym));
+            orders.push_back(OrderSamples::MarketOrder(signed_pos > 0 ? "SELL" : "BUY", unsigned_pos));
+            requests.push_back(OrderRequest(m_orderId++, contracts.back(), orders.back()));
         }
+        request_syms.push_back(loc_sym);
+        request_shares.push_back(-signed_pos);
+    }
+
+    if( !requests.empty() )
+        m_pClient->placeOrders(&requests[0], requests.size());
+
+    // only what actually went out changes the position
+    for(size_t i = 0; i < requests.size(); ++i){
+        if( requests[i].status == ORDER_REQUEST_SENT )
+            m_positions.incrementPosition(request_syms[i], request_shares[i]);
     }
 }
 
@@ -574,6 +720,7 @@ inline void ExecClient::close_all_positions() {
 void ExecClient::marketRule(int marketRuleId, const std::vector<PriceIncrement> &priceIncrements) {}
 void ExecClient::orderBound(long long orderId, int apiClientId, int apiOrderId) {}
 void ExecClient::tickString(TickerId tickerId, TickType tickType, const std::string& value) {}
+void ExecClient::tickString(TickerId tickerId, TickType tickType, const EStringView& value) {}
 void ExecClient::currentTime( long time) {}
 void ExecClient::familyCodes(const std::vector<FamilyCode> &familyCodes) {}
 void ExecClient::newsArticle(int requestId, int articleType, const std::string& articleText) {}
@@ -586,6 +733,7 @@ void ExecClient::histogramData(int reqId, const HistogramDataVector& data) {}
 void ExecClient::newsProviders(const std::vector<NewsProvider> &newsProviders) {}
 void ExecClient::symbolSamples(int reqId, const std::vector<ContractDescription> &contractDescriptions) {}
 void ExecClient::tickReqParams(int tickerId, double minTick, const std::string& bboExchange, int snapshotPermissions) {}
+void ExecClient::tickReqParams(int tickerId, double minTick, const EStringView& bboExchange, int snapshotPermissions) {}
 void ExecClient::accountSummary( int reqId, const std::string& account, const std::string& tag, const std::string& value, const std::string& currency) {}
 void ExecClient::historicalData(TickerId reqId, const Bar& bar) {}
 void ExecClient::historicalNews(int requestId, const std::string& time, const std::string& providerCode, const std::string& articleId, const std::string& headline) {}
@@ -608,6 +756,8 @@ void ExecClient::historicalNewsEnd(int requestId, bool hasMore) {}
 void ExecClient::mktDepthExchanges(const std::vector<DepthMktDataDescription> &depthMktDataDescriptions) {}
 void ExecClient::updateMktDepthL2(TickerId id, int position, const std::string& marketMaker, int operation,
                                      int side, double price, int size, bool isSmartDepth) {}
+void ExecClient::updateMktDepthL2(TickerId id, int position, const EStringView& marketMaker, int operation,
+                                     int side, double price, int size, bool isSmartDepth) {}
 void ExecClient::rerouteMktDataReq(int reqId, int conid, const std::string& exchange) {}
 void ExecClient::scannerParameters(const std::string& xml) {}
 void ExecClient::updateAccountTime(const std::string& timeStamp) {}
@@ -640,6 +790,15 @@ void ExecClient::tickPrice( TickerId tickerId, TickType field, double price, con
 void ExecClient::historicalDataUpdate(TickerId reqId, const Bar& bar) {}
 void ExecClient::pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {}
 void ExecClient::winError( const std::string& str, int lastError) {}
+void ExecClient::completedOrder(const OrderSummary& summary, const EOrderMessage& message) {
+	Contract contract;
+	Order order;
+	OrderState orderState;
+
+	message.decode(contract, order, orderState);
+	completedOrder(contract, order, orderState);
+}
+
 void ExecClient::completedOrdersEnd() {}
 void ExecClient::positionMulti( int reqId, const std::string& account,const std::string& modelCode, const Contract& contract, double pos, double avgCost){} 
 void ExecClient::positionMultiEnd( int reqId) {}
@@ -6,8 +6,13 @@
 #define TWS_API_SAMPLES_TESTCPPCLIENT_TESTCPPCLIENT_H
 
 #include "EWrapper.h"
-#include "EReaderOSSignal.h"
+#include "EWrapperView.h"
+#include "EOrderView.h"
+#include "EOrderTemplate.h"
+#include "EReaderFutexSignal.h"
 #include "EReader.h"
+#include "EStaticDecoder.h"
+#include "SocketOptions.h"
 
 #include <memory>
 #include <vector>
@@ -17,8 +22,25 @@
 #include "positions.h"
 #define PNL_REGID 123
 #define POS_REGID 567
+#define MSG_QUEUE_CAPACITY 4096 // reader -> processMessages() lock-free ring slots
 
 class EClientSocket;
+class ExecClient;
+
+// The market data ExecClient acts on, decoded by an EStaticDecoder and passed straight to
+// the ExecClient methods. Tick messages ExecClient has no use for are dropped undecoded.
+struct ExecTickHandler
+{
+	ExecClient &client;
+
+	explicit ExecTickHandler(ExecClient &c) : client(c) {}
+
+	void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size,
+		const TickAttribLast& tickAttribLast, const EStringView& exchange, const EStringView& specialConditions);
+	void tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize, int askSize,
+		const TickAttribBidAsk& tickAttribBidAsk);
+	void pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL);
+};
 
 enum State {
     ST_CONNECT,
@@ -32,7 +54,7 @@ enum State {
     ST_UNSUBSCRIBE
 };
 
-class ExecClient : public EWrapper
+class ExecClient : public EWrapper, public EWrapperView, public EOrderView
 {
 private:
 
@@ -46,7 +68,7 @@ public:
 
 public:
 
-	bool connect(const char * host, int port, int clientId = 0);
+	bool connect(const char * host, int port, int clientId = 0, const SocketOptions &options = SocketOptions());
 	void disconnect() const;
 	bool isConnected() const;
 
@@ -63,18 +85,37 @@ public:
 	// events
 	#include "EWrapper_prototypes.h"
 
+	// zero-copy variants of the string carrying hot messages, see EWrapperView
+	void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size,
+		const TickAttribLast& tickAttribLast, const EStringView& exchange, const EStringView& specialConditions);
+	void tickString(TickerId tickerId, TickType tickType, const EStringView& value);
+	void tickReqParams(int tickerId, double minTick, const EStringView& bboExchange, int snapshotPermissions);
+	void updateMktDepthL2(TickerId id, int position, const EStringView& marketMaker, int operation,
+		int side, double price, int size, bool isSmartDepth);
+	void orderStatus(OrderId orderId, const EStringView& status, double filled,
+		double remaining, double avgFillPrice, int permId, int parentId,
+		double lastFillPrice, int clientId, const EStringView& whyHeld, double mktCapPrice);
+	void error(int id, int errorCode, const EStringView& errorString);
+
+	// order summaries, see EOrderView; full orders are only decoded when printed
+	void openOrder(const OrderSummary& summary, const EOrderMessage& message);
+	void completedOrder(const OrderSummary& summary, const EOrderMessage& message);
+
 private:
-	EReaderOSSignal m_osSignal;
+	EReaderFutexSignal m_osSignal;
 	EClientSocket * const m_pClient;
 	State m_state;
 
 	OrderId m_orderId;
 	EReader *m_pReader;
+	ExecTickHandler m_tickHandler;
+	EStaticDecoder<ExecTickHandler> m_tickDecoder;
     bool m_extraAuth;
 	std::string m_bboExchange;
 
     // new stuff! 
     const bool m_printing;
+    const bool m_inlineDecode; // decode on the processMessages() thread, no reader thread
     const double m_maxLoss;
     hft::FutSymsConfig m_ticker_config;
     hft::PositionMgr m_positions;
@@ -82,8 +123,15 @@ private:
     double m_high_water_profit;
     // rolling window stuff
 
-    inline void market_sell(const std::string& local_symbol, unsigned qty);
-    inline void market_buy(const std::string& local_symbol, unsigned qty);
+    // one pre-encoded market order per tracked symbol and side, indexed like m_ticker_config
+    std::vector<EOrderTemplate> m_buyOrders;
+    std::vector<EOrderTemplate> m_sellOrders;
+
+    void prepareOrderTemplates();
+    Contract symbolContract(const std::string& local_symbol);
+    void placeMarketOrder(const std::string& local_symbol, const std::string& action, unsigned qty);
+    inline void market_sell(unsigned sym, unsigned qty);
+    inline void market_buy(unsigned sym, unsigned qty);
     inline void close_all_positions();
 
 };
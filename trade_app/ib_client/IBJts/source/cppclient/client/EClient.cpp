@@ -16,8 +16,12 @@
 #include "ScannerSubscription.h"
 #include "CommissionReport.h"
 #include "EDecoder.h"
+#include "EVersionTier.h"
 #include "EMessage.h"
 #include "ETransport.h"
+#include "EMessageEncoder.h"
+#include "EOrderTemplate.h"
+#include "EOrderRequest.h"
 #include "FamilyCode.h"
 
 #include <sstream>
@@ -27,6 +31,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
 
 
 using namespace ibapi::client_constants;
@@ -39,14 +44,91 @@ void EClient::EncodeField<bool>(std::ostream& os, bool boolValue)
     EncodeField<int>(os, boolValue ? 1 : 0);
 }
 
+// Formats value exactly as snprintf("%.10g") does, but cheaply for the prices and quantities
+// requests carry: a value from 1e-4 up to 1e10 is scaled to its 10 significant digits as an
+// integer and written out from that. Only values outside the range, and the few whose scaled
+// value lies too close to a rounding tie to round it the way snprintf() does, are left to
+// snprintf(). Its output gets '.' for a decimal point whatever the locale, as TWS expects.
+// Returns the length written, at most 16 characters plus the terminating 0.
+static int FormatDouble(char *str, size_t size, double value)
+{
+    static const double POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13 };
+    static const unsigned long long IPOW10[] = { 1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+        10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL };
+
+    const double abs = value < 0 ? -value : value;
+
+    if (abs >= 1e-4 && abs < 1e10) {
+        // decimal exponent of the value, then the digits after the point %.10g keeps for it
+        int exp = 9;
+        while (exp >= 0 ? abs < POW10[exp] : abs * POW10[-exp] < 1)
+            --exp;
+        int decimals = 9 - exp;
+
+        // one rounding in the product, well below the margin kept from a tie
+        const double scaled = abs * POW10[decimals];
+        const double whole = floor(scaled);
+        const double fraction = scaled - whole;
+
+        unsigned long long digits = (unsigned long long)whole + (fraction > 0.5 ? 1 : 0);
+
+        if (fabs(fraction - 0.5) > 1e-5 && digits >= IPOW10[9] && digits < IPOW10[10]) {
+            unsigned long long intPart = digits / IPOW10[decimals];
+            unsigned long long fracPart = digits % IPOW10[decimals];
+
+            char *p = str;
+            if (value < 0)
+                *p++ = '-';
+
+            char buf[24];
+            int n = 0;
+            do {
+                buf[n++] = (char)('0' + intPart % 10);
+                intPart /= 10;
+            } while (intPart);
+            while (n)
+                *p++ = buf[--n];
+
+            if (fracPart) {
+                while (fracPart % 10 == 0) {
+                    fracPart /= 10;
+                    --decimals;
+                }
+                *p++ = '.';
+                for (int i = decimals - 1; i >= 0; --i) {
+                    p[i] = (char)('0' + fracPart % 10);
+                    fracPart /= 10;
+                }
+                p += decimals;
+            }
+
+            *p = 0;
+            return (int)(p - str);
+        }
+    }
+    else if (value == 0 && !signbit(value)) {
+        str[0] = '0';
+        str[1] = 0;
+        return 1;
+    }
+
+    int len = snprintf(str, size, "%.10g", value);
+
+    char *point = strchr(str, ',');
+    if (point)
+        *point = '.';
+
+    return len;
+}
+
 template<>
 void EClient::EncodeField<double>(std::ostream& os, double doubleValue)
 {
     char str[128];
 
-    snprintf(str, sizeof(str), "%.10g", doubleValue);
+    int len = FormatDouble(str, sizeof(str), doubleValue);
 
-    EncodeField<const char*>(os, str);
+    os.write(str, len + 1);
 }
 
 void EClient::EncodeContract(std::ostream& os, const Contract &contract)
@@ -115,6 +197,7 @@ EClient::EClient( EWrapper *ptr, ETransport *pTransport)
     , m_connState(CS_DISCONNECTED)
     , m_extraAuth(false)
     , m_serverVersion(0)
+    , m_pOrderCapture(0)
     , m_useV100Plus(true)
 {
 }
@@ -197,7 +280,7 @@ bool EClient::usingV100Plus() {
 }
 
 int EClient::bufferedSend(const std::string& msg) {
-    EMessage emsg(std::vector<char>(msg.begin(), msg.end()));
+    EMessage emsg(0, msg.data(), msg.data() + msg.size());
 
     return m_transport->send(&emsg);
 }
@@ -242,7 +325,7 @@ void EClient::reqMktData(TickerId tickerId, const Contract& contract,
         }
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 11;
@@ -316,7 +399,7 @@ void EClient::reqMktData(TickerId tickerId, const Contract& contract,
         ENCODE_TAGVALUELIST(mktDataOptions);
     }
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelMktData(TickerId tickerId)
@@ -327,7 +410,7 @@ void EClient::cancelMktData(TickerId tickerId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 2;
@@ -337,7 +420,7 @@ void EClient::cancelMktData(TickerId tickerId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( tickerId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqMktDepth( TickerId tickerId, const Contract& contract, int numRows, bool isSmartDepth, const TagValueListSPtr& mktDepthOptions)
@@ -375,7 +458,7 @@ void EClient::reqMktDepth( TickerId tickerId, const Contract& contract, int numR
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 5;
@@ -416,7 +499,7 @@ void EClient::reqMktDepth( TickerId tickerId, const Contract& contract, int numR
         ENCODE_TAGVALUELIST(mktDepthOptions);
     }
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 
@@ -441,7 +524,7 @@ void EClient::cancelMktDepth( TickerId tickerId, bool isSmartDepth)
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -455,7 +538,7 @@ void EClient::cancelMktDepth( TickerId tickerId, bool isSmartDepth)
         ENCODE_FIELD( isSmartDepth);
     }
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqHistoricalData(TickerId tickerId, const Contract& contract,
@@ -483,7 +566,7 @@ void EClient::reqHistoricalData(TickerId tickerId, const Contract& contract,
         }
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     const int VERSION = 6;
@@ -550,7 +633,7 @@ void EClient::reqHistoricalData(TickerId tickerId, const Contract& contract,
         ENCODE_TAGVALUELIST(chartOptions);
     }
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelHistoricalData(TickerId tickerId)
@@ -568,7 +651,7 @@ void EClient::cancelHistoricalData(TickerId tickerId)
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -577,7 +660,7 @@ void EClient::cancelHistoricalData(TickerId tickerId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( tickerId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqRealTimeBars(TickerId tickerId, const Contract& contract,
@@ -605,7 +688,7 @@ void EClient::reqRealTimeBars(TickerId tickerId, const Contract& contract,
         }
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 3;
@@ -640,7 +723,7 @@ void EClient::reqRealTimeBars(TickerId tickerId, const Contract& contract,
         ENCODE_TAGVALUELIST(realTimeBarsOptions);
     }
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 
@@ -659,7 +742,7 @@ void EClient::cancelRealTimeBars(TickerId tickerId)
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -668,7 +751,7 @@ void EClient::cancelRealTimeBars(TickerId tickerId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( tickerId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 
@@ -687,7 +770,7 @@ void EClient::reqScannerParameters()
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -695,7 +778,7 @@ void EClient::reqScannerParameters()
     ENCODE_FIELD( REQ_SCANNER_PARAMETERS);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 
@@ -715,7 +798,7 @@ void EClient::reqScannerSubscription(int tickerId,
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 4;
@@ -758,7 +841,7 @@ void EClient::reqScannerSubscription(int tickerId,
         ENCODE_TAGVALUELIST(scannerSubscriptionOptions);
     }
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelScannerSubscription(int tickerId)
@@ -776,7 +859,7 @@ void EClient::cancelScannerSubscription(int tickerId)
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -785,7 +868,7 @@ void EClient::cancelScannerSubscription(int tickerId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( tickerId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqFundamentalData(TickerId reqId, const Contract& contract, 
@@ -813,7 +896,7 @@ void EClient::reqFundamentalData(TickerId reqId, const Contract& contract,
         }
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 2;
@@ -840,7 +923,7 @@ void EClient::reqFundamentalData(TickerId reqId, const Contract& contract,
         ENCODE_TAGVALUELIST(fundamentalDataOptions);
     }
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelFundamentalData( TickerId reqId)
@@ -857,7 +940,7 @@ void EClient::cancelFundamentalData( TickerId reqId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -866,7 +949,7 @@ void EClient::cancelFundamentalData( TickerId reqId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( reqId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::calculateImpliedVolatility(TickerId reqId, const Contract& contract, double optionPrice, double underPrice,
@@ -893,7 +976,7 @@ void EClient::calculateImpliedVolatility(TickerId reqId, const Contract& contrac
                                                  }
                                              }
 
-                                             std::stringstream msg;
+                                             EMessageEncoder msg( encodeBuffer());
 
                                              prepareBuffer(msg);
 
@@ -927,7 +1010,7 @@ void EClient::calculateImpliedVolatility(TickerId reqId, const Contract& contrac
                                                  ENCODE_TAGVALUELIST(miscOptions);
                                              }
 
-                                             closeAndSend( msg.str());
+                                             closeAndSend( msg);
 }
 
 void EClient::cancelCalculateImpliedVolatility(TickerId reqId) {
@@ -944,7 +1027,7 @@ void EClient::cancelCalculateImpliedVolatility(TickerId reqId) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -953,7 +1036,7 @@ void EClient::cancelCalculateImpliedVolatility(TickerId reqId) {
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( reqId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::calculateOptionPrice(TickerId reqId, const Contract& contract, double volatility, double underPrice, 
@@ -980,7 +1063,7 @@ void EClient::calculateOptionPrice(TickerId reqId, const Contract& contract, dou
                                            }
                                        }
 
-                                       std::stringstream msg;
+                                       EMessageEncoder msg( encodeBuffer());
 
                                        prepareBuffer(msg);
 
@@ -1014,7 +1097,7 @@ void EClient::calculateOptionPrice(TickerId reqId, const Contract& contract, dou
                                            ENCODE_TAGVALUELIST(miscOptions);
                                        }
 
-                                       closeAndSend( msg.str());
+                                       closeAndSend( msg);
 }
 
 void EClient::cancelCalculateOptionPrice(TickerId reqId) {
@@ -1031,7 +1114,7 @@ void EClient::cancelCalculateOptionPrice(TickerId reqId) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -1040,7 +1123,7 @@ void EClient::cancelCalculateOptionPrice(TickerId reqId) {
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( reqId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqContractDetails( int reqId, const Contract& contract)
@@ -1079,7 +1162,7 @@ void EClient::reqContractDetails( int reqId, const Contract& contract)
         }
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 8;
@@ -1130,7 +1213,7 @@ void EClient::reqContractDetails( int reqId, const Contract& contract)
         ENCODE_FIELD( contract.secId);
     }
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqCurrentTime()
@@ -1149,7 +1232,7 @@ void EClient::reqCurrentTime()
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -1158,15 +1241,18 @@ void EClient::reqCurrentTime()
     ENCODE_FIELD( REQ_CURRENT_TIME);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
-void EClient::placeOrder( OrderId id, const Contract& contract, const Order& order)
+template<class Tier>
+bool EClient::placeOrderImpl( OrderId id, const Contract& contract, const Order& order)
 {
+    const int serverVersion = Tier::serverVersion(m_serverVersion);
+
     // not connected?
     if( !isConnected()) {
         m_pEWrapper->error( id, NOT_CONNECTED.code(), NOT_CONNECTED.msg());
-        return;
+        return false;
     }
 
     // Not needed anymore validation
@@ -1176,7 +1262,7 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
     //		order.scalePriceIncrement != UNSET_DOUBLE) {
     //		m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
     //			"  It does not support Scale orders.");
-    //		return;
+    //		return false;
     //	}
     //}
     //
@@ -1193,7 +1279,7 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
     //				!comboLeg->designatedLocation.IsEmpty()) {
     //				m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
     //					"  It does not support SSHORT flag for combo legs.");
-    //				return;
+    //				return false;
     //			}
     //		}
     //	}
@@ -1203,68 +1289,68 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
     //	if( order.whatIf) {
     //		m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
     //			"  It does not support what-if orders.");
-    //		return;
+    //		return false;
     //	}
     //}
 
-    if( m_serverVersion < MIN_SERVER_VER_DELTA_NEUTRAL) {
+    if( serverVersion < MIN_SERVER_VER_DELTA_NEUTRAL) {
         if( contract.deltaNeutralContract) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support delta-neutral orders.");
-            return;
+            return false;
         }
     }
 
-    if( m_serverVersion < MIN_SERVER_VER_SCALE_ORDERS2) {
+    if( serverVersion < MIN_SERVER_VER_SCALE_ORDERS2) {
         if( order.scaleSubsLevelSize != UNSET_INTEGER) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support Subsequent Level Size for Scale orders.");
-            return;
+            return false;
         }
     }
 
-    if( m_serverVersion < MIN_SERVER_VER_ALGO_ORDERS) {
+    if( serverVersion < MIN_SERVER_VER_ALGO_ORDERS) {
 
         if( !order.algoStrategy.empty()) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support algo orders.");
-            return;
+            return false;
         }
     }
 
-    if( m_serverVersion < MIN_SERVER_VER_NOT_HELD) {
+    if( serverVersion < MIN_SERVER_VER_NOT_HELD) {
         if (order.notHeld) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support notHeld parameter.");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_SEC_ID_TYPE) {
+    if (serverVersion < MIN_SERVER_VER_SEC_ID_TYPE) {
         if( !contract.secIdType.empty() || !contract.secId.empty()) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support secIdType and secId parameters.");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_PLACE_ORDER_CONID) {
+    if (serverVersion < MIN_SERVER_VER_PLACE_ORDER_CONID) {
         if( contract.conId > 0) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support conId parameter.");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_SSHORTX) {
+    if (serverVersion < MIN_SERVER_VER_SSHORTX) {
         if( order.exemptCode != -1) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support exemptCode parameter.");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_SSHORTX) {
+    if (serverVersion < MIN_SERVER_VER_SSHORTX) {
         const Contract::ComboLegList* const comboLegs = contract.comboLegs.get();
         const int comboLegsCount = comboLegs ? comboLegs->size() : 0;
         for( int i = 0; i < comboLegsCount; ++i) {
@@ -1273,28 +1359,28 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
             if( comboLeg->exemptCode != -1 ){
                 m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                     "  It does not support exemptCode parameter.");
-                return;
+                return false;
             }
         }
     }
 
-    if( m_serverVersion < MIN_SERVER_VER_HEDGE_ORDERS) {
+    if( serverVersion < MIN_SERVER_VER_HEDGE_ORDERS) {
         if( !order.hedgeType.empty()) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support hedge orders.");
-            return;
+            return false;
         }
     }
 
-    if( m_serverVersion < MIN_SERVER_VER_OPT_OUT_SMART_ROUTING) {
+    if( serverVersion < MIN_SERVER_VER_OPT_OUT_SMART_ROUTING) {
         if (order.optOutSmartRouting) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support optOutSmartRouting parameter.");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_DELTA_NEUTRAL_CONID) {
+    if (serverVersion < MIN_SERVER_VER_DELTA_NEUTRAL_CONID) {
         if (order.deltaNeutralConId > 0 
             || !order.deltaNeutralSettlingFirm.empty()
             || !order.deltaNeutralClearingAccount.empty()
@@ -1302,11 +1388,11 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
             ) {
                 m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                     "  It does not support deltaNeutral parameters: ConId, SettlingFirm, ClearingAccount, ClearingIntent.");
-                return;
+                return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_DELTA_NEUTRAL_OPEN_CLOSE) {
+    if (serverVersion < MIN_SERVER_VER_DELTA_NEUTRAL_OPEN_CLOSE) {
         if (!order.deltaNeutralOpenClose.empty()
             || order.deltaNeutralShortSale
             || order.deltaNeutralShortSaleSlot > 0 
@@ -1314,11 +1400,11 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
             ) {
                 m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() + 
                     "  It does not support deltaNeutral parameters: OpenClose, ShortSale, ShortSaleSlot, DesignatedLocation.");
-                return;
+                return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_SCALE_ORDERS3) {
+    if (serverVersion < MIN_SERVER_VER_SCALE_ORDERS3) {
         if (order.scalePriceIncrement > 0 && order.scalePriceIncrement != UNSET_DOUBLE) {
             if (order.scalePriceAdjustValue != UNSET_DOUBLE 
                 || order.scalePriceAdjustInterval != UNSET_INTEGER 
@@ -1330,12 +1416,12 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
                     m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                         "  It does not support Scale order parameters: PriceAdjustValue, PriceAdjustInterval, " +
                         "ProfitOffset, AutoReset, InitPosition, InitFillQty and RandomPercent");
-                    return;
+                    return false;
             }
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_ORDER_COMBO_LEGS_PRICE && contract.secType == "BAG") {
+    if (serverVersion < MIN_SERVER_VER_ORDER_COMBO_LEGS_PRICE && contract.secType == "BAG") {
         const Order::OrderComboLegList* const orderComboLegs = order.orderComboLegs.get();
         const int orderComboLegsCount = orderComboLegs ? orderComboLegs->size() : 0;
         for( int i = 0; i < orderComboLegsCount; ++i) {
@@ -1344,145 +1430,147 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
             if( orderComboLeg->price != UNSET_DOUBLE) {
                 m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                     "  It does not support per-leg prices for order combo legs.");
-                return;
+                return false;
             }
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_TRAILING_PERCENT) {
+    if (serverVersion < MIN_SERVER_VER_TRAILING_PERCENT) {
         if (order.trailingPercent != UNSET_DOUBLE) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support trailing percent parameter");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_TRADING_CLASS) {
+    if (serverVersion < MIN_SERVER_VER_TRADING_CLASS) {
         if( !contract.tradingClass.empty()) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support tradingClass parameter in placeOrder.");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_SCALE_TABLE) {
+    if (serverVersion < MIN_SERVER_VER_SCALE_TABLE) {
         if( !order.scaleTable.empty() || !order.activeStartTime.empty() || !order.activeStopTime.empty()) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support scaleTable, activeStartTime and activeStopTime parameters");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_ALGO_ID) {
+    if (serverVersion < MIN_SERVER_VER_ALGO_ID) {
         if( !order.algoId.empty()) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support algoId parameter");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_ORDER_SOLICITED) {
+    if (serverVersion < MIN_SERVER_VER_ORDER_SOLICITED) {
         if (order.solicited) {
             m_pEWrapper->error(id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support order solicited parameter.");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_MODELS_SUPPORT) {
+    if (serverVersion < MIN_SERVER_VER_MODELS_SUPPORT) {
         if( !order.modelCode.empty()) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support model code parameter.");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_EXT_OPERATOR) {
+    if (serverVersion < MIN_SERVER_VER_EXT_OPERATOR) {
         if( !order.extOperator.empty()) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support ext operator parameter");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_SOFT_DOLLAR_TIER) 
+    if (serverVersion < MIN_SERVER_VER_SOFT_DOLLAR_TIER) 
     {
         if (!order.softDollarTier.name().empty() || !order.softDollarTier.val().empty())
         {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 " It does not support soft dollar tier");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_CASH_QTY) {
+    if (serverVersion < MIN_SERVER_VER_CASH_QTY) {
         if (order.cashQty != UNSET_DOUBLE) {
             m_pEWrapper->error( id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 "  It does not support cash quantity parameter");
-            return;
+            return false;
         }
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_DECISION_MAKER
+    if (serverVersion < MIN_SERVER_VER_DECISION_MAKER
         && (!order.mifid2DecisionMaker.empty()
         || !order.mifid2DecisionAlgo.empty())) {
             m_pEWrapper->error(id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 " It does not support MIFID II decision maker parameters");
-            return;
+            return false;
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_MIFID_EXECUTION
+    if (serverVersion < MIN_SERVER_VER_MIFID_EXECUTION
         && (!order.mifid2ExecutionTrader.empty()
         || !order.mifid2ExecutionAlgo.empty())) {
             m_pEWrapper->error(id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 " It does not support MIFID II execution parameters");
-            return;
+            return false;
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_AUTO_PRICE_FOR_HEDGE
+    if (serverVersion < MIN_SERVER_VER_AUTO_PRICE_FOR_HEDGE
         && order.dontUseAutoPriceForHedge) {
             m_pEWrapper->error(id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 " It does not support don't use auto price for hedge parameter");
-            return;
+            return false;
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_ORDER_CONTAINER 
+    if (serverVersion < MIN_SERVER_VER_ORDER_CONTAINER 
         && order.isOmsContainer) {
             m_pEWrapper->error(id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 " It does not support oms container parameter");
-            return;
+            return false;
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_D_PEG_ORDERS 
+    if (serverVersion < MIN_SERVER_VER_D_PEG_ORDERS 
         && order.discretionaryUpToLimitPrice) {
             m_pEWrapper->error(id, UPDATE_TWS.code(), UPDATE_TWS.msg() +
                 " It does not support D-Peg orders");
-            return;
+            return false;
     }
 
-    if (m_serverVersion < MIN_SERVER_VER_PRICE_MGMT_ALGO
+    if (serverVersion < MIN_SERVER_VER_PRICE_MGMT_ALGO
         && order.usePriceMgmtAlgo != UsePriceMmgtAlgo::DEFAULT) {
             m_pEWrapper->error(id, UPDATE_TWS.code(), UPDATE_TWS.msg() + " It does not support Use Price Management Algo requests");
 
-            return;
+            return false;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
-    int VERSION = (m_serverVersion < MIN_SERVER_VER_NOT_HELD) ? 27 : 45;
+    int VERSION = (serverVersion < MIN_SERVER_VER_NOT_HELD) ? 27 : 45;
 
     // send place order msg
     ENCODE_FIELD( PLACE_ORDER);
 
-    if (m_serverVersion < MIN_SERVER_VER_ORDER_CONTAINER) {
+    if (serverVersion < MIN_SERVER_VER_ORDER_CONTAINER) {
         ENCODE_FIELD( VERSION);
     }
 
+    if (m_pOrderCapture)
+        m_pOrderCapture->mark(EOrderTemplate::ORDER_ID, msg.size());
     ENCODE_FIELD( id);
 
     // send contract fields
-    if( m_serverVersion >= MIN_SERVER_VER_PLACE_ORDER_CONID) {
+    if( serverVersion >= MIN_SERVER_VER_PLACE_ORDER_CONID) {
         ENCODE_FIELD( contract.conId);
     }
     ENCODE_FIELD( contract.symbol);
@@ -1495,11 +1583,11 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
     ENCODE_FIELD( contract.primaryExchange); // srv v14 and above
     ENCODE_FIELD( contract.currency);
     ENCODE_FIELD( contract.localSymbol); // srv v2 and above
-    if( m_serverVersion >= MIN_SERVER_VER_TRADING_CLASS) {
+    if( serverVersion >= MIN_SERVER_VER_TRADING_CLASS) {
         ENCODE_FIELD( contract.tradingClass);
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_SEC_ID_TYPE){
+    if( serverVersion >= MIN_SERVER_VER_SEC_ID_TYPE){
         ENCODE_FIELD( contract.secIdType);
         ENCODE_FIELD( contract.secId);
     }
@@ -1507,19 +1595,15 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
     // send main order fields
     ENCODE_FIELD( order.action);
 
-    if (m_serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS)
-        ENCODE_FIELD(order.totalQuantity)
-    else
-    ENCODE_FIELD((long)order.totalQuantity)
+    if (m_pOrderCapture)
+        m_pOrderCapture->mark(EOrderTemplate::QUANTITY, msg.size());
+    EncodeOrderQuantity(msg, serverVersion, order.totalQuantity);
 
     ENCODE_FIELD( order.orderType);
-    if( m_serverVersion < MIN_SERVER_VER_ORDER_COMBO_LEGS_PRICE) {
-        ENCODE_FIELD( order.lmtPrice == UNSET_DOUBLE ? 0 : order.lmtPrice);
-    }
-    else {
-        ENCODE_FIELD_MAX( order.lmtPrice);
-    }
-    if( m_serverVersion < MIN_SERVER_VER_TRAILING_PERCENT) {
+    if (m_pOrderCapture)
+        m_pOrderCapture->mark(EOrderTemplate::LMT_PRICE, msg.size());
+    EncodeOrderLmtPrice(msg, serverVersion, order.lmtPrice);
+    if( serverVersion < MIN_SERVER_VER_TRAILING_PERCENT) {
         ENCODE_FIELD( order.auxPrice == UNSET_DOUBLE ? 0 : order.auxPrice);
     }
     else {
@@ -1569,7 +1653,7 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
 
                 ENCODE_FIELD( comboLeg->shortSaleSlot); // srv v35 and above
                 ENCODE_FIELD( comboLeg->designatedLocation); // srv v35 and above
-                if (m_serverVersion >= MIN_SERVER_VER_SSHORTX_OLD) { 
+                if (serverVersion >= MIN_SERVER_VER_SSHORTX_OLD) { 
                     ENCODE_FIELD( comboLeg->exemptCode);
                 }
             }
@@ -1577,7 +1661,7 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
     }
 
     // Send order combo legs for BAG requests
-    if( m_serverVersion >= MIN_SERVER_VER_ORDER_COMBO_LEGS_PRICE && contract.secType == "BAG")
+    if( serverVersion >= MIN_SERVER_VER_ORDER_COMBO_LEGS_PRICE && contract.secType == "BAG")
     {
         const Order::OrderComboLegList* const orderComboLegs = order.orderComboLegs.get();
         const int orderComboLegsCount = orderComboLegs ? orderComboLegs->size() : 0;
@@ -1591,7 +1675,7 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
         }
     }	
 
-    if( m_serverVersion >= MIN_SERVER_VER_SMART_COMBO_ROUTING_PARAMS && contract.secType == "BAG") {
+    if( serverVersion >= MIN_SERVER_VER_SMART_COMBO_ROUTING_PARAMS && contract.secType == "BAG") {
         const TagValueList* const smartComboRoutingParams = order.smartComboRoutingParams.get();
         const int smartComboRoutingParamsCount = smartComboRoutingParams ? smartComboRoutingParams->size() : 0;
         ENCODE_FIELD( smartComboRoutingParamsCount);
@@ -1630,14 +1714,14 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
     ENCODE_FIELD( order.faPercentage); // srv v13 and above
     ENCODE_FIELD( order.faProfile); // srv v13 and above
 
-    if (m_serverVersion >= MIN_SERVER_VER_MODELS_SUPPORT) {
+    if (serverVersion >= MIN_SERVER_VER_MODELS_SUPPORT) {
         ENCODE_FIELD( order.modelCode);
     }
 
     // institutional short saleslot data (srv v18 and above)
     ENCODE_FIELD( order.shortSaleSlot);      // 0 for retail, 1 or 2 for institutions
     ENCODE_FIELD( order.designatedLocation); // populate only when shortSaleSlot = 2.
-    if (m_serverVersion >= MIN_SERVER_VER_SSHORTX_OLD) { 
+    if (serverVersion >= MIN_SERVER_VER_SSHORTX_OLD) { 
         ENCODE_FIELD( order.exemptCode);
     }
 
@@ -1681,14 +1765,14 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
     ENCODE_FIELD( order.deltaNeutralOrderType); // srv v28 and above
     ENCODE_FIELD_MAX( order.deltaNeutralAuxPrice); // srv v28 and above
 
-    if (m_serverVersion >= MIN_SERVER_VER_DELTA_NEUTRAL_CONID && !order.deltaNeutralOrderType.empty()){
+    if (serverVersion >= MIN_SERVER_VER_DELTA_NEUTRAL_CONID && !order.deltaNeutralOrderType.empty()){
         ENCODE_FIELD( order.deltaNeutralConId);
         ENCODE_FIELD( order.deltaNeutralSettlingFirm);
         ENCODE_FIELD( order.deltaNeutralClearingAccount);
         ENCODE_FIELD( order.deltaNeutralClearingIntent);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_DELTA_NEUTRAL_OPEN_CLOSE && !order.deltaNeutralOrderType.empty()){
+    if (serverVersion >= MIN_SERVER_VER_DELTA_NEUTRAL_OPEN_CLOSE && !order.deltaNeutralOrderType.empty()){
         ENCODE_FIELD( order.deltaNeutralOpenClose);
         ENCODE_FIELD( order.deltaNeutralShortSale);
         ENCODE_FIELD( order.deltaNeutralShortSaleSlot);
@@ -1708,12 +1792,12 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
 
     ENCODE_FIELD_MAX( order.trailStopPrice); // srv v30 and above
 
-    if( m_serverVersion >= MIN_SERVER_VER_TRAILING_PERCENT) {
+    if( serverVersion >= MIN_SERVER_VER_TRAILING_PERCENT) {
         ENCODE_FIELD_MAX( order.trailingPercent);
     }
 
     // SCALE orders
-    if( m_serverVersion >= MIN_SERVER_VER_SCALE_ORDERS2) {
+    if( serverVersion >= MIN_SERVER_VER_SCALE_ORDERS2) {
         ENCODE_FIELD_MAX( order.scaleInitLevelSize);
         ENCODE_FIELD_MAX( order.scaleSubsLevelSize);
     }
@@ -1725,7 +1809,7 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
 
     ENCODE_FIELD_MAX( order.scalePriceIncrement);
 
-    if( m_serverVersion >= MIN_SERVER_VER_SCALE_ORDERS3 
+    if( serverVersion >= MIN_SERVER_VER_SCALE_ORDERS3 
         && order.scalePriceIncrement > 0.0 && order.scalePriceIncrement != UNSET_DOUBLE) {
             ENCODE_FIELD_MAX( order.scalePriceAdjustValue);
             ENCODE_FIELD_MAX( order.scalePriceAdjustInterval);
@@ -1736,34 +1820,34 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
             ENCODE_FIELD( order.scaleRandomPercent);
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_SCALE_TABLE) {
+    if( serverVersion >= MIN_SERVER_VER_SCALE_TABLE) {
         ENCODE_FIELD( order.scaleTable);
         ENCODE_FIELD( order.activeStartTime);
         ENCODE_FIELD( order.activeStopTime);
     }
 
     // HEDGE orders
-    if( m_serverVersion >= MIN_SERVER_VER_HEDGE_ORDERS) {
+    if( serverVersion >= MIN_SERVER_VER_HEDGE_ORDERS) {
         ENCODE_FIELD( order.hedgeType);
         if ( !order.hedgeType.empty()) {
             ENCODE_FIELD( order.hedgeParam);
         }
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_OPT_OUT_SMART_ROUTING){
+    if( serverVersion >= MIN_SERVER_VER_OPT_OUT_SMART_ROUTING){
         ENCODE_FIELD( order.optOutSmartRouting);
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_PTA_ORDERS) {
+    if( serverVersion >= MIN_SERVER_VER_PTA_ORDERS) {
         ENCODE_FIELD( order.clearingAccount);
         ENCODE_FIELD( order.clearingIntent);
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_NOT_HELD){
+    if( serverVersion >= MIN_SERVER_VER_NOT_HELD){
         ENCODE_FIELD( order.notHeld);
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_DELTA_NEUTRAL) {
+    if( serverVersion >= MIN_SERVER_VER_DELTA_NEUTRAL) {
         if( contract.deltaNeutralContract) {
             const DeltaNeutralContract& deltaNeutralContract = *contract.deltaNeutralContract;
             ENCODE_FIELD( true);
@@ -1776,7 +1860,7 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
         }
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_ALGO_ORDERS) {
+    if( serverVersion >= MIN_SERVER_VER_ALGO_ORDERS) {
         ENCODE_FIELD( order.algoStrategy);
 
         if( !order.algoStrategy.empty()) {
@@ -1794,27 +1878,27 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
 
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_ALGO_ID) {
+    if( serverVersion >= MIN_SERVER_VER_ALGO_ID) {
         ENCODE_FIELD( order.algoId);
     }
 
     ENCODE_FIELD( order.whatIf); // srv v36 and above
 
     // send miscOptions parameter
-    if (m_serverVersion >= MIN_SERVER_VER_LINKING) {
+    if (serverVersion >= MIN_SERVER_VER_LINKING) {
         ENCODE_TAGVALUELIST(order.orderMiscOptions);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_ORDER_SOLICITED) {
+    if (serverVersion >= MIN_SERVER_VER_ORDER_SOLICITED) {
         ENCODE_FIELD(order.solicited);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_RANDOMIZE_SIZE_AND_PRICE) {
+    if (serverVersion >= MIN_SERVER_VER_RANDOMIZE_SIZE_AND_PRICE) {
         ENCODE_FIELD(order.randomizeSize);
         ENCODE_FIELD(order.randomizePrice);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_PEGGED_TO_BENCHMARK) {
+    if (serverVersion >= MIN_SERVER_VER_PEGGED_TO_BENCHMARK) {
         if (order.orderType == "PEG BENCH") {
             ENCODE_FIELD(order.referenceContractId);
             ENCODE_FIELD(order.isPeggedChangeAmountDecrease);
@@ -1844,67 +1928,243 @@ void EClient::placeOrder( OrderId id, const Contract& contract, const Order& ord
         ENCODE_FIELD(order.adjustableTrailingUnit);
     }
 
-    if( m_serverVersion >= MIN_SERVER_VER_EXT_OPERATOR) {
+    if( serverVersion >= MIN_SERVER_VER_EXT_OPERATOR) {
         ENCODE_FIELD( order.extOperator);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_SOFT_DOLLAR_TIER) {
+    if (serverVersion >= MIN_SERVER_VER_SOFT_DOLLAR_TIER) {
         ENCODE_FIELD(order.softDollarTier.name());
         ENCODE_FIELD(order.softDollarTier.val());
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_CASH_QTY) {
+    if (serverVersion >= MIN_SERVER_VER_CASH_QTY) {
         ENCODE_FIELD_MAX( order.cashQty);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_DECISION_MAKER) {
+    if (serverVersion >= MIN_SERVER_VER_DECISION_MAKER) {
         ENCODE_FIELD(order.mifid2DecisionMaker);
         ENCODE_FIELD(order.mifid2DecisionAlgo);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_MIFID_EXECUTION) {
+    if (serverVersion >= MIN_SERVER_VER_MIFID_EXECUTION) {
         ENCODE_FIELD(order.mifid2ExecutionTrader);
         ENCODE_FIELD(order.mifid2ExecutionAlgo);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_AUTO_PRICE_FOR_HEDGE) {
+    if (serverVersion >= MIN_SERVER_VER_AUTO_PRICE_FOR_HEDGE) {
         ENCODE_FIELD(order.dontUseAutoPriceForHedge);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_ORDER_CONTAINER) {
+    if (serverVersion >= MIN_SERVER_VER_ORDER_CONTAINER) {
         ENCODE_FIELD(order.isOmsContainer);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_D_PEG_ORDERS) {
+    if (serverVersion >= MIN_SERVER_VER_D_PEG_ORDERS) {
         ENCODE_FIELD(order.discretionaryUpToLimitPrice);
     }
 
-    if (m_serverVersion >= MIN_SERVER_VER_PRICE_MGMT_ALGO) {
+    if (serverVersion >= MIN_SERVER_VER_PRICE_MGMT_ALGO) {
         ENCODE_FIELD_MAX(order.usePriceMgmtAlgo);
     }
 
-    closeAndSend( msg.str());
+    // prepareOrder() keeps a copy, the message itself is dropped unsent
+    if (m_pOrderCapture) {
+        m_pOrderCapture->capture(msg.data(), msg.size(), m_serverVersion, m_useV100Plus);
+        return true;
+    }
+
+    return closeAndSend( msg);
+}
+
+void EClient::placeOrder( OrderId id, const Contract& contract, const Order& order)
+{
+    sendPlaceOrder( id, contract, order);
+}
+
+bool EClient::sendPlaceOrder( OrderId id, const Contract& contract, const Order& order)
+{
+    // encoded by the instantiation for the negotiated version tier, see EVersionTier.h
+    if (IsLatestVersion(m_serverVersion))
+        return placeOrderImpl<EVersionLatest>(id, contract, order);
+    else
+        return placeOrderImpl<EVersionAny>(id, contract, order);
+}
+
+void EClient::EncodeOrderQuantity(std::ostream& msg, int serverVersion, double quantity)
+{
+    if (serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS)
+        ENCODE_FIELD(quantity)
+    else
+    ENCODE_FIELD((long)quantity)
+}
+
+void EClient::EncodeOrderLmtPrice(std::ostream& msg, int serverVersion, double lmtPrice)
+{
+    if( serverVersion < MIN_SERVER_VER_ORDER_COMBO_LEGS_PRICE) {
+        ENCODE_FIELD( lmtPrice == UNSET_DOUBLE ? 0 : lmtPrice);
+    }
+    else {
+        ENCODE_FIELD_MAX( lmtPrice);
+    }
+}
+
+void EClient::encodeOrder(std::ostream& msg, const EOrderTemplate& tmpl, OrderId id, double quantity, double lmtPrice) const
+{
+    const char *bytes = &tmpl.m_bytes[0];
+    const size_t *begin = tmpl.m_begin;
+    const size_t *end = tmpl.m_end;
+
+    msg.write( bytes, begin[EOrderTemplate::ORDER_ID]);
+    ENCODE_FIELD( id);
+    msg.write( bytes + end[EOrderTemplate::ORDER_ID], begin[EOrderTemplate::QUANTITY] - end[EOrderTemplate::ORDER_ID]);
+    EncodeOrderQuantity(msg, m_serverVersion, quantity);
+    msg.write( bytes + end[EOrderTemplate::QUANTITY], begin[EOrderTemplate::LMT_PRICE] - end[EOrderTemplate::QUANTITY]);
+    EncodeOrderLmtPrice(msg, m_serverVersion, lmtPrice);
+    msg.write( bytes + end[EOrderTemplate::LMT_PRICE], tmpl.m_bytes.size() - end[EOrderTemplate::LMT_PRICE]);
+}
+
+bool EClient::prepareOrder(EOrderTemplate& tmpl, const Contract& contract, const Order& order)
+{
+    tmpl.reset();
+
+    // encode the order exactly as placeOrder() does, and once more with the replaced fields
+    // changed, which the template has to reproduce byte for byte
+    Order probeOrder = order;
+    probeOrder.totalQuantity = order.totalQuantity + 1;
+    probeOrder.lmtPrice = order.lmtPrice == UNSET_DOUBLE ? 1.25 : order.lmtPrice + 1.25;
+
+    EOrderTemplate probe;
+
+    m_pOrderCapture = &tmpl;
+    placeOrder( order.orderId, contract, order);
+    if (tmpl.ready()) {
+        m_pOrderCapture = &probe;
+        placeOrder( order.orderId + 1, contract, probeOrder);
+    }
+    m_pOrderCapture = 0;
+
+    if (!probe.ready()) {
+        tmpl.reset();
+        return false;
+    }
+
+    std::vector<char> patched;
+    {
+        EMessageEncoder msg( patched);
+        encodeOrder( msg, tmpl, order.orderId + 1, probeOrder.totalQuantity, probeOrder.lmtPrice);
+        msg.finish();
+    }
+
+    if (patched != probe.m_bytes) {
+        tmpl.reset();
+        m_pEWrapper->error( order.orderId, FAIL_SEND_ORDER.code(), FAIL_SEND_ORDER.msg() + "order template does not match placeOrder()");
+        return false;
+    }
+
+    return true;
+}
+
+void EClient::placeOrder(const EOrderTemplate& tmpl, OrderId id, double quantity, double lmtPrice)
+{
+    sendPlaceOrder( tmpl, id, quantity, lmtPrice);
+}
+
+bool EClient::sendPlaceOrder(const EOrderTemplate& tmpl, OrderId id, double quantity, double lmtPrice)
+{
+    // not connected?
+    if( !isConnected()) {
+        m_pEWrapper->error( id, NOT_CONNECTED.code(), NOT_CONNECTED.msg());
+        return false;
+    }
+
+    if( tmpl.m_serverVersion != m_serverVersion || tmpl.m_useV100Plus != m_useV100Plus) {
+        m_pEWrapper->error( id, FAIL_SEND_ORDER.code(), FAIL_SEND_ORDER.msg() + "order template not prepared for this connection");
+        return false;
+    }
+
+    EMessageEncoder msg( encodeBuffer());
+    encodeOrder( msg, tmpl, id, quantity, lmtPrice);
+
+    return closeAndSend( msg);
+}
+
+int EClient::placeOrders(OrderRequest* requests, size_t count)
+{
+    int sent = 0;
+
+    // encoded one after the other into the out buffer, which then goes out with one write
+    beginBatch();
+
+    for (size_t i = 0; i < count; ++i) {
+        OrderRequest &request = requests[i];
+        bool encoded = request.tmpl
+            ? sendPlaceOrder( *request.tmpl, request.orderId, request.quantity, request.lmtPrice)
+            : sendPlaceOrder( request.orderId, *request.contract, *request.order);
+
+        request.status = encoded ? ORDER_REQUEST_SENT : ORDER_REQUEST_REJECTED;
+        if (encoded)
+            ++sent;
+    }
+
+    return endRequestBatch( requests, count, sent);
+}
+
+int EClient::endRequestBatch(OrderRequest* requests, size_t count, int sent)
+{
+    // a full socket keeps the rest of the batch queued for the next sends, the requests still
+    // reach TWS; only a flush that closed the connection loses them
+    if (!endBatch() && !isConnected()) {
+        for (size_t i = 0; i < count; ++i) {
+            if (requests[i].status == ORDER_REQUEST_SENT)
+                requests[i].status = ORDER_REQUEST_FAILED;
+        }
+        sent = 0;
+    }
+
+    return sent;
 }
 
 void EClient::cancelOrder( OrderId id)
+{
+    sendCancelOrder( id);
+}
+
+bool EClient::sendCancelOrder( OrderId id)
 {
     // not connected?
     if( !isConnected()) {
         m_pEWrapper->error( id, NOT_CONNECTED.code(), NOT_CONNECTED.msg());
-        return;
+        return false;
     }
 
     const int VERSION = 1;
 
     // send cancel order msg
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     ENCODE_FIELD( CANCEL_ORDER);
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( id);
 
-    closeAndSend( msg.str());
+    return closeAndSend( msg);
+}
+
+int EClient::cancelOrders(OrderRequest* requests, size_t count)
+{
+    int sent = 0;
+
+    beginBatch();
+
+    for (size_t i = 0; i < count; ++i) {
+        bool encoded = sendCancelOrder( requests[i].orderId);
+
+        requests[i].status = encoded ? ORDER_REQUEST_SENT : ORDER_REQUEST_REJECTED;
+        if (encoded)
+            ++sent;
+    }
+
+    return endRequestBatch( requests, count, sent);
 }
 
 void EClient::reqAccountUpdates(bool subscribe, const std::string& acctCode)
@@ -1915,7 +2175,7 @@ void EClient::reqAccountUpdates(bool subscribe, const std::string& acctCode)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 2;
@@ -1928,7 +2188,7 @@ void EClient::reqAccountUpdates(bool subscribe, const std::string& acctCode)
     // Send the account code. This will only be used for FA clients
     ENCODE_FIELD( acctCode); // srv v9 and above
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqOpenOrders()
@@ -1939,7 +2199,7 @@ void EClient::reqOpenOrders()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -1948,7 +2208,7 @@ void EClient::reqOpenOrders()
     ENCODE_FIELD( REQ_OPEN_ORDERS);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqAutoOpenOrders(bool bAutoBind)
@@ -1959,7 +2219,7 @@ void EClient::reqAutoOpenOrders(bool bAutoBind)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -1969,7 +2229,7 @@ void EClient::reqAutoOpenOrders(bool bAutoBind)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( bAutoBind);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqAllOpenOrders()
@@ -1980,7 +2240,7 @@ void EClient::reqAllOpenOrders()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -1989,7 +2249,7 @@ void EClient::reqAllOpenOrders()
     ENCODE_FIELD( REQ_ALL_OPEN_ORDERS);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqExecutions(int reqId, const ExecutionFilter& filter)
@@ -2002,7 +2262,7 @@ void EClient::reqExecutions(int reqId, const ExecutionFilter& filter)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 3;
@@ -2024,7 +2284,7 @@ void EClient::reqExecutions(int reqId, const ExecutionFilter& filter)
     ENCODE_FIELD( filter.m_exchange);
     ENCODE_FIELD( filter.m_side);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqIds( int numIds)
@@ -2035,7 +2295,7 @@ void EClient::reqIds( int numIds)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2045,7 +2305,7 @@ void EClient::reqIds( int numIds)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( numIds);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqNewsBulletins(bool allMsgs)
@@ -2056,7 +2316,7 @@ void EClient::reqNewsBulletins(bool allMsgs)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2066,7 +2326,7 @@ void EClient::reqNewsBulletins(bool allMsgs)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( allMsgs);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelNewsBulletins()
@@ -2077,7 +2337,7 @@ void EClient::cancelNewsBulletins()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2086,7 +2346,7 @@ void EClient::cancelNewsBulletins()
     ENCODE_FIELD( CANCEL_NEWS_BULLETINS);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::setServerLogLevel(int logLevel)
@@ -2097,7 +2357,7 @@ void EClient::setServerLogLevel(int logLevel)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2107,7 +2367,7 @@ void EClient::setServerLogLevel(int logLevel)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( logLevel);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqManagedAccts()
@@ -2118,7 +2378,7 @@ void EClient::reqManagedAccts()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2127,7 +2387,7 @@ void EClient::reqManagedAccts()
     ENCODE_FIELD( REQ_MANAGED_ACCTS);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 
@@ -2145,7 +2405,7 @@ void EClient::requestFA(faDataType pFaDataType)
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2154,7 +2414,7 @@ void EClient::requestFA(faDataType pFaDataType)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( (int)pFaDataType);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::replaceFA(faDataType pFaDataType, const std::string& cxml)
@@ -2171,7 +2431,7 @@ void EClient::replaceFA(faDataType pFaDataType, const std::string& cxml)
     //	return;
     //}
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2181,7 +2441,7 @@ void EClient::replaceFA(faDataType pFaDataType, const std::string& cxml)
     ENCODE_FIELD( (int)pFaDataType);
     ENCODE_FIELD( cxml);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 
@@ -2210,7 +2470,7 @@ void EClient::exerciseOptions( TickerId tickerId, const Contract& contract,
         }
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 2;
@@ -2240,7 +2500,7 @@ void EClient::exerciseOptions( TickerId tickerId, const Contract& contract,
     ENCODE_FIELD( account);
     ENCODE_FIELD( override);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqGlobalCancel()
@@ -2257,7 +2517,7 @@ void EClient::reqGlobalCancel()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2266,7 +2526,7 @@ void EClient::reqGlobalCancel()
     ENCODE_FIELD( REQ_GLOBAL_CANCEL);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqMarketDataType( int marketDataType)
@@ -2283,7 +2543,7 @@ void EClient::reqMarketDataType( int marketDataType)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2292,7 +2552,7 @@ void EClient::reqMarketDataType( int marketDataType)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( marketDataType);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqPositions()
@@ -2309,7 +2569,7 @@ void EClient::reqPositions()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2317,7 +2577,7 @@ void EClient::reqPositions()
     ENCODE_FIELD( REQ_POSITIONS);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelPositions()
@@ -2334,7 +2594,7 @@ void EClient::cancelPositions()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2342,7 +2602,7 @@ void EClient::cancelPositions()
     ENCODE_FIELD( CANCEL_POSITIONS);
     ENCODE_FIELD( VERSION);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqAccountSummary( int reqId, const std::string& groupName, const std::string& tags)
@@ -2359,7 +2619,7 @@ void EClient::reqAccountSummary( int reqId, const std::string& groupName, const
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2370,7 +2630,7 @@ void EClient::reqAccountSummary( int reqId, const std::string& groupName, const
     ENCODE_FIELD( groupName);
     ENCODE_FIELD( tags);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelAccountSummary( int reqId)
@@ -2387,7 +2647,7 @@ void EClient::cancelAccountSummary( int reqId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2396,7 +2656,7 @@ void EClient::cancelAccountSummary( int reqId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( reqId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::verifyRequest(const std::string& apiName, const std::string& apiVersion)
@@ -2419,7 +2679,7 @@ void EClient::verifyRequest(const std::string& apiName, const std::string& apiVe
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2429,7 +2689,7 @@ void EClient::verifyRequest(const std::string& apiName, const std::string& apiVe
     ENCODE_FIELD( apiName);
     ENCODE_FIELD( apiVersion);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::verifyMessage(const std::string& apiData)
@@ -2446,7 +2706,7 @@ void EClient::verifyMessage(const std::string& apiData)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2455,7 +2715,7 @@ void EClient::verifyMessage(const std::string& apiData)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( apiData);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::verifyAndAuthRequest(const std::string& apiName, const std::string& apiVersion, const std::string& opaqueIsvKey)
@@ -2478,7 +2738,7 @@ void EClient::verifyAndAuthRequest(const std::string& apiName, const std::string
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2489,7 +2749,7 @@ void EClient::verifyAndAuthRequest(const std::string& apiName, const std::string
     ENCODE_FIELD( apiVersion);
     ENCODE_FIELD( opaqueIsvKey);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::verifyAndAuthMessage(const std::string& apiData, const std::string& xyzResponse)
@@ -2506,7 +2766,7 @@ void EClient::verifyAndAuthMessage(const std::string& apiData, const std::string
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2516,7 +2776,7 @@ void EClient::verifyAndAuthMessage(const std::string& apiData, const std::string
     ENCODE_FIELD( apiData);
     ENCODE_FIELD( xyzResponse);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::queryDisplayGroups( int reqId)
@@ -2533,7 +2793,7 @@ void EClient::queryDisplayGroups( int reqId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2542,7 +2802,7 @@ void EClient::queryDisplayGroups( int reqId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( reqId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::subscribeToGroupEvents( int reqId, int groupId)
@@ -2559,7 +2819,7 @@ void EClient::subscribeToGroupEvents( int reqId, int groupId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2569,7 +2829,7 @@ void EClient::subscribeToGroupEvents( int reqId, int groupId)
     ENCODE_FIELD( reqId);
     ENCODE_FIELD( groupId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::updateDisplayGroup( int reqId, const std::string& contractInfo)
@@ -2586,7 +2846,7 @@ void EClient::updateDisplayGroup( int reqId, const std::string& contractInfo)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2596,7 +2856,7 @@ void EClient::updateDisplayGroup( int reqId, const std::string& contractInfo)
     ENCODE_FIELD( reqId);
     ENCODE_FIELD( contractInfo);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::startApi()
@@ -2615,7 +2875,7 @@ void EClient::startApi()
         }
         else
         {
-            std::stringstream msg;
+            EMessageEncoder msg( encodeBuffer());
             prepareBuffer( msg);
 
             const int VERSION = 2;
@@ -2627,7 +2887,7 @@ void EClient::startApi()
             if (m_serverVersion >= MIN_SERVER_VER_OPTIONAL_CAPABILITIES)
                 ENCODE_FIELD(m_optionalCapabilities);
 
-            closeAndSend( msg.str());
+            closeAndSend( msg);
         }
     }
 }
@@ -2646,7 +2906,7 @@ void EClient::unsubscribeFromGroupEvents( int reqId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2655,7 +2915,7 @@ void EClient::unsubscribeFromGroupEvents( int reqId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( reqId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqPositionsMulti( int reqId, const std::string& account, const std::string& modelCode)
@@ -2672,7 +2932,7 @@ void EClient::reqPositionsMulti( int reqId, const std::string& account, const st
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2683,7 +2943,7 @@ void EClient::reqPositionsMulti( int reqId, const std::string& account, const st
     ENCODE_FIELD( account);
     ENCODE_FIELD( modelCode);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelPositionsMulti( int reqId)
@@ -2700,7 +2960,7 @@ void EClient::cancelPositionsMulti( int reqId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2709,7 +2969,7 @@ void EClient::cancelPositionsMulti( int reqId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( reqId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqAccountUpdatesMulti( int reqId, const std::string& account, const std::string& modelCode, bool ledgerAndNLV)
@@ -2726,7 +2986,7 @@ void EClient::reqAccountUpdatesMulti( int reqId, const std::string& account, con
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2738,7 +2998,7 @@ void EClient::reqAccountUpdatesMulti( int reqId, const std::string& account, con
     ENCODE_FIELD( modelCode);
     ENCODE_FIELD( ledgerAndNLV);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelAccountUpdatesMulti( int reqId)
@@ -2755,7 +3015,7 @@ void EClient::cancelAccountUpdatesMulti( int reqId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer( msg);
 
     const int VERSION = 1;
@@ -2764,7 +3024,7 @@ void EClient::cancelAccountUpdatesMulti( int reqId)
     ENCODE_FIELD( VERSION);
     ENCODE_FIELD( reqId);
 
-    closeAndSend( msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqSecDefOptParams(int reqId, const std::string& underlyingSymbol, const std::string& futFopExchange, const std::string& underlyingSecType, int underlyingConId)
@@ -2781,7 +3041,7 @@ void EClient::reqSecDefOptParams(int reqId, const std::string& underlyingSymbol,
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
 
@@ -2792,7 +3052,7 @@ void EClient::reqSecDefOptParams(int reqId, const std::string& underlyingSymbol,
     ENCODE_FIELD(underlyingSecType);
     ENCODE_FIELD(underlyingConId);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqSoftDollarTiers(int reqId)
@@ -2802,14 +3062,14 @@ void EClient::reqSoftDollarTiers(int reqId)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
 
     ENCODE_FIELD(REQ_SOFT_DOLLAR_TIERS);
     ENCODE_FIELD(reqId);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqFamilyCodes()
@@ -2825,12 +3085,12 @@ void EClient::reqFamilyCodes()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_FAMILY_CODES);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqMatchingSymbols(int reqId, const std::string& pattern)
@@ -2846,14 +3106,14 @@ void EClient::reqMatchingSymbols(int reqId, const std::string& pattern)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_MATCHING_SYMBOLS);
     ENCODE_FIELD(reqId);
     ENCODE_FIELD(pattern);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqMktDepthExchanges()
@@ -2870,12 +3130,12 @@ void EClient::reqMktDepthExchanges()
     }
 
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_MKT_DEPTH_EXCHANGES);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqSmartComponents(int reqId, std::string bboExchange) 
@@ -2891,14 +3151,14 @@ void EClient::reqSmartComponents(int reqId, std::string bboExchange)
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_SMART_COMPONENTS);
     ENCODE_FIELD(reqId);
     ENCODE_FIELD(bboExchange);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqNewsProviders()
@@ -2914,12 +3174,12 @@ void EClient::reqNewsProviders()
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_NEWS_PROVIDERS);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqNewsArticle(int requestId, const std::string& providerCode, const std::string& articleId, const TagValueListSPtr& newsArticleOptions)
@@ -2935,7 +3195,7 @@ void EClient::reqNewsArticle(int requestId, const std::string& providerCode, con
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_NEWS_ARTICLE);
@@ -2949,7 +3209,7 @@ void EClient::reqNewsArticle(int requestId, const std::string& providerCode, con
         ENCODE_TAGVALUELIST(newsArticleOptions);
     }
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqHistoricalNews(int requestId, int conId, const std::string& providerCodes, const std::string& startDateTime, const std::string& endDateTime, int totalResults,
@@ -2966,7 +3226,7 @@ void EClient::reqHistoricalNews(int requestId, int conId, const std::string& pro
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_HISTORICAL_NEWS);
@@ -2982,7 +3242,7 @@ void EClient::reqHistoricalNews(int requestId, int conId, const std::string& pro
         ENCODE_TAGVALUELIST(historicalNewsOptions);
     }
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqHeadTimestamp(int tickerId, const Contract &contract, const std::string& whatToShow, int useRTH, int formatDate)
@@ -2998,7 +3258,7 @@ void EClient::reqHeadTimestamp(int tickerId, const Contract &contract, const std
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_HEAD_TIMESTAMP);
@@ -3020,7 +3280,7 @@ void EClient::reqHeadTimestamp(int tickerId, const Contract &contract, const std
     ENCODE_FIELD(whatToShow);          
     ENCODE_FIELD(formatDate);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelHeadTimestamp(int tickerId) {
@@ -3035,13 +3295,13 @@ void EClient::cancelHeadTimestamp(int tickerId) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(CANCEL_HEAD_TIMESTAMP);
     ENCODE_FIELD(tickerId);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqHistogramData(int reqId, const Contract &contract, bool useRTH, const std::string& timePeriod) {
@@ -3056,7 +3316,7 @@ void EClient::reqHistogramData(int reqId, const Contract &contract, bool useRTH,
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_HISTOGRAM_DATA);
@@ -3065,7 +3325,7 @@ void EClient::reqHistogramData(int reqId, const Contract &contract, bool useRTH,
     ENCODE_FIELD(useRTH);
     ENCODE_FIELD(timePeriod);          
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelHistogramData(int reqId) {
@@ -3080,13 +3340,13 @@ void EClient::cancelHistogramData(int reqId) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(CANCEL_HISTOGRAM_DATA);
     ENCODE_FIELD(reqId);      
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqMarketRule(int marketRuleId) {
@@ -3101,13 +3361,13 @@ void EClient::reqMarketRule(int marketRuleId) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_MARKET_RULE);
     ENCODE_FIELD(marketRuleId);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqPnL(int reqId, const std::string& account, const std::string& modelCode) {
@@ -3122,7 +3382,7 @@ void EClient::reqPnL(int reqId, const std::string& account, const std::string& m
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_PNL);
@@ -3130,7 +3390,7 @@ void EClient::reqPnL(int reqId, const std::string& account, const std::string& m
     ENCODE_FIELD(account);
     ENCODE_FIELD(modelCode);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelPnL(int reqId) {
@@ -3145,13 +3405,13 @@ void EClient::cancelPnL(int reqId) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(CANCEL_PNL);
     ENCODE_FIELD(reqId);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqPnLSingle(int reqId, const std::string& account, const std::string& modelCode, int conId) {
@@ -3166,7 +3426,7 @@ void EClient::reqPnLSingle(int reqId, const std::string& account, const std::str
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_PNL_SINGLE);
@@ -3175,7 +3435,7 @@ void EClient::reqPnLSingle(int reqId, const std::string& account, const std::str
     ENCODE_FIELD(modelCode);
     ENCODE_FIELD(conId);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::cancelPnLSingle(int reqId) {
@@ -3190,13 +3450,13 @@ void EClient::cancelPnLSingle(int reqId) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(CANCEL_PNL_SINGLE);
     ENCODE_FIELD(reqId);
 
-    closeAndSend(msg.str());
+    closeAndSend( msg);
 }
 
 void EClient::reqHistoricalTicks(int reqId, const Contract &contract, const std::string& startDateTime,
@@ -3212,7 +3472,7 @@ void EClient::reqHistoricalTicks(int reqId, const Contract &contract, const std:
                                          return;
                                      }
 
-                                     std::stringstream msg;
+                                     EMessageEncoder msg( encodeBuffer());
                                      prepareBuffer(msg);
 
                                      ENCODE_FIELD(REQ_HISTORICAL_TICKS);
@@ -3226,7 +3486,7 @@ void EClient::reqHistoricalTicks(int reqId, const Contract &contract, const std:
                                      ENCODE_FIELD(ignoreSize);
                                      ENCODE_TAGVALUELIST(miscOptions);
 
-                                     closeAndSend(msg.str());    
+                                     closeAndSend( msg);    
 }
 
 void EClient::reqTickByTickData(int reqId, const Contract &contract, const std::string& tickType, int numberOfTicks, bool ignoreSize) {
@@ -3249,7 +3509,7 @@ void EClient::reqTickByTickData(int reqId, const Contract &contract, const std::
         }
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_TICK_BY_TICK_DATA);
@@ -3272,7 +3532,7 @@ void EClient::reqTickByTickData(int reqId, const Contract &contract, const std::
         ENCODE_FIELD( ignoreSize);
     }
 
-    closeAndSend(msg.str());    
+    closeAndSend( msg);    
 }
 
 void EClient::cancelTickByTickData(int reqId) {
@@ -3287,13 +3547,13 @@ void EClient::cancelTickByTickData(int reqId) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(CANCEL_TICK_BY_TICK_DATA);
     ENCODE_FIELD(reqId);
 
-    closeAndSend(msg.str());    
+    closeAndSend( msg);    
 }
 
 void EClient::reqCompletedOrders(bool apiOnly) {
@@ -3308,13 +3568,13 @@ void EClient::reqCompletedOrders(bool apiOnly) {
         return;
     }
 
-    std::stringstream msg;
+    EMessageEncoder msg( encodeBuffer());
     prepareBuffer(msg);
 
     ENCODE_FIELD(REQ_COMPLETED_ORDERS);
     ENCODE_FIELD(apiOnly);
 
-    closeAndSend(msg.str());    
+    closeAndSend( msg);    
 }
 
 bool EClient::extraAuth() {
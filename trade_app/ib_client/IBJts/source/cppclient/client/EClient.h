@@ -197,6 +197,9 @@ struct Contract;
 struct Order;
 struct ExecutionFilter;
 struct ScannerSubscription;
+class EMessageEncoder;
+class EOrderTemplate;
+struct OrderRequest;
 struct ETransport;
 
 class EWrapper;
@@ -269,6 +272,16 @@ public:
 	void cancelMktData(TickerId id);
 	void placeOrder(OrderId id, const Contract& contract, const Order& order);
 	void cancelOrder(OrderId id) ;
+
+	// pre-encoded orders, see EOrderTemplate; prepareOrder() reports false if the order can't be
+	// placed or the template doesn't reproduce placeOrder()'s message
+	bool prepareOrder(EOrderTemplate& tmpl, const Contract& contract, const Order& order);
+	void placeOrder(const EOrderTemplate& tmpl, OrderId id, double quantity, double lmtPrice);
+
+	// several orders or cancels encoded into one buffer and written with one flush, see
+	// OrderRequest; each sets every request's status and returns how many went out
+	int placeOrders(OrderRequest* requests, size_t count);
+	int cancelOrders(OrderRequest* requests, size_t count);
 	void reqOpenOrders();
 	void reqAccountUpdates(bool subscribe, const std::string& acctCode);
 	void reqExecutions(int reqId, const ExecutionFilter& filter);
@@ -359,6 +372,17 @@ private:
 
 	virtual int receive(char* buf, size_t sz) = 0;
 
+	template<class Tier> bool placeOrderImpl( OrderId id, const Contract& contract, const Order& order);
+	bool sendPlaceOrder( OrderId id, const Contract& contract, const Order& order);
+	bool sendPlaceOrder(const EOrderTemplate& tmpl, OrderId id, double quantity, double lmtPrice);
+	bool sendCancelOrder( OrderId id);
+	int endRequestBatch(OrderRequest* requests, size_t count, int sent);
+	void encodeOrder(std::ostream& msg, const EOrderTemplate& tmpl, OrderId id, double quantity, double lmtPrice) const;
+
+	// the fields an EOrderTemplate replaces, encoded alike by both placeOrder() paths
+	static void EncodeOrderQuantity(std::ostream& os, int serverVersion, double quantity);
+	static void EncodeOrderLmtPrice(std::ostream& os, int serverVersion, double lmtPrice);
+
 protected:
 
 	virtual void prepareBufferImpl(std::ostream&) const = 0;
@@ -366,6 +390,15 @@ protected:
 	virtual bool closeAndSend(std::string msg, unsigned offset = 0) = 0;
 	virtual int bufferedSend(const std::string& msg);
 
+	// requests are encoded in place at the end of encodeBuffer(), see EMessageEncoder
+	virtual std::vector<char> &encodeBuffer() = 0;
+	virtual bool closeAndSend(EMessageEncoder &msg) = 0;
+
+	// requests sent between the two go out with a single write on endBatch(), which is false
+	// only when that write lost the connection
+	virtual void beginBatch() = 0;
+	virtual bool endBatch() = 0;
+
 
    	// encoders
 	template<class T> static void EncodeField(std::ostream&, T);
@@ -411,6 +444,7 @@ protected:
 	std::string m_TwsTime;
 
 private:
+	EOrderTemplate *m_pOrderCapture;    // set while prepareOrder() runs placeOrder()
 	std::string m_optionalCapabilities;
 
 	std::string m_connectOptions;
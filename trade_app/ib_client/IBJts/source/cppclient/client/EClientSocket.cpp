@@ -13,13 +13,17 @@
 #include "EReaderSignal.h"
 #include "EReader.h"
 #include "EMessage.h"
+#include "EMessageEncoder.h"
 
 #include <string.h>
+#include <stdio.h>
 #include <assert.h>
+#include <chrono>
 #include <ostream>
 
 
 const int MIN_SERVER_VER_SUPPORTED    = 38; //all supported server versions are defined in EDecoder.h
+const int HANDSHAKE_POLL_MS           = 100;
 
 ///////////////////////////////////////////////////////////
 // member funcs
@@ -30,6 +34,7 @@ EClientSocket::EClientSocket(EWrapper *ptr, EReaderSignal *pSignal) : EClient( p
     m_asyncEConnect = false;
     m_pSignal = pSignal;
     m_redirectCount = 0;
+    m_connectTimeoutMs = CONNECT_TIMEOUT_MS_DEFAULT;
 }
 
 EClientSocket::~EClientSocket()
@@ -54,6 +59,26 @@ void EClientSocket::asyncEConnect(bool val) {
     m_asyncEConnect = val;
 }
 
+int EClientSocket::connectTimeout() const {
+    return m_connectTimeoutMs;
+}
+
+void EClientSocket::connectTimeout(int ms) {
+    m_connectTimeoutMs = ms;
+}
+
+void EClientSocket::socketOptions(const SocketOptions &options) {
+    m_socketOptions = options;
+}
+
+const SocketOptions &EClientSocket::socketOptions() const {
+    return m_socketOptions;
+}
+
+const SocketOptions &EClientSocket::effectiveSocketOptions() const {
+    return m_effectiveSocketOptions;
+}
+
 bool EClientSocket::eConnect(const char *host, int port, int clientId, bool extraAuth)
 {
 	if( m_fd == -2) {
@@ -84,6 +109,13 @@ bool EClientSocket::eConnect(const char *host, int port, int clientId, bool extr
     return eConnectImpl( clientId, extraAuth, &resState);
 }
 
+bool EClientSocket::eConnect(const char *host, int port, int clientId, bool extraAuth, const SocketOptions &options)
+{
+	socketOptions(options);
+
+	return eConnect(host, port, clientId, extraAuth);
+}
+
 bool EClientSocket::eConnect(const char *host, unsigned int port, int clientId) {
     return eConnect(host, static_cast<int>(port), clientId);
 }
@@ -94,37 +126,164 @@ ESocket *EClientSocket::getTransport() {
     return static_cast<ESocket*>(m_transport.get());
 }
 
-bool EClientSocket::eConnectImpl(int clientId, bool extraAuth, ConnState* stateOutPt)
+int EClientSocket::openSocket()
 {
-	// resolve host
-	struct hostent* hostEnt = gethostbyname( host().c_str());
-	if ( !hostEnt) {
+	// resolve host, IPv4 or IPv6
+	struct addrinfo hints;
+	struct addrinfo *addrs = 0;
+	char service[16];
+
+	memset( &hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	snprintf( service, sizeof(service), "%d", port());
+
+	if ( getaddrinfo( host().c_str(), service, &hints, &addrs) != 0 || !addrs) {
 		getWrapper()->error( NO_VALID_ID, CONNECT_FAIL.code(), CONNECT_FAIL.msg());
-		return false;
+		return -1;
 	}
 
-	// create socket
-	m_fd = socket(AF_INET, SOCK_STREAM, 0);
+	int fd = -1;
+	bool created = false;
 
-	// cannot create socket
-	if( m_fd < 0) {
-		getWrapper()->error( NO_VALID_ID, FAIL_CREATE_SOCK.code(), FAIL_CREATE_SOCK.msg());
+	// try every address until one connects
+	for ( struct addrinfo *ai = addrs; ai && fd < 0; ai = ai->ai_next) {
+		fd = socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+		if ( fd < 0)
+			continue;
+
+		created = true;
+		applySocketOptions( fd, false);
+
+		if ( !connectSocket( fd, ai->ai_addr, (int)ai->ai_addrlen)) {
+			SocketClose( fd);
+			fd = -1;
+		}
+	}
+
+	freeaddrinfo( addrs);
+
+	if ( fd >= 0) {
+		applySocketOptions( fd, true);
+		readSocketOptions( fd);
+	}
+
+	if ( fd < 0) {
+		// cannot create socket
+		if ( !created)
+			getWrapper()->error( NO_VALID_ID, FAIL_CREATE_SOCK.code(), FAIL_CREATE_SOCK.msg());
+		else
+			getWrapper()->error( NO_VALID_ID, CONNECT_FAIL.code(), CONNECT_FAIL.msg());
+	}
+
+	return fd;
+}
+
+bool EClientSocket::connectSocket(int fd, const struct sockaddr *addr, int addrLen)
+{
+	// connect without blocking so an unresponsive host only costs the connect timeout
+	if ( !SetSocketNonBlocking( fd))
 		return false;
+
+	if ( connect( fd, addr, addrLen) < 0) {
+		if ( !SocketConnectPending())
+			return false;
+
+		fd_set writeSet, errorSet;
+		struct timeval tval;
+
+		FD_ZERO( &writeSet);
+		FD_ZERO( &errorSet);
+		FD_SET( fd, &writeSet);
+		FD_SET( fd, &errorSet);
+
+		tval.tv_sec = m_connectTimeoutMs / 1000;
+		tval.tv_usec = (m_connectTimeoutMs % 1000) * 1000;
+
+		if ( select( fd + 1, 0, &writeSet, &errorSet, m_connectTimeoutMs > 0 ? &tval : 0) <= 0)
+			return false;
+
+		int err = SocketPendingError( fd);
+
+		if ( err != 0) {
+			errno = err;
+			return false;
+		}
+
+		// connected: don't leave EINPROGRESS behind for handleSocketError() to report later
+		errno = 0;
 	}
 
-	// starting to connect to server
-	struct sockaddr_in sa;
-	memset( &sa, 0, sizeof(sa));
-	sa.sin_family = AF_INET;
-	sa.sin_port = htons( port());
-	sa.sin_addr.s_addr = ((in_addr*)hostEnt->h_addr)->s_addr;
-
-	// try to connect
-	if( (connect( m_fd, (struct sockaddr *) &sa, sizeof( sa))) < 0) {
-		// error connecting
-		SocketClose( m_fd);
+	// sendConnectRequest() expects a blocking socket, it is made non-blocking again after it
+	return SetSocketBlocking( fd);
+}
+
+static void SetIntSockOpt(int fd, int level, int name, int value)
+{
+	setsockopt( fd, level, name, (const char*)&value, sizeof(value));
+}
+
+static int GetIntSockOpt(int fd, int level, int name)
+{
+	int value = -1;
+	socklen_t len = sizeof(value);
+
+	if ( getsockopt( fd, level, name, (char*)&value, &len) != 0)
+		return -1;
+	return value;
+}
+
+void EClientSocket::applySocketOptions(int fd, bool connected)
+{
+	const SocketOptions &opt = m_socketOptions;
+
+	if ( !connected) {
+		// buffer sizes must be in place before the SYN to affect the window scale
+		if ( opt.rcvBuf >= 0)
+			SetIntSockOpt( fd, SOL_SOCKET, SO_RCVBUF, opt.rcvBuf);
+		if ( opt.sndBuf >= 0)
+			SetIntSockOpt( fd, SOL_SOCKET, SO_SNDBUF, opt.sndBuf);
+#if defined(__linux__)
+		if ( opt.priority >= 0)
+			SetIntSockOpt( fd, SOL_SOCKET, SO_PRIORITY, opt.priority);
+#endif
+		return;
+	}
+
+	SetIntSockOpt( fd, IPPROTO_TCP, TCP_NODELAY, opt.noDelay ? 1 : 0);
+#if defined(__linux__)
+	if ( opt.busyPollMicros >= 0)
+		SetIntSockOpt( fd, SOL_SOCKET, SO_BUSY_POLL, opt.busyPollMicros);
+	if ( opt.quickAck)
+		SetIntSockOpt( fd, IPPROTO_TCP, TCP_QUICKACK, 1);
+	if ( opt.rxTimestamps)
+		SetIntSockOpt( fd, SOL_SOCKET, SO_TIMESTAMPNS, 1);
+#endif
+}
+
+void EClientSocket::readSocketOptions(int fd)
+{
+	SocketOptions &eff = m_effectiveSocketOptions;
+
+	eff.noDelay = GetIntSockOpt( fd, IPPROTO_TCP, TCP_NODELAY) > 0;
+	eff.rcvBuf = GetIntSockOpt( fd, SOL_SOCKET, SO_RCVBUF);
+	eff.sndBuf = GetIntSockOpt( fd, SOL_SOCKET, SO_SNDBUF);
+#if defined(__linux__)
+	eff.busyPollMicros = GetIntSockOpt( fd, SOL_SOCKET, SO_BUSY_POLL);
+	eff.quickAck = GetIntSockOpt( fd, IPPROTO_TCP, TCP_QUICKACK) > 0;
+	eff.priority = GetIntSockOpt( fd, SOL_SOCKET, SO_PRIORITY);
+	eff.rxTimestamps = GetIntSockOpt( fd, SOL_SOCKET, SO_TIMESTAMPNS) > 0;
+#endif
+}
+
+bool EClientSocket::eConnectImpl(int clientId, bool extraAuth, ConnState* stateOutPt)
+{
+	m_fd = openSocket();
+
+	if( m_fd < 0) {
 		m_fd = -1;
-		getWrapper()->error( NO_VALID_ID, CONNECT_FAIL.code(), CONNECT_FAIL.msg());
 		return false;
 	}
 
@@ -165,12 +324,16 @@ bool EClientSocket::eConnectImpl(int clientId, bool extraAuth, ConnState* stateO
 
     if (!m_asyncEConnect) {
         EReader reader(this, m_pSignal);
-
-		reader.putMessageToQueue();
-
-        while (m_pSignal && !m_serverVersion && isSocketOK()) {
-            m_pSignal->waitForSignal();
-            reader.processMsgs();
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_connectTimeoutMs);
+
+        // the server version is read and decoded by the same non-blocking loop as any other message
+        while (!m_serverVersion && reader.pollOnce(HANDSHAKE_POLL_MS)) {
+            // a gateway that accepts but never answers must not hold us here forever
+            if (m_connectTimeoutMs > 0 && !m_serverVersion && std::chrono::steady_clock::now() >= deadline) {
+                eDisconnect();
+                getWrapper()->error( NO_VALID_ID, CONNECT_FAIL.code(), CONNECT_FAIL.msg());
+                return false;
+            }
         }
     }
 
@@ -181,18 +344,25 @@ bool EClientSocket::eConnectImpl(int clientId, bool extraAuth, ConnState* stateO
 void EClientSocket::encodeMsgLen(std::string& msg, unsigned offset) const
 {
 	assert( !msg.empty());
+	assert( msg.size() > offset + HEADER_LEN);
+
+	encodeMsgLen( &msg[offset], msg.size() - offset);
+}
+
+void EClientSocket::encodeMsgLen(char* header, size_t size) const
+{
 	assert( m_useV100Plus);
 
 	assert( sizeof(unsigned) == HEADER_LEN);
-	assert( msg.size() > offset + HEADER_LEN);
-	unsigned len = msg.size() - HEADER_LEN - offset;
+	assert( size > HEADER_LEN);
+	unsigned len = size - HEADER_LEN;
 	if( len > MAX_MSG_LEN) {
 		m_pEWrapper->error( NO_VALID_ID, BAD_LENGTH.code(), BAD_LENGTH.msg());
 		return;
 	}
 
 	unsigned netlen = htonl( len);
-	memcpy( &msg[offset], &netlen, HEADER_LEN);
+	memcpy( header, &netlen, HEADER_LEN);
 }
 
 bool EClientSocket::closeAndSend(std::string msg, unsigned offset)
@@ -208,6 +378,39 @@ bool EClientSocket::closeAndSend(std::string msg, unsigned offset)
     return true;
 }
 
+std::vector<char> &EClientSocket::encodeBuffer()
+{
+	return getTransport()->encodeBuffer();
+}
+
+bool EClientSocket::closeAndSend(EMessageEncoder &msg)
+{
+	msg.finish();
+	assert( msg.size() > 0);
+	if( m_useV100Plus) {
+		encodeMsgLen( msg.data(), msg.size());
+	}
+
+	if (getTransport()->sendEncoded() == -1)
+        return handleSocketError();
+
+    return true;
+}
+
+void EClientSocket::beginBatch()
+{
+	getTransport()->beginBatch();
+}
+
+bool EClientSocket::endBatch()
+{
+	// EWOULDBLOCK leaves the batch in the out buffer, the reader flushes it once the socket drains
+	if (getTransport()->endBatch() < 0)
+		handleSocketError();
+
+	return isSocketOK();
+}
+
 void EClientSocket::prepareBufferImpl(std::ostream& buf) const
 {
 	assert( m_useV100Plus);
@@ -248,11 +451,70 @@ int EClientSocket::fd() const
 }
 
 int EClientSocket::receive(char* buf, size_t sz)
+{
+	return receive( buf, sz, 0);
+}
+
+int EClientSocket::receive(char* buf, size_t sz, EReceiveTime *receiveTime)
 {
 	if( sz <= 0)
 		return 0;
 
-	int nResult = ::recv( m_fd, buf, sz, 0);
+	int nResult;
+
+#if defined(__linux__)
+	if( receiveTime && m_effectiveSocketOptions.rxTimestamps) {
+		struct iovec iov;
+		struct msghdr msg;
+		char control[CMSG_SPACE(sizeof(struct timespec))];
+
+		iov.iov_base = buf;
+		iov.iov_len = sz;
+		memset( &msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		nResult = ::recvmsg( m_fd, &msg, 0);
+
+		receiveTime->kernel = false;
+
+		for( struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); nResult > 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			if( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+				struct timespec ts;
+
+				memcpy( &ts, CMSG_DATA(cmsg), sizeof(ts));
+				receiveTime->nanos = (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+				receiveTime->kernel = true;
+			}
+		}
+	}
+	else
+#endif
+	{
+		nResult = ::recv( m_fd, buf, sz, 0);
+
+		if( receiveTime)
+			receiveTime->kernel = false;
+	}
+
+	if( nResult > 0 && receiveTime) {
+		long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+
+		// the kernel stamps on CLOCK_REALTIME: carry the stamp's age over to steady_clock, the
+		// clock of every other receive time (io_uring reads and reads without a stamp)
+		if( receiveTime->kernel) {
+			long long age = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count() - receiveTime->nanos;
+
+			if( age > 0)
+				now -= age;
+		}
+
+		receiveTime->nanos = now;
+	}
 
 	if( nResult == -1 && !handleSocketError()) {
 		return -1;
@@ -263,6 +525,11 @@ int EClientSocket::receive(char* buf, size_t sz)
 	if( nResult <= 0) {
 		return 0;
 	}
+#if defined(__linux__)
+	// the kernel drops back to delayed acks on its own, re-arm after every read
+	if( m_socketOptions.quickAck)
+		SetIntSockOpt( m_fd, IPPROTO_TCP, TCP_QUICKACK, 1);
+#endif
 	return nResult;
 }
 
@@ -9,9 +9,11 @@
 #include "EClient.h"
 #include "EClientMsgSink.h"
 #include "ESocket.h"
+#include "SocketOptions.h"
 
 class EWrapper;
 struct EReaderSignal;
+struct EReceiveTime;
 
 class TWSAPIDLLEXP EClientSocket : public EClient, public EClientMsgSink
 {
@@ -19,6 +21,8 @@ protected:
     virtual void prepareBufferImpl(std::ostream&) const;
 	virtual void prepareBuffer(std::ostream&) const;
 	virtual bool closeAndSend(std::string msg, unsigned offset = 0);
+	virtual std::vector<char> &encodeBuffer();
+	virtual bool closeAndSend(EMessageEncoder &msg);
 
 public:
 
@@ -26,6 +30,7 @@ public:
 	virtual ~EClientSocket();
 
 	bool eConnect( const char *host, int port, int clientId = 0, bool extraAuth = false);
+	bool eConnect( const char *host, int port, int clientId, bool extraAuth, const SocketOptions &options);
 	// override virtual funcs from EClient
 	bool eConnect(const char *host, unsigned int port, int clientId = 0);
 	void eDisconnect(bool resetState = true);
@@ -36,26 +41,44 @@ public:
     void asyncEConnect(bool val);
     ESocket *getTransport();
 
+    // requests issued between the two are flushed with one write on endBatch()
+    void beginBatch();
+    bool endBatch();
+
     void allowRedirect(bool v);
     bool allowRedirect() const; 
 
+    // bounds both the TCP connect and the wait for the server version, <= 0 waits forever
+    void connectTimeout(int ms);
+    int connectTimeout() const;
+
+    // used by the next eConnect()
+    void socketOptions(const SocketOptions &options);
+    const SocketOptions &socketOptions() const;
+    // what the kernel actually applied to the current connection
+    const SocketOptions &effectiveSocketOptions() const;
+
 private:
 
 	bool eConnectImpl(int clientId, bool extraAuth, ConnState* stateOutPt);
+	int openSocket();
+	bool connectSocket(int fd, const struct sockaddr *addr, int addrLen);
+	void applySocketOptions(int fd, bool connected);
+	void readSocketOptions(int fd);
 
 private:
 	void encodeMsgLen(std::string& msg, unsigned offset) const;
+	void encodeMsgLen(char* header, size_t size) const;
 public:
 	bool handleSocketError();
 	int receive( char* buf, size_t sz);
+	// also reports when the data arrived
+	int receive( char* buf, size_t sz, EReceiveTime *receiveTime);
 
 public:
 	// callback from socket
 	void onSend();
 	void onError();
-
-private:
-
 	void onClose();
 
 private:
@@ -65,8 +88,12 @@ private:
     bool m_asyncEConnect;
     EReaderSignal *m_pSignal;
     int m_redirectCount;
+    int m_connectTimeoutMs;
+    SocketOptions m_socketOptions;
+    SocketOptions m_effectiveSocketOptions;
 
     static const int REDIRECT_COUNT_MAX = 2;
+    static const int CONNECT_TIMEOUT_MS_DEFAULT = 10000;
 
 //EClientMsgSink implementation
 public:
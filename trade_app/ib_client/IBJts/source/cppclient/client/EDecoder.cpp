@@ -14,102 +14,115 @@
 #include "EClientMsgSink.h"
 #include "PriceIncrement.h"
 #include "EOrderDecoder.h"
+#include "EFieldScanner.h"
+#include "EVersionTier.h"
+#include "EMarketDataParser.h"
+#include "EWrapperView.h"
+#include "EHistoricalTickSink.h"
+#include "EOrderView.h"
 
 #include <string.h>
 #include <cstdlib>
+#include <float.h>
+#include <locale.h>
 #include <sstream>
 #include <assert.h>
 #include <string>
 #include <bitset>
 
 
-EDecoder::EDecoder(int serverVersion, EWrapper *callback, EClientMsgSink *clientMsgSink) {
-	m_pEWrapper = callback;
-	m_serverVersion = serverVersion;
-	m_pClientMsgSink = clientMsgSink;
-}
+// field ends of the message parseAndProcessMsg() is decoding on this thread
+static thread_local EFieldScanner *t_pFieldScanner = 0;
 
-const char* EDecoder::processTickPriceMsg(const char* ptr, const char* endPtr) {
-	int version;
-	int tickerId;
-	int tickTypeInt;
-	double price;
-
-	int size;
-	int attrMask;
-
-	DECODE_FIELD( version);
-	DECODE_FIELD( tickerId);
-	DECODE_FIELD( tickTypeInt);
-	DECODE_FIELD( price);
-	DECODE_FIELD( size); // ver 2 field
-	DECODE_FIELD( attrMask); // ver 3 field
-
-	TickAttrib attrib = {};
+namespace {
+	struct FieldScannerScope
+	{
+		EFieldScanner *m_pOuter;
 
-	attrib.canAutoExecute = attrMask == 1;
+		explicit FieldScannerScope(EFieldScanner *scanner) : m_pOuter(t_pFieldScanner) { t_pFieldScanner = scanner; }
+		~FieldScannerScope() { t_pFieldScanner = m_pOuter; }
+	};
 
-	if (m_serverVersion >= MIN_SERVER_VER_PAST_LIMIT)
+	// where EMarketDataParser hands the market data messages: the EWrapper, or the
+	// EWrapperView for the callbacks it covers
+	class EWrapperSink
 	{
-		std::bitset<32> mask(attrMask);
+		EWrapper *m_pEWrapper;
+		EWrapperView *m_pWrapperView;
 
-		attrib.canAutoExecute = mask[0];
-		attrib.pastLimit = mask[1];
+	public:
+		EWrapperSink(EWrapper *wrapper, EWrapperView *view) : m_pEWrapper(wrapper), m_pWrapperView(view) {}
 
-		if (m_serverVersion >= MIN_SERVER_VER_PRE_OPEN_BID_ASK)
-		{
-			attrib.preOpen = mask[2];
-		}
-	}
-
-	m_pEWrapper->tickPrice( tickerId, (TickType)tickTypeInt, price, attrib);
+		bool wantsTickByTick(int) const { return true; }
 
-	// process ver 2 fields
-	{
-		TickType sizeTickType = NOT_SET;
-		switch( (TickType)tickTypeInt) {
-		case BID:
-			sizeTickType = BID_SIZE;
-			break;
-		case ASK:
-			sizeTickType = ASK_SIZE;
-			break;
-		case LAST:
-			sizeTickType = LAST_SIZE;
-			break;
-		case DELAYED_BID:
-			sizeTickType = DELAYED_BID_SIZE;
-			break;
-		case DELAYED_ASK:
-			sizeTickType = DELAYED_ASK_SIZE;
-			break;
-		case DELAYED_LAST:
-			sizeTickType = DELAYED_LAST_SIZE;
-			break;
-		default:
-			break;
+		void tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attrib) {
+			m_pEWrapper->tickPrice( tickerId, field, price, attrib);
 		}
-		if( sizeTickType != NOT_SET)
-			m_pEWrapper->tickSize( tickerId, sizeTickType, size);
-	}
+		void tickSize(TickerId tickerId, TickType field, int size) {
+			m_pEWrapper->tickSize( tickerId, field, size);
+		}
+		void tickGeneric(TickerId tickerId, TickType tickType, double value) {
+			m_pEWrapper->tickGeneric( tickerId, tickType, value);
+		}
+		void tickString(TickerId tickerId, TickType tickType, const EStringView& value) {
+			if (m_pWrapperView)
+				m_pWrapperView->tickString( tickerId, tickType, value);
+			else
+				m_pEWrapper->tickString( tickerId, tickType, value.str());
+		}
+		void updateMktDepth(TickerId id, int position, int operation, int side, double price, int size) {
+			m_pEWrapper->updateMktDepth( id, position, operation, side, price, size);
+		}
+		void updateMktDepthL2(TickerId id, int position, const EStringView& marketMaker, int operation,
+			int side, double price, int size, bool isSmartDepth) {
+			if (m_pWrapperView)
+				m_pWrapperView->updateMktDepthL2( id, position, marketMaker, operation, side, price, size, isSmartDepth);
+			else
+				m_pEWrapper->updateMktDepthL2( id, position, marketMaker.str(), operation, side, price, size, isSmartDepth);
+		}
+		void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size, const TickAttribLast& attribs,
+			const EStringView& exchange, const EStringView& specialConditions) {
+			if (m_pWrapperView)
+				m_pWrapperView->tickByTickAllLast(reqId, tickType, time, price, size, attribs, exchange, specialConditions);
+			else
+				m_pEWrapper->tickByTickAllLast(reqId, tickType, time, price, size, attribs, exchange.str(), specialConditions.str());
+		}
+		void tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice, int bidSize, int askSize,
+			const TickAttribBidAsk& attribs) {
+			m_pEWrapper->tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, attribs);
+		}
+		void tickByTickMidPoint(int reqId, time_t time, double midPoint) {
+			m_pEWrapper->tickByTickMidPoint(reqId, time, midPoint);
+		}
+		void pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) {
+			m_pEWrapper->pnl(reqId, dailyPnL, unrealizedPnL, realizedPnL);
+		}
+		void pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {
+			m_pEWrapper->pnlSingle(reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
+		}
+	};
+}
 
-	return ptr;
+EDecoder::EDecoder(int serverVersion, EWrapper *callback, EClientMsgSink *clientMsgSink) {
+	m_pEWrapper = callback;
+	m_serverVersion = serverVersion;
+	m_pClientMsgSink = clientMsgSink;
+	m_pWrapperView = 0;
+	m_pTickSink = 0;
+	m_pOrderView = 0;
 }
 
-const char* EDecoder::processTickSizeMsg(const char* ptr, const char* endPtr) {
-	int version;
-	int tickerId;
-	int tickTypeInt;
-	int size;
+template<class Tier>
+const char* EDecoder::processTickPriceMsg(const char* ptr, const char* endPtr) {
+	EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-	DECODE_FIELD( version);
-	DECODE_FIELD( tickerId);
-	DECODE_FIELD( tickTypeInt);
-	DECODE_FIELD( size);
+	return EMarketDataParser::tickPrice<Tier>(sink, m_serverVersion, ptr, endPtr);
+}
 
-	m_pEWrapper->tickSize( tickerId, (TickType)tickTypeInt, size);
+const char* EDecoder::processTickSizeMsg(const char* ptr, const char* endPtr) {
+	EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-	return ptr;
+	return EMarketDataParser::tickSize(sink, ptr, endPtr);
 }
 
 const char* EDecoder::processTickOptionComputationMsg(const char* ptr, const char* endPtr) {
@@ -180,35 +193,15 @@ const char* EDecoder::processTickOptionComputationMsg(const char* ptr, const cha
 }
 
 const char* EDecoder::processTickGenericMsg(const char* ptr, const char* endPtr) {
-	int version;
-	int tickerId;
-	int tickTypeInt;
-	double value;
-
-	DECODE_FIELD( version);
-	DECODE_FIELD( tickerId);
-	DECODE_FIELD( tickTypeInt);
-	DECODE_FIELD( value);
-
-	m_pEWrapper->tickGeneric( tickerId, (TickType)tickTypeInt, value);
+	EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-	return ptr;
+	return EMarketDataParser::tickGeneric(sink, ptr, endPtr);
 }
 
 const char* EDecoder::processTickStringMsg(const char* ptr, const char* endPtr) {
-	int version;
-	int tickerId;
-	int tickTypeInt;
-	std::string value;
+	EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-	DECODE_FIELD( version);
-	DECODE_FIELD( tickerId);
-	DECODE_FIELD( tickTypeInt);
-	DECODE_FIELD( value);
-
-	m_pEWrapper->tickString( tickerId, (TickType)tickTypeInt, value);
-
-	return ptr;
+	return EMarketDataParser::tickString(sink, ptr, endPtr);
 }
 
 const char* EDecoder::processTickEfpMsg(const char* ptr, const char* endPtr) {
@@ -240,10 +233,13 @@ const char* EDecoder::processTickEfpMsg(const char* ptr, const char* endPtr) {
 	return ptr;
 }
 
+template<class Tier>
 const char* EDecoder::processOrderStatusMsg(const char* ptr, const char* endPtr) {
+    const int serverVersion = Tier::serverVersion(m_serverVersion);
+
     int version = INT_MAX;
 	int orderId;
-	std::string status;
+	EStringView status;
 	double filled;
 	double remaining;
 	double avgFillPrice;
@@ -251,9 +247,9 @@ const char* EDecoder::processOrderStatusMsg(const char* ptr, const char* endPtr)
 	int parentId;
 	double lastFillPrice;
 	int clientId;
-	std::string whyHeld;
+	EStringView whyHeld;
 
-    if (m_serverVersion < MIN_SERVER_VER_MARKET_CAP_PRICE) 
+    if (serverVersion < MIN_SERVER_VER_MARKET_CAP_PRICE) 
     {
 	    DECODE_FIELD( version);
     }
@@ -261,7 +257,7 @@ const char* EDecoder::processOrderStatusMsg(const char* ptr, const char* endPtr)
     DECODE_FIELD( orderId);
 	DECODE_FIELD( status);
 
-	if (m_serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS)
+	if (serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS)
 	{
 		DECODE_FIELD( filled);
 	}
@@ -274,7 +270,7 @@ const char* EDecoder::processOrderStatusMsg(const char* ptr, const char* endPtr)
 		filled = iFilled;
 	}
 
-	if (m_serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS)
+	if (serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS)
 	{
 		DECODE_FIELD( remaining);
 	}
@@ -297,13 +293,17 @@ const char* EDecoder::processOrderStatusMsg(const char* ptr, const char* endPtr)
 
 	double mktCapPrice = UNSET_DOUBLE;
 
-	if (m_serverVersion >= MIN_SERVER_VER_MARKET_CAP_PRICE)
+	if (serverVersion >= MIN_SERVER_VER_MARKET_CAP_PRICE)
 	{
 		DECODE_FIELD(mktCapPrice);
 	}
 
-	m_pEWrapper->orderStatus( orderId, status, filled, remaining,
-		avgFillPrice, permId, parentId, lastFillPrice, clientId, whyHeld, mktCapPrice);
+	if (m_pWrapperView)
+		m_pWrapperView->orderStatus( orderId, status, filled, remaining,
+			avgFillPrice, permId, parentId, lastFillPrice, clientId, whyHeld, mktCapPrice);
+	else
+		m_pEWrapper->orderStatus( orderId, status.str(), filled, remaining,
+			avgFillPrice, permId, parentId, lastFillPrice, clientId, whyHeld.str(), mktCapPrice);
 
 
 	return ptr;
@@ -313,14 +313,17 @@ const char* EDecoder::processErrMsgMsg(const char* ptr, const char* endPtr) {
 	int version;
 	int id; // ver 2 field
 	int errorCode; // ver 2 field
-	std::string errorMsg;
+	EStringView errorMsg;
 
 	DECODE_FIELD( version);
 	DECODE_FIELD( id);
 	DECODE_FIELD( errorCode);
 	DECODE_FIELD( errorMsg);
 
-	m_pEWrapper->error( id, errorCode, errorMsg);
+	if (m_pWrapperView)
+		m_pWrapperView->error( id, errorCode, errorMsg);
+	else
+		m_pEWrapper->error( id, errorCode, errorMsg.str());
 
 	return ptr;
 }
@@ -333,81 +336,24 @@ const char* EDecoder::processOpenOrderMsg(const char* ptr, const char* endPtr) {
 	    DECODE_FIELD(version);
     }
 
+	if (m_pOrderView) {
+		EOrderMessage message(ptr, endPtr, version, m_serverVersion, false);
+		OrderSummary summary;
+
+		if (!EOrderDecoder(0, 0, 0, version, m_serverVersion).summarizeOpenOrder(summary, ptr, endPtr))
+			return 0;
+
+		m_pOrderView->openOrder(summary, message);
+
+		return ptr;
+	}
+
 	Order order;
 	Contract contract;
 	OrderState orderState;
 	EOrderDecoder eOrderDecoder(&contract, &order, &orderState, version, m_serverVersion);
 
-	// read order id
-	eOrderDecoder.decodeOrderId(ptr, endPtr);
-
-	// read contract fields
-	eOrderDecoder.decodeContract(ptr, endPtr);
-
-	// read order fields
-	eOrderDecoder.decodeAction(ptr, endPtr);
-	eOrderDecoder.decodeTotalQuantity(ptr, endPtr);
-	eOrderDecoder.decodeOrderType(ptr, endPtr);
-	eOrderDecoder.decodeLmtPrice(ptr, endPtr);
-	eOrderDecoder.decodeAuxPrice(ptr, endPtr);
-	eOrderDecoder.decodeTIF(ptr, endPtr);
-	eOrderDecoder.decodeOcaGroup(ptr, endPtr);
-	eOrderDecoder.decodeAccount(ptr, endPtr);
-	eOrderDecoder.decodeOpenClose(ptr, endPtr);
-	eOrderDecoder.decodeOrigin(ptr, endPtr);
-	eOrderDecoder.decodeOrderRef(ptr, endPtr);
-	eOrderDecoder.decodeClientId(ptr, endPtr);
-	eOrderDecoder.decodePermId(ptr, endPtr);
-	eOrderDecoder.decodeOutsideRth(ptr, endPtr);
-	eOrderDecoder.decodeHidden(ptr, endPtr);
-	eOrderDecoder.decodeDiscretionaryAmount(ptr, endPtr);
-	eOrderDecoder.decodeGoodAfterTime(ptr, endPtr);
-	eOrderDecoder.skipSharesAllocation(ptr, endPtr);
-	eOrderDecoder.decodeFAParams(ptr, endPtr);
-	eOrderDecoder.decodeModelCode(ptr, endPtr);
-	eOrderDecoder.decodeGoodTillDate(ptr, endPtr);
-	eOrderDecoder.decodeRule80A(ptr, endPtr);
-	eOrderDecoder.decodePercentOffset(ptr, endPtr);
-	eOrderDecoder.decodeSettlingFirm(ptr, endPtr);
-	eOrderDecoder.decodeShortSaleParams(ptr, endPtr);
-	eOrderDecoder.decodeAuctionStrategy(ptr, endPtr);
-	eOrderDecoder.decodeBoxOrderParams(ptr, endPtr);
-	eOrderDecoder.decodePegToStkOrVolOrderParams(ptr, endPtr);
-	eOrderDecoder.decodeDisplaySize(ptr, endPtr);
-	eOrderDecoder.decodeBlockOrder(ptr, endPtr);
-	eOrderDecoder.decodeSweepToFill(ptr, endPtr);
-	eOrderDecoder.decodeAllOrNone(ptr, endPtr);
-	eOrderDecoder.decodeMinQty(ptr, endPtr);
-	eOrderDecoder.decodeOcaType(ptr, endPtr);
-	eOrderDecoder.decodeETradeOnly(ptr, endPtr);
-	eOrderDecoder.decodeFirmQuoteOnly(ptr, endPtr);
-	eOrderDecoder.decodeNbboPriceCap(ptr, endPtr);
-	eOrderDecoder.decodeParentId(ptr, endPtr);
-	eOrderDecoder.decodeTriggerMethod(ptr, endPtr);
-	eOrderDecoder.decodeVolOrderParams(ptr, endPtr, true);
-	eOrderDecoder.decodeTrailParams(ptr, endPtr);
-	eOrderDecoder.decodeBasisPoints(ptr, endPtr);
-	eOrderDecoder.decodeComboLegs(ptr, endPtr);
-	eOrderDecoder.decodeSmartComboRoutingParams(ptr, endPtr);
-	eOrderDecoder.decodeScaleOrderParams(ptr, endPtr);
-	eOrderDecoder.decodeHedgeParams(ptr, endPtr);
-	eOrderDecoder.decodeOptOutSmartRouting(ptr, endPtr);
-	eOrderDecoder.decodeClearingParams(ptr, endPtr);
-	eOrderDecoder.decodeNotHeld(ptr, endPtr);
-	eOrderDecoder.decodeDeltaNeutral(ptr, endPtr);
-	eOrderDecoder.decodeAlgoParams(ptr, endPtr);
-	eOrderDecoder.decodeSolicited(ptr, endPtr);
-	eOrderDecoder.decodeWhatIfInfoAndCommission(ptr, endPtr);
-	eOrderDecoder.decodeVolRandomizeFlags(ptr, endPtr);
-	eOrderDecoder.decodePegBenchParams(ptr, endPtr);
-	eOrderDecoder.decodeConditions(ptr, endPtr);
-	eOrderDecoder.decodeAdjustedOrderParams(ptr, endPtr);
-	eOrderDecoder.decodeSoftDollarTier(ptr, endPtr);
-	eOrderDecoder.decodeCashQty(ptr, endPtr);
-	eOrderDecoder.decodeDontUseAutoPriceForHedge(ptr, endPtr);
-	eOrderDecoder.decodeIsOmsContainer(ptr, endPtr);
-	eOrderDecoder.decodeDiscretionaryUpToLimitPrice(ptr, endPtr);
-	eOrderDecoder.decodeUsePriceMgmtAlgo(ptr, endPtr);
+	eOrderDecoder.decodeOpenOrder(ptr, endPtr);
 
 	m_pEWrapper->openOrder((OrderId)order.orderId, contract, order, orderState);
 
@@ -678,10 +624,13 @@ const char* EDecoder::processBondContractDataMsg(const char* ptr, const char* en
 	return ptr;
 }
 
+template<class Tier>
 const char* EDecoder::processExecutionDetailsMsg(const char* ptr, const char* endPtr) {
-    int version = m_serverVersion;
+    const int serverVersion = Tier::serverVersion(m_serverVersion);
 
-    if (m_serverVersion < MIN_SERVER_VER_LAST_LIQUIDITY) {
+    int version = serverVersion;
+
+    if (serverVersion < MIN_SERVER_VER_LAST_LIQUIDITY) {
 	    DECODE_FIELD(version);
     }
 
@@ -720,7 +669,7 @@ const char* EDecoder::processExecutionDetailsMsg(const char* ptr, const char* en
 	DECODE_FIELD( exec.exchange);
 	DECODE_FIELD( exec.side);
 
-	if (m_serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS) {
+	if (serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS) {
 		DECODE_FIELD( exec.shares)
 	} 
 	else {
@@ -749,11 +698,11 @@ const char* EDecoder::processExecutionDetailsMsg(const char* ptr, const char* en
 		DECODE_FIELD( exec.evRule);
 		DECODE_FIELD( exec.evMultiplier);
 	}
-	if( m_serverVersion >= MIN_SERVER_VER_MODELS_SUPPORT) {
+	if( serverVersion >= MIN_SERVER_VER_MODELS_SUPPORT) {
 		DECODE_FIELD( exec.modelCode);
 	}
 
-    if (m_serverVersion >= MIN_SERVER_VER_LAST_LIQUIDITY) {
+    if (serverVersion >= MIN_SERVER_VER_LAST_LIQUIDITY) {
         DECODE_FIELD(exec.lastLiquidity);
     }
 
@@ -763,55 +712,16 @@ const char* EDecoder::processExecutionDetailsMsg(const char* ptr, const char* en
 }
 
 const char* EDecoder::processMarketDepthMsg(const char* ptr, const char* endPtr) {
-	int version;
-	int id;
-	int position;
-	int operation;
-	int side;
-	double price;
-	int size;
-
-	DECODE_FIELD( version);
-	DECODE_FIELD( id);
-	DECODE_FIELD( position);
-	DECODE_FIELD( operation);
-	DECODE_FIELD( side);
-	DECODE_FIELD( price);
-	DECODE_FIELD( size);
+	EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-	m_pEWrapper->updateMktDepth( id, position, operation, side, price, size);
-
-	return ptr;
+	return EMarketDataParser::marketDepth(sink, ptr, endPtr);
 }
 
+template<class Tier>
 const char* EDecoder::processMarketDepthL2Msg(const char* ptr, const char* endPtr) {
-	int version;
-	int id;
-	int position;
-	std::string marketMaker;
-	int operation;
-	int side;
-	double price;
-	int size;
-	bool isSmartDepth = false;
-
-	DECODE_FIELD( version);
-	DECODE_FIELD( id);
-	DECODE_FIELD( position);
-	DECODE_FIELD( marketMaker);
-	DECODE_FIELD( operation);
-	DECODE_FIELD( side);
-	DECODE_FIELD( price);
-	DECODE_FIELD( size);
-
-	if( m_serverVersion >= MIN_SERVER_VER_SMART_DEPTH) {
-		DECODE_FIELD( isSmartDepth);
-	}
-
-	m_pEWrapper->updateMktDepthL2( id, position, marketMaker, operation, side,
-		price, size, isSmartDepth);
+	EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-	return ptr;
+	return EMarketDataParser::marketDepthL2<Tier>(sink, m_serverVersion, ptr, endPtr);
 }
 
 const char* EDecoder::processNewsBulletinsMsg(const char* ptr, const char* endPtr) {
@@ -1793,7 +1703,7 @@ const char* EDecoder::processSmartComponentsMsg(const char* ptr, const char* end
 const char* EDecoder::processTickReqParamsMsg(const char* ptr, const char* endPtr) {
 	int tickerId;
 	double minTick;
-	std::string bboExchange;
+	EStringView bboExchange;
 	int snapshotPermissions;
 
 	DECODE_FIELD(tickerId);
@@ -1801,7 +1711,10 @@ const char* EDecoder::processTickReqParamsMsg(const char* ptr, const char* endPt
 	DECODE_FIELD(bboExchange);
 	DECODE_FIELD(snapshotPermissions);
 
-	m_pEWrapper->tickReqParams(tickerId, minTick, bboExchange, snapshotPermissions);
+	if (m_pWrapperView)
+		m_pWrapperView->tickReqParams(tickerId, minTick, bboExchange, snapshotPermissions);
+	else
+		m_pEWrapper->tickReqParams(tickerId, minTick, bboExchange.str(), snapshotPermissions);
 	
 	return ptr;
 }
@@ -1867,58 +1780,25 @@ const char* EDecoder::processRerouteMktDepthReqMsg(const char* ptr, const char*
 	return ptr;
 }
 
+template<class Tier>
 const char* EDecoder::processPnLMsg(const char* ptr, const char* endPtr) {
-    int reqId;
-    double dailyPnL;
-    double unrealizedPnL = DBL_MAX;
-    double realizedPnL = DBL_MAX;
-
-    DECODE_FIELD(reqId)
-    DECODE_FIELD(dailyPnL)
-
-    if (m_serverVersion >= MIN_SERVER_VER_UNREALIZED_PNL) {
-        DECODE_FIELD(unrealizedPnL)
-    }
-
-    if (m_serverVersion >= MIN_SERVER_VER_REALIZED_PNL) {
-        DECODE_FIELD(realizedPnL)
-    }
+    EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-    m_pEWrapper->pnl(reqId, dailyPnL, unrealizedPnL, realizedPnL);
-    
-    return ptr;
+    return EMarketDataParser::pnl<Tier>(sink, m_serverVersion, ptr, endPtr);
 }
 
+template<class Tier>
 const char* EDecoder::processPnLSingleMsg(const char* ptr, const char* endPtr) {
-    int reqId;
-    int pos;
-    double dailyPnL;
-    double unrealizedPnL = DBL_MAX;
-    double realizedPnL = DBL_MAX;
-    double value;
+    EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-    DECODE_FIELD(reqId);
-    DECODE_FIELD(pos);
-    DECODE_FIELD(dailyPnL);
-
-    if (m_serverVersion >= MIN_SERVER_VER_UNREALIZED_PNL) {
-        DECODE_FIELD(unrealizedPnL)
-    }
-
-    if (m_serverVersion >= MIN_SERVER_VER_REALIZED_PNL) {
-        DECODE_FIELD(realizedPnL)
-    }
-
-    DECODE_FIELD(value);
-
-
-    m_pEWrapper->pnlSingle(reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
-
-    return ptr;
+    return EMarketDataParser::pnlSingle<Tier>(sink, m_serverVersion, ptr, endPtr);
 }
 
 template<typename T>
 const char* EDecoder::processHistoricalTicks(const char* ptr, const char* endPtr) {
+    if (m_pTickSink)
+        return processHistoricalTickColumns<T>(ptr, endPtr);
+
     int reqId, nTicks;
     bool done;
 
@@ -1994,6 +1874,94 @@ void EDecoder::callEWrapperCallBack(int reqId, const std::vector<HistoricalTickL
     m_pEWrapper->historicalTicksLast(reqId, ticks, done);
 }
 
+template<typename T>
+const char* EDecoder::processHistoricalTickColumns(const char* ptr, const char* endPtr) {
+    int reqId, nTicks;
+    bool done;
+
+    DECODE_FIELD(reqId);
+    DECODE_FIELD(nTicks);
+
+    int count = 0;
+
+    for (int i = 0; i < nTicks; i++) {
+        // a full chunk is passed on once another tick follows, so the last one carries done
+        if (count == EHistoricalTickSink::CHUNK_TICKS) {
+            callTickSink((const T*)0, reqId, count, false);
+            count = 0;
+        }
+
+        ptr = decodeTick((const T*)0, *m_pTickSink, count++, ptr, endPtr);
+        if (!ptr)
+            return 0;
+    }
+
+    DECODE_FIELD(done);
+
+    callTickSink((const T*)0, reqId, count, done);
+
+    return ptr;
+}
+
+const char* EDecoder::decodeTick(const HistoricalTick*, EHistoricalTickSink& sink, int i, const char* ptr, const char* endPtr) {
+    int nope;
+
+    DECODE_FIELD(sink.m_time[i]);
+    DECODE_FIELD(nope);
+    DECODE_FIELD(sink.m_price[i]);
+    DECODE_FIELD(sink.m_size[i]);
+
+    return ptr;
+}
+
+void EDecoder::callTickSink(const HistoricalTick*, int reqId, int count, bool done) {
+    HistoricalTickColumns ticks = { count, m_pTickSink->m_time, m_pTickSink->m_price, m_pTickSink->m_size };
+
+    m_pTickSink->historicalTicks(reqId, ticks, done);
+}
+
+const char* EDecoder::decodeTick(const HistoricalTickBidAsk*, EHistoricalTickSink& sink, int i, const char* ptr, const char* endPtr) {
+    DECODE_FIELD(sink.m_time[i]);
+    DECODE_FIELD(sink.m_attribMask[i]);
+    DECODE_FIELD(sink.m_price[i]);
+    DECODE_FIELD(sink.m_price2[i]);
+    DECODE_FIELD(sink.m_size[i]);
+    DECODE_FIELD(sink.m_size2[i]);
+
+    return ptr;
+}
+
+void EDecoder::callTickSink(const HistoricalTickBidAsk*, int reqId, int count, bool done) {
+    HistoricalTickBidAskColumns ticks = { count, m_pTickSink->m_time, m_pTickSink->m_attribMask,
+        m_pTickSink->m_price, m_pTickSink->m_price2, m_pTickSink->m_size, m_pTickSink->m_size2 };
+
+    m_pTickSink->historicalTicksBidAsk(reqId, ticks, done);
+}
+
+const char* EDecoder::decodeTick(const HistoricalTickLast*, EHistoricalTickSink& sink, int i, const char* ptr, const char* endPtr) {
+    EStringView exchange;
+    EStringView specialConditions;
+
+    DECODE_FIELD(sink.m_time[i]);
+    DECODE_FIELD(sink.m_attribMask[i]);
+    DECODE_FIELD(sink.m_price[i]);
+    DECODE_FIELD(sink.m_size[i]);
+    DECODE_FIELD(exchange);
+    DECODE_FIELD(specialConditions);
+
+    sink.m_exchange[i] = sink.m_names.intern(exchange);
+    sink.m_specialConditions[i] = sink.m_names.intern(specialConditions);
+
+    return ptr;
+}
+
+void EDecoder::callTickSink(const HistoricalTickLast*, int reqId, int count, bool done) {
+    HistoricalTickLastColumns ticks = { count, m_pTickSink->m_time, m_pTickSink->m_attribMask,
+        m_pTickSink->m_price, m_pTickSink->m_size, m_pTickSink->m_exchange, m_pTickSink->m_specialConditions };
+
+    m_pTickSink->historicalTicksLast(reqId, ticks, done);
+}
+
 const char* EDecoder::processHistoricalTicks(const char* ptr, const char* endPtr) {
     return processHistoricalTicks<HistoricalTick>(ptr, endPtr);
 }
@@ -2007,61 +1975,9 @@ const char* EDecoder::processHistoricalTicksLast(const char* ptr, const char* en
 }
 
 const char* EDecoder::processTickByTickDataMsg(const char* ptr, const char* endPtr) {
-    int reqId;
-    int tickType = 0;
-	time_t time;
-
-    DECODE_FIELD(reqId);
-    DECODE_FIELD(tickType);
-    DECODE_FIELD(time);
-
-    if (tickType == 1 || tickType == 2) { // Last/AllLast
-            double price;
-            int size;
-            int attrMask;
-            TickAttribLast tickAttribLast = {};
-            std::string exchange;
-            std::string specialConditions;
-
-            DECODE_FIELD(price);
-            DECODE_FIELD(size);
-            DECODE_FIELD(attrMask);
-
-            std::bitset<32> mask(attrMask);
-            tickAttribLast.pastLimit = mask[0];
-            tickAttribLast.unreported = mask[1];
-
-            DECODE_FIELD(exchange);
-            DECODE_FIELD(specialConditions);
-
-            m_pEWrapper->tickByTickAllLast(reqId, tickType, time, price, size, tickAttribLast, exchange, specialConditions);
-
-    } else if (tickType == 3) { // BidAsk
-            double bidPrice;
-            double askPrice;
-            int bidSize;
-            int askSize;
-            int attrMask;
-            DECODE_FIELD(bidPrice);
-            DECODE_FIELD(askPrice);
-            DECODE_FIELD(bidSize);
-            DECODE_FIELD(askSize);
-            DECODE_FIELD(attrMask);
-
-            TickAttribBidAsk tickAttribBidAsk = {};
-            std::bitset<32> mask(attrMask);
-            tickAttribBidAsk.bidPastLow = mask[0];
-            tickAttribBidAsk.askPastHigh = mask[1];
-
-            m_pEWrapper->tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, tickAttribBidAsk);
-    } else if (tickType == 4) { // MidPoint
-            double midPoint;
-            DECODE_FIELD(midPoint);
-
-            m_pEWrapper->tickByTickMidPoint(reqId, time, midPoint);
-    }
+    EWrapperSink sink(m_pEWrapper, m_pWrapperView);
 
-    return ptr;
+    return EMarketDataParser::tickByTick(sink, ptr, endPtr);
 }
 
 const char* EDecoder::processOrderBoundMsg(const char* ptr, const char* endPtr) {
@@ -2080,75 +1996,24 @@ const char* EDecoder::processOrderBoundMsg(const char* ptr, const char* endPtr)
 
 const char* EDecoder::processCompletedOrderMsg(const char* ptr, const char* endPtr) 
 {
+	if (m_pOrderView) {
+		EOrderMessage message(ptr, endPtr, UNSET_INTEGER, m_serverVersion, true);
+		OrderSummary summary;
+
+		if (!EOrderDecoder(0, 0, 0, UNSET_INTEGER, m_serverVersion).summarizeCompletedOrder(summary, ptr, endPtr))
+			return 0;
+
+		m_pOrderView->completedOrder(summary, message);
+
+		return ptr;
+	}
+
 	Order order;
 	Contract contract;
 	OrderState orderState;
 	EOrderDecoder eOrderDecoder(&contract, &order, &orderState, UNSET_INTEGER, m_serverVersion);
 
-	// read contract fields
-	eOrderDecoder.decodeContract(ptr, endPtr);
-
-	// read order fields
-	eOrderDecoder.decodeAction(ptr, endPtr);
-	eOrderDecoder.decodeTotalQuantity(ptr, endPtr);
-	eOrderDecoder.decodeOrderType(ptr, endPtr);
-	eOrderDecoder.decodeLmtPrice(ptr, endPtr);
-	eOrderDecoder.decodeAuxPrice(ptr, endPtr);
-	eOrderDecoder.decodeTIF(ptr, endPtr);
-	eOrderDecoder.decodeOcaGroup(ptr, endPtr);
-	eOrderDecoder.decodeAccount(ptr, endPtr);
-	eOrderDecoder.decodeOpenClose(ptr, endPtr);
-	eOrderDecoder.decodeOrigin(ptr, endPtr);
-	eOrderDecoder.decodeOrderRef(ptr, endPtr);
-	eOrderDecoder.decodePermId(ptr, endPtr);
-	eOrderDecoder.decodeOutsideRth(ptr, endPtr);
-	eOrderDecoder.decodeHidden(ptr, endPtr);
-	eOrderDecoder.decodeDiscretionaryAmount(ptr, endPtr);
-	eOrderDecoder.decodeGoodAfterTime(ptr, endPtr);
-	eOrderDecoder.decodeFAParams(ptr, endPtr);
-	eOrderDecoder.decodeModelCode(ptr, endPtr);
-	eOrderDecoder.decodeGoodTillDate(ptr, endPtr);
-	eOrderDecoder.decodeRule80A(ptr, endPtr);
-	eOrderDecoder.decodePercentOffset(ptr, endPtr);
-	eOrderDecoder.decodeSettlingFirm(ptr, endPtr);
-	eOrderDecoder.decodeShortSaleParams(ptr, endPtr);
-	eOrderDecoder.decodeBoxOrderParams(ptr, endPtr);
-	eOrderDecoder.decodePegToStkOrVolOrderParams(ptr, endPtr);
-	eOrderDecoder.decodeDisplaySize(ptr, endPtr);
-	eOrderDecoder.decodeSweepToFill(ptr, endPtr);
-	eOrderDecoder.decodeAllOrNone(ptr, endPtr);
-	eOrderDecoder.decodeMinQty(ptr, endPtr);
-	eOrderDecoder.decodeOcaType(ptr, endPtr);
-	eOrderDecoder.decodeTriggerMethod(ptr, endPtr);
-	eOrderDecoder.decodeVolOrderParams(ptr, endPtr, false);
-	eOrderDecoder.decodeTrailParams(ptr, endPtr);
-	eOrderDecoder.decodeComboLegs(ptr, endPtr);
-	eOrderDecoder.decodeSmartComboRoutingParams(ptr, endPtr);
-	eOrderDecoder.decodeScaleOrderParams(ptr, endPtr);
-	eOrderDecoder.decodeHedgeParams(ptr, endPtr);
-	eOrderDecoder.decodeClearingParams(ptr, endPtr);
-	eOrderDecoder.decodeNotHeld(ptr, endPtr);
-	eOrderDecoder.decodeDeltaNeutral(ptr, endPtr);
-	eOrderDecoder.decodeAlgoParams(ptr, endPtr);
-	eOrderDecoder.decodeSolicited(ptr, endPtr);
-	eOrderDecoder.decodeOrderStatus(ptr, endPtr);
-	eOrderDecoder.decodeVolRandomizeFlags(ptr, endPtr);
-	eOrderDecoder.decodePegBenchParams(ptr, endPtr);
-	eOrderDecoder.decodeConditions(ptr, endPtr);
-	eOrderDecoder.decodeStopPriceAndLmtPriceOffset(ptr, endPtr);
-	eOrderDecoder.decodeCashQty(ptr, endPtr);
-	eOrderDecoder.decodeDontUseAutoPriceForHedge(ptr, endPtr);
-	eOrderDecoder.decodeIsOmsContainer(ptr, endPtr);
-	eOrderDecoder.decodeAutoCancelDate(ptr, endPtr);
-	eOrderDecoder.decodeFilledQuantity(ptr, endPtr);
-	eOrderDecoder.decodeRefFuturesConId(ptr, endPtr);
-	eOrderDecoder.decodeAutoCancelParent(ptr, endPtr);
-	eOrderDecoder.decodeShareholder(ptr, endPtr);
-	eOrderDecoder.decodeImbalanceOnly(ptr, endPtr);
-	eOrderDecoder.decodeRouteMarketableToBbo(ptr, endPtr);
-	eOrderDecoder.decodeParentPermId(ptr, endPtr);
-	eOrderDecoder.decodeCompletedTime(ptr, endPtr);
-	eOrderDecoder.decodeCompletedStatus(ptr, endPtr);
+	eOrderDecoder.decodeCompletedOrder(ptr, endPtr);
 
 	m_pEWrapper->completedOrder(contract, order, orderState);
 
@@ -2168,6 +2033,9 @@ int EDecoder::parseAndProcessMsg(const char*& beginPtr, const char* endPtr) {
 
 	assert( beginPtr && beginPtr < endPtr);
 
+	EFieldScanner scanner(beginPtr, endPtr);
+	FieldScannerScope scannerScope(&scanner);
+
 	if (m_serverVersion == 0)
 		return processConnectAck(beginPtr, endPtr);
 
@@ -2178,9 +2046,12 @@ int EDecoder::parseAndProcessMsg(const char*& beginPtr, const char* endPtr) {
 		int msgId;
 		DECODE_FIELD( msgId);
 
+		// hot messages run the instantiation for the negotiated version tier, see EVersionTier.h
+		const bool latest = IsLatestVersion(m_serverVersion);
+
 		switch( msgId) {
 		case TICK_PRICE:
-			ptr = processTickPriceMsg(ptr, endPtr);
+			ptr = latest ? processTickPriceMsg<EVersionLatest>(ptr, endPtr) : processTickPriceMsg<EVersionAny>(ptr, endPtr);
 			break;
 
 		case TICK_SIZE:
@@ -2204,7 +2075,7 @@ int EDecoder::parseAndProcessMsg(const char*& beginPtr, const char* endPtr) {
 			break;
 
 		case ORDER_STATUS:
-			ptr = processOrderStatusMsg(ptr, endPtr);
+			ptr = latest ? processOrderStatusMsg<EVersionLatest>(ptr, endPtr) : processOrderStatusMsg<EVersionAny>(ptr, endPtr);
 			break;
 
 		case ERR_MSG:
@@ -2240,7 +2111,7 @@ int EDecoder::parseAndProcessMsg(const char*& beginPtr, const char* endPtr) {
 			break;
 
 		case EXECUTION_DATA:
-			ptr = processExecutionDetailsMsg(ptr, endPtr);
+			ptr = latest ? processExecutionDetailsMsg<EVersionLatest>(ptr, endPtr) : processExecutionDetailsMsg<EVersionAny>(ptr, endPtr);
 			break;
 
 		case MARKET_DEPTH:
@@ -2248,7 +2119,7 @@ int EDecoder::parseAndProcessMsg(const char*& beginPtr, const char* endPtr) {
 			break;
 
 		case MARKET_DEPTH_L2:
-			ptr = processMarketDepthL2Msg(ptr, endPtr);
+			ptr = latest ? processMarketDepthL2Msg<EVersionLatest>(ptr, endPtr) : processMarketDepthL2Msg<EVersionAny>(ptr, endPtr);
 			break;
 
 		case NEWS_BULLETINS:
@@ -2452,11 +2323,11 @@ int EDecoder::parseAndProcessMsg(const char*& beginPtr, const char* endPtr) {
 			break;
 
         case PNL:
-            ptr = processPnLMsg(ptr, endPtr);
+            ptr = latest ? processPnLMsg<EVersionLatest>(ptr, endPtr) : processPnLMsg<EVersionAny>(ptr, endPtr);
             break;
 
         case PNL_SINGLE:
-            ptr = processPnLSingleMsg(ptr, endPtr);
+            ptr = latest ? processPnLSingleMsg<EVersionLatest>(ptr, endPtr) : processPnLSingleMsg<EVersionAny>(ptr, endPtr);
             break;
 
 		case HISTORICAL_TICKS:
@@ -2515,8 +2386,165 @@ bool EDecoder::CheckOffset(const char* ptr, const char* endPtr)
 	return (ptr && ptr < endPtr);
 }
 
+// Numeric fields are parsed between the field start and its NUL, without the C library's
+// locale lookups or a second scan for the terminator. Anything the fast paths do not fully
+// understand (stray characters, too many digits, huge exponents, inf/nan) goes through the
+// C library parser instead, so results match atoi/atoll/atof on every input.
+
+#define FAST_INTEGER_DIGITS_MAX 18    // always fits a long long
+#define FAST_DECIMAL_DIGITS_MAX 19    // significant digits that always fit a uint64
+#define FAST_DECIMAL_EXACT_MANTISSA (1ULL << 53)
+#define FAST_DECIMAL_EXACT_POW10 22
+
+static bool ParseInteger(const char* begin, const char* end, long long& value)
+{
+	const char* p = begin;
+	bool negative = false;
+
+	if (p != end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	if (end - p > FAST_INTEGER_DIGITS_MAX)
+		return false;
+
+	long long result = 0;
+
+	for (; p != end; ++p) {
+		unsigned digit = (unsigned char)*p - '0';
+
+		if (digit > 9)
+			return false;
+
+		result = result * 10 + digit;
+	}
+
+	value = negative ? -result : result;
+	return true;
+}
+
+static bool ParseDecimal(const char* begin, const char* end, double& value)
+{
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD != 0
+	// extended precision intermediates (x87) would round twice
+	return false;
+#else
+	static const double pow10[FAST_DECIMAL_EXACT_POW10 + 1] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	const char* p = begin;
+	bool negative = false;
+
+	if (p != end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool anyDigit = false;
+
+	for (; p != end && (unsigned)(*p - '0') <= 9; ++p) {
+		anyDigit = true;
+		if (mantissa == 0 && *p == '0')
+			continue;
+		if (++digits > FAST_DECIMAL_DIGITS_MAX)
+			return false;
+		mantissa = mantissa * 10 + (*p - '0');
+	}
+
+	if (p != end && *p == '.') {
+		for (++p; p != end && (unsigned)(*p - '0') <= 9; ++p) {
+			anyDigit = true;
+			--exponent;
+			if (mantissa == 0 && *p == '0')
+				continue;
+			if (++digits > FAST_DECIMAL_DIGITS_MAX)
+				return false;
+			mantissa = mantissa * 10 + (*p - '0');
+		}
+	}
+
+	if (!anyDigit) {
+		// an empty field is 0, like atof(""); a lone sign or '.' is left to the fallback
+		if (begin != end)
+			return false;
+		value = 0;
+		return true;
+	}
+
+	if (p != end && (*p == 'e' || *p == 'E')) {
+		long long explicitExponent;
+
+		if (!ParseInteger(p + 1, end, explicitExponent) || p + 1 == end)
+			return false;
+		if (explicitExponent > 1000 || explicitExponent < -1000)
+			return false;
+		exponent += (int)explicitExponent;
+		p = end;
+	}
+
+	if (p != end || mantissa > FAST_DECIMAL_EXACT_MANTISSA)
+		return false;
+
+	// both operands are exact, so the single multiply or divide rounds correctly (Clinger)
+	double result = (double)mantissa;
+
+	if (mantissa == 0 || exponent == 0)
+		;
+	else if (exponent > 0 && exponent <= FAST_DECIMAL_EXACT_POW10)
+		result *= pow10[exponent];
+	else if (exponent < 0 && exponent >= -FAST_DECIMAL_EXACT_POW10)
+		result /= pow10[-exponent];
+	else
+		return false;
+
+	value = negative ? -result : result;
+	return true;
+#endif
+}
+
+static double ParseDecimalSlow(const char* begin, const char* end)
+{
+	// the wire always uses '.', strtod() wants the current locale's decimal point
+	char buf[64];
+	size_t len = end - begin;
+	const char* point = localeconv()->decimal_point;
+
+	if (len >= sizeof(buf) || !point || point[0] == '.' || point[0] == 0 || point[1] != 0)
+		return atof(begin);
+
+	memcpy(buf, begin, len);
+	buf[len] = 0;
+
+	char* dot = (char*)memchr(buf, '.', len);
+
+	if (dot)
+		*dot = point[0];
+
+	return strtod(buf, 0);
+}
+
+static long long DecodeInteger(const char* fieldBeg, const char* fieldEnd)
+{
+	long long value;
+
+	return ParseInteger(fieldBeg, fieldEnd, value) ? value : atoll(fieldBeg);
+}
+
+static double DecodeDecimal(const char* fieldBeg, const char* fieldEnd)
+{
+	double value;
+
+	return ParseDecimal(fieldBeg, fieldEnd, value) ? value : ParseDecimalSlow(fieldBeg, fieldEnd);
+}
+
 const char* EDecoder::FindFieldEnd(const char* ptr, const char* endPtr)
 {
+	EFieldScanner *scanner = t_pFieldScanner;
+
+	if (scanner && scanner->covers(ptr, endPtr))
+		return scanner->next(ptr);
+
 	return (const char*)memchr(ptr, 0, endPtr - ptr);
 }
 
@@ -2537,7 +2565,7 @@ bool EDecoder::DecodeField(int& intValue, const char*& ptr, const char* endPtr)
 	const char* fieldEnd = FindFieldEnd(fieldBeg, endPtr);
 	if( !fieldEnd)
 		return false;
-	intValue = atoi(fieldBeg);
+	intValue = (int)DecodeInteger(fieldBeg, fieldEnd);
 	ptr = ++fieldEnd;
 	return true;
 }
@@ -2550,7 +2578,7 @@ bool EDecoder::DecodeFieldTime(time_t& time_tValue, const char*& ptr, const char
 	const char* fieldEnd = FindFieldEnd(fieldBeg, endPtr);
 	if( !fieldEnd)
 		return false;
-	time_tValue = atoll(fieldBeg);
+	time_tValue = (time_t)DecodeInteger(fieldBeg, fieldEnd);
 	ptr = ++fieldEnd;
 	return true;
 }
@@ -2563,7 +2591,7 @@ bool EDecoder::DecodeField(long long& longLongValue, const char*& ptr, const cha
 	const char* fieldEnd = FindFieldEnd(fieldBeg, endPtr);
 	if( !fieldEnd)
 		return false;
-	longLongValue = atoll(fieldBeg);
+	longLongValue = DecodeInteger(fieldBeg, fieldEnd);
 	ptr = ++fieldEnd;
 	return true;
 }
@@ -2576,7 +2604,7 @@ bool EDecoder::DecodeField(long& longValue, const char*& ptr, const char* endPtr
 	const char* fieldEnd = FindFieldEnd(fieldBeg, endPtr);
 	if( !fieldEnd)
 		return false;
-	longValue = atol(fieldBeg);
+	longValue = (long)DecodeInteger(fieldBeg, fieldEnd);
 	ptr = ++fieldEnd;
 	return true;
 }
@@ -2589,7 +2617,7 @@ bool EDecoder::DecodeField(double& doubleValue, const char*& ptr, const char* en
 	const char* fieldEnd = FindFieldEnd(fieldBeg, endPtr);
 	if( !fieldEnd)
 		return false;
-	doubleValue = atof(fieldBeg);
+	doubleValue = DecodeDecimal(fieldBeg, fieldEnd);
 	ptr = ++fieldEnd;
 	return true;
 }
@@ -2622,12 +2650,30 @@ bool EDecoder::DecodeField(char& charValue,
 	return true;
 }
 
+bool EDecoder::DecodeField(EStringView& stringValue,
+						   const char*& ptr, const char* endPtr)
+{
+	if( !CheckOffset(ptr, endPtr))
+		return false;
+	const char* fieldBeg = ptr;
+	const char* fieldEnd = FindFieldEnd(ptr, endPtr);
+	if( !fieldEnd)
+		return false;
+	stringValue = EStringView(fieldBeg, fieldEnd - fieldBeg);
+	ptr = ++fieldEnd;
+	return true;
+}
+
 bool EDecoder::DecodeFieldMax(int& intValue, const char*& ptr, const char* endPtr)
 {
-	std::string stringValue;
-	if( !DecodeField(stringValue, ptr, endPtr))
+	if( !CheckOffset(ptr, endPtr))
+		return false;
+	const char* fieldBeg = ptr;
+	const char* fieldEnd = FindFieldEnd(fieldBeg, endPtr);
+	if( !fieldEnd)
 		return false;
-	intValue = stringValue.empty() ? UNSET_INTEGER : atoi(stringValue.c_str());
+	intValue = fieldEnd == fieldBeg ? UNSET_INTEGER : (int)DecodeInteger(fieldBeg, fieldEnd);
+	ptr = ++fieldEnd;
 	return true;
 }
 
@@ -2642,10 +2688,14 @@ bool EDecoder::DecodeFieldMax(long& longValue, const char*& ptr, const char* end
 
 bool EDecoder::DecodeFieldMax(double& doubleValue, const char*& ptr, const char* endPtr)
 {
-	std::string stringValue;
-	if( !DecodeField(stringValue, ptr, endPtr))
+	if( !CheckOffset(ptr, endPtr))
+		return false;
+	const char* fieldBeg = ptr;
+	const char* fieldEnd = FindFieldEnd(fieldBeg, endPtr);
+	if( !fieldEnd)
 		return false;
-	doubleValue = stringValue.empty() ? UNSET_DOUBLE : atof(stringValue.c_str());
+	doubleValue = fieldEnd == fieldBeg ? UNSET_DOUBLE : DecodeDecimal(fieldBeg, fieldEnd);
+	ptr = ++fieldEnd;
 	return true;
 }
 
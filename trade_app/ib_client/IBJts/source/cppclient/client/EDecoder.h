@@ -230,6 +230,10 @@ struct ScanData {
 } // end of anonymous namespace
 
 class EWrapper;
+class EWrapperView;
+class EStringView;
+class EHistoricalTickSink;
+class EOrderView;
 struct EClientMsgSink;
 
 class TWSAPIDLLEXP EDecoder
@@ -237,14 +241,17 @@ class TWSAPIDLLEXP EDecoder
     EWrapper *m_pEWrapper;
     int m_serverVersion;
     EClientMsgSink *m_pClientMsgSink;
+    EWrapperView *m_pWrapperView;
+    EHistoricalTickSink *m_pTickSink;
+    EOrderView *m_pOrderView;
 
-    const char* processTickPriceMsg(const char* ptr, const char* endPtr);
+    template<class Tier> const char* processTickPriceMsg(const char* ptr, const char* endPtr);
     const char* processTickSizeMsg(const char* ptr, const char* endPtr);
     const char* processTickOptionComputationMsg(const char* ptr, const char* endPtr);
     const char* processTickGenericMsg(const char* ptr, const char* endPtr);
     const char* processTickStringMsg(const char* ptr, const char* endPtr);
     const char* processTickEfpMsg(const char* ptr, const char* endPtr);
-    const char* processOrderStatusMsg(const char* ptr, const char* endPtr);
+    template<class Tier> const char* processOrderStatusMsg(const char* ptr, const char* endPtr);
     const char* processErrMsgMsg(const char* ptr, const char* endPtr);
     const char* processOpenOrderMsg(const char* ptr, const char* endPtr);
     const char* processAcctValueMsg(const char* ptr, const char* endPtr);
@@ -253,9 +260,9 @@ class TWSAPIDLLEXP EDecoder
     const char* processNextValidIdMsg(const char* ptr, const char* endPtr);
     const char* processContractDataMsg(const char* ptr, const char* endPtr);
     const char* processBondContractDataMsg(const char* ptr, const char* endPtr);
-    const char* processExecutionDetailsMsg(const char* ptr, const char* endPtr);
+    template<class Tier> const char* processExecutionDetailsMsg(const char* ptr, const char* endPtr);
     const char* processMarketDepthMsg(const char* ptr, const char* endPtr);
-    const char* processMarketDepthL2Msg(const char* ptr, const char* endPtr);
+    template<class Tier> const char* processMarketDepthL2Msg(const char* ptr, const char* endPtr);
     const char* processNewsBulletinsMsg(const char* ptr, const char* endPtr);
     const char* processManagedAcctsMsg(const char* ptr, const char* endPtr);
     const char* processReceiveFaMsg(const char* ptr, const char* endPtr);
@@ -306,8 +313,8 @@ class TWSAPIDLLEXP EDecoder
 	const char* processRerouteMktDataReqMsg(const char* ptr, const char* endPtr);
 	const char* processRerouteMktDepthReqMsg(const char* ptr, const char* endPtr);
 	const char* processMarketRuleMsg(const char* ptr, const char* endPtr);
-    const char* processPnLMsg(const char* ptr, const char* endPtr);
-    const char* processPnLSingleMsg(const char* ptr, const char* endPtr);
+    template<class Tier> const char* processPnLMsg(const char* ptr, const char* endPtr);
+    template<class Tier> const char* processPnLSingleMsg(const char* ptr, const char* endPtr);
     const char* processHistoricalTicks(const char* ptr, const char* endPtr);
     const char* processHistoricalTicksBidAsk(const char* ptr, const char* endPtr);
     const char* processHistoricalTicksLast(const char* ptr, const char* endPtr);
@@ -326,6 +333,13 @@ class TWSAPIDLLEXP EDecoder
     void callEWrapperCallBack(int reqId, const std::vector<HistoricalTickBidAsk> &ticks, bool done);
     void callEWrapperCallBack(int reqId, const std::vector<HistoricalTickLast> &ticks, bool done);
     template<typename T> const char* processHistoricalTicks(const char* ptr, const char* endPtr);
+    static const char* decodeTick(const HistoricalTick*, EHistoricalTickSink& sink, int i, const char* ptr, const char* endPtr);
+    static const char* decodeTick(const HistoricalTickBidAsk*, EHistoricalTickSink& sink, int i, const char* ptr, const char* endPtr);
+    static const char* decodeTick(const HistoricalTickLast*, EHistoricalTickSink& sink, int i, const char* ptr, const char* endPtr);
+    void callTickSink(const HistoricalTick*, int reqId, int count, bool done);
+    void callTickSink(const HistoricalTickBidAsk*, int reqId, int count, bool done);
+    void callTickSink(const HistoricalTickLast*, int reqId, int count, bool done);
+    template<typename T> const char* processHistoricalTickColumns(const char* ptr, const char* endPtr);
 
 	const char* decodeLastTradeDate(const char* ptr, const char* endPtr, ContractDetails& contract, bool isBond);
 
@@ -340,6 +354,7 @@ public:
     static bool DecodeField(double&, const char*& ptr, const char* endPtr);
     static bool DecodeField(std::string&, const char*& ptr, const char* endPtr);
     static bool DecodeField(char&, const char*& ptr, const char* endPtr);
+    static bool DecodeField(EStringView&, const char*& ptr, const char* endPtr);
 
     static bool DecodeFieldTime(time_t&, const char*& ptr, const char* endPtr);
 
@@ -350,6 +365,20 @@ public:
     EDecoder(int serverVersion, EWrapper *callback, EClientMsgSink *clientMsgSink = 0);
 
     int parseAndProcessMsg(const char*& beginPtr, const char* endPtr);
+
+    int serverVersion() const { return m_serverVersion; }
+
+    // messages EWrapperView covers go there instead of to the EWrapper, 0 restores that
+    void wrapperView(EWrapperView *view) { m_pWrapperView = view; }
+    EWrapperView *wrapperView() const { return m_pWrapperView; }
+
+    // historical ticks go to sink in columnar chunks instead of to the EWrapper, 0 restores that
+    void historicalTickSink(EHistoricalTickSink *sink) { m_pTickSink = sink; }
+    EHistoricalTickSink *historicalTickSink() const { return m_pTickSink; }
+
+    // open and completed orders go to view as summaries instead of to the EWrapper, 0 restores that
+    void orderView(EOrderView *view) { m_pOrderView = view; }
+    EOrderView *orderView() const { return m_pOrderView; }
 };
 
 #define DECODE_FIELD(x) if (!EDecoder::DecodeField(x, ptr, endPtr)) return 0;
@@ -0,0 +1,122 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EFIELDSCANNER_H
+#define TWS_API_CLIENT_EFIELDSCANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "platformspecific.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IBAPI_FIELD_SCAN_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Finds the NUL terminators of a message's fields. The message is swept 64 bytes at a time
+// into a bitmap of NUL positions, so the field ends of a whole block come out of one pass
+// (four SSE2 compares where available) and each lookup is a mask and a count of trailing
+// zeros instead of a scan. Blocks are swept on demand as the decoder moves forward, which
+// keeps the cost bounded when endPtr is far past the message (legacy framing hands the
+// decoder the whole receive buffer).
+class EFieldScanner
+{
+    enum { BLOCK_SIZE = 64 };
+
+    const char *m_end;
+    const char *m_block;   // start of the block m_mask describes
+    uint64_t m_mask;       // bit i set when m_block[i] is NUL
+
+    static unsigned CountTrailingZeros(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return index;
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, (unsigned long)mask))
+            return index;
+        _BitScanForward(&index, (unsigned long)(mask >> 32));
+        return index + 32;
+#else
+        return (unsigned)__builtin_ctzll(mask);
+#endif
+    }
+
+    static uint64_t ScanBlock(const char *block, const char *end) {
+        size_t n = (size_t)(end - block);
+        uint64_t mask = 0;
+        size_t i = 0;
+
+#if defined(IBAPI_FIELD_SCAN_SSE2)
+        if (n >= BLOCK_SIZE) {
+            const __m128i zero = _mm_setzero_si128();
+
+            for (; i < BLOCK_SIZE; i += 16) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+
+                mask |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero)) << i;
+            }
+
+            return mask;
+        }
+#endif
+        if (n > BLOCK_SIZE)
+            n = BLOCK_SIZE;
+
+        for (; i < n; ++i)
+            mask |= (uint64_t)(block[i] == 0) << i;
+
+        return mask;
+    }
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EFieldScanner(const EFieldScanner&);
+    EFieldScanner& operator=(const EFieldScanner&);
+
+public:
+    EFieldScanner(const char *begin, const char *end)
+        : m_end(end)
+        , m_block(begin)
+        , m_mask(ScanBlock(begin, end))
+    {
+    }
+
+    // whether next() can serve a lookup from ptr to endPtr
+    bool covers(const char *ptr, const char *endPtr) const {
+        return endPtr == m_end && ptr >= m_block && ptr < m_end;
+    }
+
+    // first NUL at or after ptr, 0 if there is none before the end
+    const char *next(const char *ptr) {
+        size_t offset = (size_t)(ptr - m_block);
+
+        if (offset >= BLOCK_SIZE) {
+            // fields were skipped without a lookup, jump to the block holding ptr
+            m_block += offset & ~(size_t)(BLOCK_SIZE - 1);
+            m_mask = ScanBlock(m_block, m_end);
+            offset &= BLOCK_SIZE - 1;
+        }
+
+        for (;;) {
+            uint64_t mask = m_mask & (~(uint64_t)0 << offset);
+
+            if (mask)
+                return m_block + CountTrailingZeros(mask);
+
+            if (m_end - m_block <= BLOCK_SIZE)
+                return 0;
+
+            m_block += BLOCK_SIZE;
+            m_mask = ScanBlock(m_block, m_end);
+            offset = 0;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,86 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EHISTORICALTICKSINK_H
+#define TWS_API_CLIENT_EHISTORICALTICKSINK_H
+
+#include "platformspecific.h"
+#include "EStringInterner.h"
+
+// One chunk of a historical ticks response, one array per field, count entries each. The
+// arrays belong to the EHistoricalTickSink and are overwritten by the next chunk.
+struct HistoricalTickColumns
+{
+    int count;
+    const long long *time;
+    const double *price;
+    const long long *size;
+};
+
+// attribMask as sent: bit 0 askPastHigh, bit 1 bidPastLow
+struct HistoricalTickBidAskColumns
+{
+    int count;
+    const long long *time;
+    const int *attribMask;
+    const double *priceBid;
+    const double *priceAsk;
+    const long long *sizeBid;
+    const long long *sizeAsk;
+};
+
+// attribMask as sent: bit 0 pastLimit, bit 1 unreported. exchange and specialConditions are
+// ids of EHistoricalTickSink::names().
+struct HistoricalTickLastColumns
+{
+    int count;
+    const long long *time;
+    const int *attribMask;
+    const double *price;
+    const long long *size;
+    const int *exchange;
+    const int *specialConditions;
+};
+
+// Opt-in columnar delivery of historical ticks. Once a sink is installed
+// (EReader::historicalTickSink()), HISTORICAL_TICKS, HISTORICAL_TICKS_BID_ASK and
+// HISTORICAL_TICKS_LAST are decoded straight into the sink's fixed arrays and handed over in
+// chunks of at most CHUNK_TICKS, instead of as a std::vector to the EWrapper, so a response
+// costs no allocation per tick. A message spans one or more chunks; all but its last are
+// passed with done false, the last with the message's done flag.
+class TWSAPIDLLEXP EHistoricalTickSink
+{
+public:
+    enum { CHUNK_TICKS = 256 };
+
+private:
+    friend class EDecoder;
+
+    EStringInterner m_names;
+    long long m_time[CHUNK_TICKS];
+    int m_attribMask[CHUNK_TICKS];
+    double m_price[CHUNK_TICKS];         // price, priceBid
+    double m_price2[CHUNK_TICKS];        // priceAsk
+    long long m_size[CHUNK_TICKS];       // size, sizeBid
+    long long m_size2[CHUNK_TICKS];      // sizeAsk
+    int m_exchange[CHUNK_TICKS];
+    int m_specialConditions[CHUNK_TICKS];
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EHistoricalTickSink(const EHistoricalTickSink&);
+    EHistoricalTickSink& operator=(const EHistoricalTickSink&);
+
+public:
+    EHistoricalTickSink() {}
+    virtual ~EHistoricalTickSink() {}
+
+    virtual void historicalTicks(int reqId, const HistoricalTickColumns &ticks, bool done) = 0;
+    virtual void historicalTicksBidAsk(int reqId, const HistoricalTickBidAskColumns &ticks, bool done) = 0;
+    virtual void historicalTicksLast(int reqId, const HistoricalTickLastColumns &ticks, bool done) = 0;
+
+    // the strings behind HistoricalTickLastColumns ids, shared by every request this sink sees
+    const EStringInterner &names() const { return m_names; }
+};
+
+#endif
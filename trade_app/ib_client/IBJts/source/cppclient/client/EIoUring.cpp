@@ -0,0 +1,317 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "EIoUring.h"
+
+#if defined(IBAPI_IO_URING)
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define URING_ENTRIES 8
+#define URING_BUF_GROUP 0
+#define URING_RECV_TAG 1
+
+static inline unsigned LoadAcquire(const unsigned *p) {
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void StoreRelease(unsigned *p, unsigned v) {
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int IoUringSetup(unsigned entries, struct io_uring_params *p) {
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int IoUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, const void *arg, size_t argSize) {
+	return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+static int IoUringRegister(int fd, unsigned opcode, const void *arg, unsigned nrArgs) {
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs);
+}
+
+EIoUring::EIoUring()
+	: m_ringFd(-1)
+	, m_sockFd(-1)
+	, m_ringMem(MAP_FAILED)
+	, m_ringMemSize(0)
+	, m_cqRingMem(MAP_FAILED)
+	, m_cqRingMemSize(0)
+	, m_sqes((io_uring_sqe *)MAP_FAILED)
+	, m_sqesSize(0)
+	, m_bufRing(0)
+	, m_bufs(0)
+	, m_bufCount(0)
+	, m_bufSize(0)
+	, m_bufTail(0)
+	, m_armed(false)
+	, m_delivered(false)
+	, m_eof(false)
+	, m_error(0)
+{
+}
+
+EIoUring::~EIoUring() {
+	release();
+}
+
+void EIoUring::release() {
+	// closing the ring cancels the outstanding recv
+	if (m_ringFd >= 0)
+		close(m_ringFd);
+	if (m_sqes != MAP_FAILED)
+		munmap(m_sqes, m_sqesSize);
+	if (m_cqRingMem != MAP_FAILED)
+		munmap(m_cqRingMem, m_cqRingMemSize);
+	if (m_ringMem != MAP_FAILED)
+		munmap(m_ringMem, m_ringMemSize);
+	free(m_bufRing);
+	free(m_bufs);
+
+	m_ringFd = -1;
+	m_sqes = (io_uring_sqe *)MAP_FAILED;
+	m_cqRingMem = MAP_FAILED;
+	m_ringMem = MAP_FAILED;
+	m_bufRing = 0;
+	m_bufs = 0;
+}
+
+bool EIoUring::init(int sockFd, unsigned bufCount, unsigned bufSize) {
+	m_sockFd = sockFd;
+
+	if (setupRing(URING_ENTRIES) && setupBuffers(bufCount, bufSize) && arm())
+		return true;
+
+	release();
+	return false;
+}
+
+bool EIoUring::setupRing(unsigned entries) {
+	struct io_uring_params p;
+
+	memset(&p, 0, sizeof(p));
+
+	m_ringFd = IoUringSetup(entries, &p);
+
+	if (m_ringFd < 0)
+		return false;
+
+	// timed waits need IORING_ENTER_EXT_ARG
+	if (!(p.features & IORING_FEAT_EXT_ARG))
+		return false;
+
+	size_t sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	size_t cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+	m_ringMemSize = single && cqSize > sqSize ? cqSize : sqSize;
+	m_ringMem = mmap(0, m_ringMemSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+
+	if (m_ringMem == MAP_FAILED)
+		return false;
+
+	char *cq = (char *)m_ringMem;
+
+	if (!single) {
+		m_cqRingMemSize = cqSize;
+		m_cqRingMem = mmap(0, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+
+		if (m_cqRingMem == MAP_FAILED)
+			return false;
+
+		cq = (char *)m_cqRingMem;
+	}
+
+	m_sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+	m_sqes = (io_uring_sqe *)mmap(0, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+
+	if (m_sqes == MAP_FAILED)
+		return false;
+
+	char *sq = (char *)m_ringMem;
+
+	m_sqHead = (unsigned *)(sq + p.sq_off.head);
+	m_sqTail = (unsigned *)(sq + p.sq_off.tail);
+	m_sqMask = (unsigned *)(sq + p.sq_off.ring_mask);
+	m_sqArray = (unsigned *)(sq + p.sq_off.array);
+	m_cqHead = (unsigned *)(cq + p.cq_off.head);
+	m_cqTail = (unsigned *)(cq + p.cq_off.tail);
+	m_cqMask = (unsigned *)(cq + p.cq_off.ring_mask);
+	m_cqes = (io_uring_cqe *)(cq + p.cq_off.cqes);
+	return true;
+}
+
+bool EIoUring::setupBuffers(unsigned count, unsigned size) {
+	size_t ringSize = count * sizeof(struct io_uring_buf);
+
+	if (count == 0 || (count & (count - 1)) != 0 || count > 32768)
+		return false;
+
+	if (posix_memalign((void **)&m_bufRing, 4096, ringSize) != 0) {
+		m_bufRing = 0;
+		return false;
+	}
+
+	m_bufs = (char *)malloc((size_t)count * size);
+
+	if (!m_bufs)
+		return false;
+
+	memset(m_bufRing, 0, ringSize);
+	m_bufCount = count;
+	m_bufSize = size;
+
+	struct io_uring_buf_reg reg;
+
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (unsigned long long)(uintptr_t)m_bufRing;
+	reg.ring_entries = count;
+	reg.bgid = URING_BUF_GROUP;
+
+	if (IoUringRegister(m_ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+		return false;
+
+	for (unsigned i = 0; i < count; ++i)
+		recycle((unsigned short)i);
+
+	return true;
+}
+
+void EIoUring::recycle(unsigned short bid) {
+	// not m_bufRing->bufs: compiled as C++ the header's flexible array sits behind a 1 byte
+	// empty struct and lands 8 bytes off. Entry 0 starts the ring, its resv field is the tail.
+	struct io_uring_buf *buf = reinterpret_cast<struct io_uring_buf *>(m_bufRing) + (m_bufTail & (m_bufCount - 1));
+
+	buf->addr = (unsigned long long)(uintptr_t)(m_bufs + (size_t)bid * m_bufSize);
+	buf->len = m_bufSize;
+	buf->bid = bid;
+
+	++m_bufTail;
+	__atomic_store_n(&m_bufRing->tail, m_bufTail, __ATOMIC_RELEASE);
+}
+
+bool EIoUring::arm() {
+	unsigned tail = *m_sqTail;
+	unsigned index = tail & *m_sqMask;
+	struct io_uring_sqe *sqe = &m_sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = m_sockFd;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->buf_group = URING_BUF_GROUP;
+	sqe->user_data = URING_RECV_TAG;
+
+	m_sqArray[index] = index;
+	StoreRelease(m_sqTail, tail + 1);
+
+	if (IoUringEnter(m_ringFd, 1, 0, 0, 0, 0) < 0)
+		return false;
+
+	m_armed = true;
+	return true;
+}
+
+void EIoUring::reap() {
+	unsigned head = *m_cqHead;
+	unsigned tail = LoadAcquire(m_cqTail);
+
+	for (; head != tail; ++head) {
+		const struct io_uring_cqe *cqe = &m_cqes[head & *m_cqMask];
+
+		if (cqe->user_data != URING_RECV_TAG)
+			continue;
+
+		if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+			Chunk chunk;
+
+			chunk.bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+			chunk.offset = 0;
+			chunk.len = (unsigned)cqe->res;
+			m_ready.push_back(chunk);
+			m_delivered = true;
+		}
+		else if (cqe->res == 0) {
+			m_eof = true;
+		}
+		else if (cqe->res < 0 && cqe->res != -ENOBUFS) {
+			// ENOBUFS only means every buffer is in use, the recv is re-armed once some come back
+			m_error = -cqe->res;
+		}
+
+		if (!(cqe->flags & IORING_CQE_F_MORE))
+			m_armed = false;
+	}
+
+	StoreRelease(m_cqHead, head);
+}
+
+int EIoUring::read(char *buf, size_t sz) {
+	reap();
+
+	size_t copied = 0;
+
+	while (copied < sz && !m_ready.empty()) {
+		Chunk &chunk = m_ready.front();
+		size_t n = chunk.len - chunk.offset;
+
+		if (n > sz - copied)
+			n = sz - copied;
+
+		memcpy(buf + copied, m_bufs + (size_t)chunk.bid * m_bufSize + chunk.offset, n);
+		copied += n;
+		chunk.offset += (unsigned)n;
+
+		if (chunk.offset == chunk.len) {
+			recycle(chunk.bid);
+			m_ready.pop_front();
+		}
+	}
+
+	rearm();
+	return (int)copied;
+}
+
+void EIoUring::rearm() {
+	// the kernel ends a multishot recv when it runs out of buffers, start another one
+	if (!m_armed && !m_eof && m_error == 0 && !arm())
+		m_error = errno;
+}
+
+void EIoUring::wait(int timeoutMs) {
+	reap();
+	rearm();
+
+	if (!m_ready.empty() || m_eof || m_error != 0)
+		return;
+
+	struct __kernel_timespec ts;
+	struct io_uring_getevents_arg arg;
+
+	ts.tv_sec = timeoutMs / 1000;
+	ts.tv_nsec = (long long)(timeoutMs % 1000) * 1000000;
+
+	memset(&arg, 0, sizeof(arg));
+	arg.sigmask_sz = _NSIG / 8;
+	arg.ts = (unsigned long long)(uintptr_t)&ts;
+
+	IoUringEnter(m_ringFd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+	errno = 0;
+	reap();
+}
+
+bool EIoUring::unsupported() const {
+	// the opcode or flag combination was refused before anything was received
+	return !m_delivered && (m_error == EINVAL || m_error == EOPNOTSUPP);
+}
+
+#endif
@@ -0,0 +1,98 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EIOURING_H
+#define TWS_API_CLIENT_EIOURING_H
+
+#include "platformspecific.h"
+
+#if defined(IBAPI_IO_URING)
+
+#include <deque>
+#include <stddef.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+// io_uring receive engine for one socket, built on the raw syscalls (no liburing).
+// A single multishot recv keeps filling buffers from a registered provided-buffer ring and
+// posts a completion per chunk, so while data keeps flowing read() only walks the shared
+// completion ring and hands buffers back in user space; wait() enters the kernel only
+// when there is nothing to read. init() fails on kernels (or seccomp profiles) without
+// io_uring, provided buffer rings or multishot recv, and unsupported() reports a recv
+// rejected later on, before any data was delivered; EReader then uses the socket path.
+class TWSAPIDLLEXP EIoUring
+{
+    struct Chunk
+    {
+        unsigned short bid;
+        unsigned int offset;
+        unsigned int len;
+    };
+
+    int m_ringFd;
+    int m_sockFd;
+
+    void *m_ringMem;
+    size_t m_ringMemSize;
+    void *m_cqRingMem;
+    size_t m_cqRingMemSize;
+    io_uring_sqe *m_sqes;
+    size_t m_sqesSize;
+    unsigned *m_sqHead;
+    unsigned *m_sqTail;
+    unsigned *m_sqMask;
+    unsigned *m_sqArray;
+    unsigned *m_cqHead;
+    unsigned *m_cqTail;
+    unsigned *m_cqMask;
+    io_uring_cqe *m_cqes;
+
+    io_uring_buf_ring *m_bufRing;
+    char *m_bufs;
+    unsigned m_bufCount;
+    unsigned m_bufSize;
+    unsigned short m_bufTail;
+
+    std::deque<Chunk> m_ready;
+    bool m_armed;
+    bool m_delivered;
+    bool m_eof;
+    int m_error;
+
+    bool setupRing(unsigned entries);
+    bool setupBuffers(unsigned count, unsigned size);
+    bool arm();
+    void rearm();
+    void reap();
+    void recycle(unsigned short bid);
+    void release();
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EIoUring(const EIoUring&);
+    EIoUring& operator=(const EIoUring&);
+
+public:
+    EIoUring();
+    ~EIoUring();
+
+    // bufCount must be a power of two
+    bool init(int sockFd, unsigned bufCount, unsigned bufSize);
+    int sockFd() const { return m_sockFd; }
+
+    // copies up to sz received bytes, 0 when nothing is pending
+    int read(char *buf, size_t sz);
+    // waits up to timeoutMs for data, end of stream or an error
+    void wait(int timeoutMs);
+
+    bool hasData() const { return !m_ready.empty(); }
+    bool eof() const { return m_ready.empty() && m_eof; }
+    int error() const { return m_ready.empty() ? m_error : 0; }
+    bool unsupported() const;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,325 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EMARKETDATAPARSER_H
+#define TWS_API_CLIENT_EMARKETDATAPARSER_H
+
+#include <bitset>
+#include <float.h>
+#include "platformspecific.h"
+#include "CommonDefs.h"
+#include "TickAttrib.h"
+#include "TickAttribBidAsk.h"
+#include "TickAttribLast.h"
+#include "EDecoder.h"
+#include "EWrapperView.h"
+
+// Field walking of the market data and PnL messages, shared by EDecoder and EStaticDecoder.
+// Each parser reads one message body (msgId already consumed) and hands the result to Sink
+// through the EWrapper method of the same name, with string fields as EStringView; it returns
+// the end of the message, or 0 when it is incomplete. Tier is the version tier the feature
+// checks compare against, see EVersionTier.h.
+//
+// Sink::wantsTickByTick(tickType) is asked once the tick type is known; a sink that declines
+// gets endPtr back without the remaining fields being read, so it may only do that when endPtr
+// is the end of the message.
+namespace EMarketDataParser {
+
+template<class Tier, class Sink>
+const char* tickPrice(Sink &sink, int connVersion, const char* ptr, const char* endPtr) {
+	const int serverVersion = Tier::serverVersion(connVersion);
+
+	int version;
+	int tickerId;
+	int tickTypeInt;
+	double price;
+
+	int size;
+	int attrMask;
+
+	DECODE_FIELD( version);
+	DECODE_FIELD( tickerId);
+	DECODE_FIELD( tickTypeInt);
+	DECODE_FIELD( price);
+	DECODE_FIELD( size); // ver 2 field
+	DECODE_FIELD( attrMask); // ver 3 field
+
+	TickAttrib attrib = {};
+
+	attrib.canAutoExecute = attrMask == 1;
+
+	if (serverVersion >= MIN_SERVER_VER_PAST_LIMIT)
+	{
+		std::bitset<32> mask(attrMask);
+
+		attrib.canAutoExecute = mask[0];
+		attrib.pastLimit = mask[1];
+
+		if (serverVersion >= MIN_SERVER_VER_PRE_OPEN_BID_ASK)
+		{
+			attrib.preOpen = mask[2];
+		}
+	}
+
+	sink.tickPrice( tickerId, (TickType)tickTypeInt, price, attrib);
+
+	// process ver 2 fields
+	{
+		TickType sizeTickType = NOT_SET;
+		switch( (TickType)tickTypeInt) {
+		case BID:
+			sizeTickType = BID_SIZE;
+			break;
+		case ASK:
+			sizeTickType = ASK_SIZE;
+			break;
+		case LAST:
+			sizeTickType = LAST_SIZE;
+			break;
+		case DELAYED_BID:
+			sizeTickType = DELAYED_BID_SIZE;
+			break;
+		case DELAYED_ASK:
+			sizeTickType = DELAYED_ASK_SIZE;
+			break;
+		case DELAYED_LAST:
+			sizeTickType = DELAYED_LAST_SIZE;
+			break;
+		default:
+			break;
+		}
+		if( sizeTickType != NOT_SET)
+			sink.tickSize( tickerId, sizeTickType, size);
+	}
+
+	return ptr;
+}
+
+template<class Sink>
+const char* tickSize(Sink &sink, const char* ptr, const char* endPtr) {
+	int version;
+	int tickerId;
+	int tickTypeInt;
+	int size;
+
+	DECODE_FIELD( version);
+	DECODE_FIELD( tickerId);
+	DECODE_FIELD( tickTypeInt);
+	DECODE_FIELD( size);
+
+	sink.tickSize( tickerId, (TickType)tickTypeInt, size);
+
+	return ptr;
+}
+
+template<class Sink>
+const char* tickGeneric(Sink &sink, const char* ptr, const char* endPtr) {
+	int version;
+	int tickerId;
+	int tickTypeInt;
+	double value;
+
+	DECODE_FIELD( version);
+	DECODE_FIELD( tickerId);
+	DECODE_FIELD( tickTypeInt);
+	DECODE_FIELD( value);
+
+	sink.tickGeneric( tickerId, (TickType)tickTypeInt, value);
+
+	return ptr;
+}
+
+template<class Sink>
+const char* tickString(Sink &sink, const char* ptr, const char* endPtr) {
+	int version;
+	int tickerId;
+	int tickTypeInt;
+	EStringView value;
+
+	DECODE_FIELD( version);
+	DECODE_FIELD( tickerId);
+	DECODE_FIELD( tickTypeInt);
+	DECODE_FIELD( value);
+
+	sink.tickString( tickerId, (TickType)tickTypeInt, value);
+
+	return ptr;
+}
+
+template<class Sink>
+const char* marketDepth(Sink &sink, const char* ptr, const char* endPtr) {
+	int version;
+	int id;
+	int position;
+	int operation;
+	int side;
+	double price;
+	int size;
+
+	DECODE_FIELD( version);
+	DECODE_FIELD( id);
+	DECODE_FIELD( position);
+	DECODE_FIELD( operation);
+	DECODE_FIELD( side);
+	DECODE_FIELD( price);
+	DECODE_FIELD( size);
+
+	sink.updateMktDepth( id, position, operation, side, price, size);
+
+	return ptr;
+}
+
+template<class Tier, class Sink>
+const char* marketDepthL2(Sink &sink, int connVersion, const char* ptr, const char* endPtr) {
+	const int serverVersion = Tier::serverVersion(connVersion);
+
+	int version;
+	int id;
+	int position;
+	EStringView marketMaker;
+	int operation;
+	int side;
+	double price;
+	int size;
+	bool isSmartDepth = false;
+
+	DECODE_FIELD( version);
+	DECODE_FIELD( id);
+	DECODE_FIELD( position);
+	DECODE_FIELD( marketMaker);
+	DECODE_FIELD( operation);
+	DECODE_FIELD( side);
+	DECODE_FIELD( price);
+	DECODE_FIELD( size);
+
+	if( serverVersion >= MIN_SERVER_VER_SMART_DEPTH) {
+		DECODE_FIELD( isSmartDepth);
+	}
+
+	sink.updateMktDepthL2( id, position, marketMaker, operation, side,
+		price, size, isSmartDepth);
+
+	return ptr;
+}
+
+template<class Sink>
+const char* tickByTick(Sink &sink, const char* ptr, const char* endPtr) {
+    int reqId;
+    int tickType = 0;
+	time_t time;
+
+    DECODE_FIELD(reqId);
+    DECODE_FIELD(tickType);
+    DECODE_FIELD(time);
+
+    if (!sink.wantsTickByTick(tickType))
+        return endPtr;
+
+    if (tickType == 1 || tickType == 2) { // Last/AllLast
+            double price;
+            int size;
+            int attrMask;
+            TickAttribLast tickAttribLast = {};
+            EStringView exchange;
+            EStringView specialConditions;
+
+            DECODE_FIELD(price);
+            DECODE_FIELD(size);
+            DECODE_FIELD(attrMask);
+
+            std::bitset<32> mask(attrMask);
+            tickAttribLast.pastLimit = mask[0];
+            tickAttribLast.unreported = mask[1];
+
+            DECODE_FIELD(exchange);
+            DECODE_FIELD(specialConditions);
+
+            sink.tickByTickAllLast(reqId, tickType, time, price, size, tickAttribLast, exchange, specialConditions);
+
+    } else if (tickType == 3) { // BidAsk
+            double bidPrice;
+            double askPrice;
+            int bidSize;
+            int askSize;
+            int attrMask;
+            DECODE_FIELD(bidPrice);
+            DECODE_FIELD(askPrice);
+            DECODE_FIELD(bidSize);
+            DECODE_FIELD(askSize);
+            DECODE_FIELD(attrMask);
+
+            TickAttribBidAsk tickAttribBidAsk = {};
+            std::bitset<32> mask(attrMask);
+            tickAttribBidAsk.bidPastLow = mask[0];
+            tickAttribBidAsk.askPastHigh = mask[1];
+
+            sink.tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, tickAttribBidAsk);
+    } else if (tickType == 4) { // MidPoint
+            double midPoint;
+            DECODE_FIELD(midPoint);
+
+            sink.tickByTickMidPoint(reqId, time, midPoint);
+    }
+
+    return ptr;
+}
+
+template<class Tier, class Sink>
+const char* pnl(Sink &sink, int connVersion, const char* ptr, const char* endPtr) {
+    const int serverVersion = Tier::serverVersion(connVersion);
+
+    int reqId;
+    double dailyPnL;
+    double unrealizedPnL = DBL_MAX;
+    double realizedPnL = DBL_MAX;
+
+    DECODE_FIELD(reqId)
+    DECODE_FIELD(dailyPnL)
+
+    if (serverVersion >= MIN_SERVER_VER_UNREALIZED_PNL) {
+        DECODE_FIELD(unrealizedPnL)
+    }
+
+    if (serverVersion >= MIN_SERVER_VER_REALIZED_PNL) {
+        DECODE_FIELD(realizedPnL)
+    }
+
+    sink.pnl(reqId, dailyPnL, unrealizedPnL, realizedPnL);
+
+    return ptr;
+}
+
+template<class Tier, class Sink>
+const char* pnlSingle(Sink &sink, int connVersion, const char* ptr, const char* endPtr) {
+    const int serverVersion = Tier::serverVersion(connVersion);
+
+    int reqId;
+    int pos;
+    double dailyPnL;
+    double unrealizedPnL = DBL_MAX;
+    double realizedPnL = DBL_MAX;
+    double value;
+
+    DECODE_FIELD(reqId);
+    DECODE_FIELD(pos);
+    DECODE_FIELD(dailyPnL);
+
+    if (serverVersion >= MIN_SERVER_VER_UNREALIZED_PNL) {
+        DECODE_FIELD(unrealizedPnL)
+    }
+
+    if (serverVersion >= MIN_SERVER_VER_REALIZED_PNL) {
+        DECODE_FIELD(realizedPnL)
+    }
+
+    DECODE_FIELD(value);
+
+    sink.pnlSingle(reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
+
+    return ptr;
+}
+
+}
+
+#endif
@@ -3,18 +3,85 @@
 
 #include "StdAfx.h"
 #include "EMessage.h"
+#include "EMessagePool.h"
 
 
-EMessage::EMessage(const std::vector<char> &data) {
+EMessageSlab::EMessageSlab(size_t capacity, unsigned sizeClass)
+    : m_refs(1)
+    , m_data(new char[capacity])
+    , m_size(capacity)
+    , m_capacity(capacity)
+    , m_sizeClass(sizeClass)
+{
+}
+
+EMessageSlab::~EMessageSlab() {
+    delete[] m_data;
+}
+
+void EMessageSlab::reset(size_t size) {
+    m_refs.store(1, std::memory_order_relaxed);
+    m_size = size;
+}
+
+EMessageSlab * EMessageSlab::create(size_t size) {
+    return EMessagePool::instance().acquireSlab(size);
+}
+
+void EMessageSlab::addRef() {
+    m_refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EMessageSlab::release() {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        EMessagePool::instance().recycleSlab(this);
+}
+
+bool EMessageSlab::isShared() const {
+    // acquire pairs with release() so bytes read by a finished message can be overwritten
+    return m_refs.load(std::memory_order_acquire) > 1;
+}
+
+EMessage::EMessage(const std::vector<char> &data)
+    : m_slab(0)
+{
     this->data = data;
+    m_begin = this->data.data();
+    m_end = m_begin + this->data.size();
+}
+
+EMessage::EMessage(EMessageSlab *slab, const char *begin, const char *end)
+    : m_slab(slab)
+    , m_begin(begin)
+    , m_end(end)
+{
+    if (m_slab)
+        m_slab->addRef();
+}
+
+EMessage::~EMessage() {
+    if (m_slab)
+        m_slab->release();
+}
+
+void * EMessage::operator new(size_t size) {
+    // a derived message is bigger than the pooled blocks
+    return size == sizeof(EMessage) ? EMessagePool::instance().allocMessage() : ::operator new(size);
+}
+
+void EMessage::operator delete(void *p, size_t size) {
+    if (size == sizeof(EMessage))
+        EMessagePool::instance().freeMessage(p);
+    else
+        ::operator delete(p);
 }
 
 const char* EMessage::begin(void) const
 {
-    return data.data();
+    return m_begin;
 }
 
 const char* EMessage::end(void) const
 {
-    return data.data() + data.size();
+    return m_end;
 }
@@ -5,16 +5,80 @@
 #ifndef TWS_API_CLIENT_EMESSAGE_H
 #define TWS_API_CLIENT_EMESSAGE_H
 
+#include <atomic>
 #include <vector>
 #include "platformspecific.h"
 
+// Refcounted block of received bytes. The reader owns one reference while it fills the
+// slab and every message sliced out of it holds another; the last release hands it back
+// to EMessagePool.
+class TWSAPIDLLEXP EMessageSlab
+{
+    std::atomic<int> m_refs;
+    char *m_data;
+    size_t m_size;
+    size_t m_capacity;
+    unsigned m_sizeClass;
+
+    EMessageSlab(size_t capacity, unsigned sizeClass);
+    ~EMessageSlab();
+    void reset(size_t size);
+    unsigned sizeClass() const { return m_sizeClass; }
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EMessageSlab(const EMessageSlab&);
+    EMessageSlab& operator=(const EMessageSlab&);
+
+    friend class EMessagePool;
+
+public:
+    static EMessageSlab * create(size_t size);
+
+    void addRef();
+    void release();
+    bool isShared() const;
+
+    char * data() { return m_data; }
+    size_t size() const { return m_size; }
+    // the size class actually allocated, at least size()
+    size_t capacity() const { return m_capacity; }
+};
+
+// When the bytes of a message came off the socket, in nanoseconds of std::chrono::steady_clock
+// (CLOCK_MONOTONIC) whichever way they were read. With kernel set the kernel stamped their
+// arrival (SO_TIMESTAMPNS, on CLOCK_REALTIME), moved to steady_clock by its age when read;
+// otherwise they were stamped right after the read returned.
+struct EReceiveTime
+{
+    EReceiveTime() : nanos(0), kernel(false) {}
+
+    long long nanos;
+    bool kernel;
+};
+
 class TWSAPIDLLEXP EMessage
 {
     std::vector<char> data;
+    EMessageSlab *m_slab;
+    const char *m_begin;
+    const char *m_end;
+    EReceiveTime m_receiveTime;
+
+    // disable copy, a sliced message owns a slab reference
+    EMessage(const EMessage&);
+    EMessage& operator=(const EMessage&);
+
 public:
     EMessage(const std::vector<char> &data);
+    // frame inside a slab, no copy; pass a null slab to wrap bytes that outlive the message
+    EMessage(EMessageSlab *slab, const char *begin, const char *end);
+    ~EMessage();
+    // drawn from EMessagePool
+    static void * operator new(size_t size);
+    static void operator delete(void *p, size_t size);
     const char* begin(void) const;
     const char* end(void) const;
+    void receiveTime(const EReceiveTime &receiveTime) { m_receiveTime = receiveTime; }
+    const EReceiveTime &receiveTime() const { return m_receiveTime; }
 };
 
 #endif
\ No newline at end of file
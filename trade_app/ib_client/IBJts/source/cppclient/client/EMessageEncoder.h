@@ -0,0 +1,107 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EMESSAGEENCODER_H
+#define TWS_API_CLIENT_EMESSAGEENCODER_H
+
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include <string.h>
+#include "platformspecific.h"
+
+// Stream buffer appending to the end of a byte vector (the ESocket out buffer), growing it a
+// slice at a time. Once the vector's capacity has warmed up, encoding allocates nothing.
+class EEncodeBuffer : public std::streambuf
+{
+    enum { GROW_MIN = 256 };
+
+    std::vector<char> &m_target;
+    size_t m_begin;       // where the message starts in m_target
+    bool m_finished;
+
+    size_t end() const { return pptr() - &m_target[0]; }
+
+    void grow(size_t size) {
+        size_t used = pbase() ? end() : m_begin;
+
+        m_target.resize(used + (size > GROW_MIN + used - m_begin ? size : GROW_MIN + used - m_begin));
+        setp(&m_target[0] + used, &m_target[0] + m_target.size());
+    }
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EEncodeBuffer(const EEncodeBuffer&);
+    EEncodeBuffer& operator=(const EEncodeBuffer&);
+
+protected:
+    virtual int_type overflow(int_type c) {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+
+        grow(1);
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+
+        return c;
+    }
+
+    virtual std::streamsize xsputn(const char *s, std::streamsize n) {
+        if (epptr() - pptr() < n)
+            grow((size_t)n);
+
+        memcpy(pptr(), s, (size_t)n);
+        pbump((int)n);
+
+        return n;
+    }
+
+public:
+    explicit EEncodeBuffer(std::vector<char> &target) : m_target(target), m_begin(target.size()), m_finished(false) {
+        grow(GROW_MIN);
+    }
+
+    // an unfinished message is taken back out of the target
+    ~EEncodeBuffer() {
+        if (!m_finished)
+            m_target.resize(m_begin);
+    }
+
+    // trims the target to the encoded bytes, which stay at its end
+    void finish() {
+        m_target.resize(end());
+        setp(0, 0);
+        m_finished = true;
+    }
+
+    size_t begin() const { return m_begin; }
+    size_t size() const { return (m_finished ? m_target.size() : end()) - m_begin; }
+    char *data() { return &m_target[m_begin]; }
+};
+
+// An outgoing message, encoded in place at the end of the transport's out buffer instead of
+// in a std::stringstream that is then copied out of with str() and copied again into the out
+// buffer. EClient requests create one on encodeBuffer(), write the length prefix slot with
+// prepareBuffer() and the fields with ENCODE_FIELD(), and hand it to closeAndSend(), which
+// fills in the length and sends. A message dropped before that is removed again.
+class TWSAPIDLLEXP EMessageEncoder : public std::ostream
+{
+    EEncodeBuffer m_buf;
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EMessageEncoder(const EMessageEncoder&);
+    EMessageEncoder& operator=(const EMessageEncoder&);
+
+public:
+    explicit EMessageEncoder(std::vector<char> &target) : std::ostream(0), m_buf(target) {
+        rdbuf(&m_buf);
+    }
+
+    void finish() { m_buf.finish(); }
+
+    // the message's bytes, header slot included; the pointer is valid until the target changes
+    size_t size() const { return m_buf.size(); }
+    char *data() { return m_buf.data(); }
+};
+
+#endif
@@ -0,0 +1,68 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EMESSAGEFILTER_H
+#define TWS_API_CLIENT_EMESSAGEFILTER_H
+
+#include <atomic>
+#include <stdint.h>
+#include "platformspecific.h"
+
+// The incoming message ids (TICK_PRICE, ACCT_VALUE, ... in EDecoder.h) an application wants.
+// The EReader drops frames of the other ids as soon as it has read their msgId, before they
+// are queued or decoded, so their EWrapper callbacks never fire. Everything is accepted by
+// default. Ids past MAX_MSG_ID are always accepted, so a message this client version does not
+// know still reaches EDecoder and is reported. Dropping ERR_MSG hides connection errors too.
+//
+// The reader thread reads the filter while another thread may change it; a change applies
+// from the next frame read on.
+class TWSAPIDLLEXP EMessageFilter
+{
+public:
+    enum { MAX_MSG_ID = 255 };
+
+private:
+    enum { WORD_BITS = 64, WORDS = (MAX_MSG_ID + WORD_BITS) / WORD_BITS };
+
+    std::atomic<uint64_t> m_accepted[WORDS];   // bit set when the id is wanted
+
+    void set(int msgId, bool accepted) {
+        if (msgId < 0 || msgId > MAX_MSG_ID)
+            return;
+
+        uint64_t bit = (uint64_t)1 << (msgId % WORD_BITS);
+
+        if (accepted)
+            m_accepted[msgId / WORD_BITS].fetch_or(bit, std::memory_order_relaxed);
+        else
+            m_accepted[msgId / WORD_BITS].fetch_and(~bit, std::memory_order_relaxed);
+    }
+
+    void setAll(bool accepted) {
+        for (int i = 0; i < WORDS; ++i)
+            m_accepted[i].store(accepted ? ~(uint64_t)0 : 0, std::memory_order_relaxed);
+    }
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EMessageFilter(const EMessageFilter&);
+    EMessageFilter& operator=(const EMessageFilter&);
+
+public:
+    EMessageFilter() { setAll(true); }
+
+    void accept(int msgId) { set(msgId, true); }
+    void ignore(int msgId) { set(msgId, false); }
+    void acceptAll() { setAll(true); }
+    // start of a whitelist, accept() the wanted ids afterwards
+    void ignoreAll() { setAll(false); }
+
+    bool accepts(int msgId) const {
+        if (msgId < 0 || msgId > MAX_MSG_ID)
+            return true;
+
+        return (m_accepted[msgId / WORD_BITS].load(std::memory_order_relaxed) >> (msgId % WORD_BITS)) & 1;
+    }
+};
+
+#endif
@@ -0,0 +1,356 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "EMessagePool.h"
+#include "EMessage.h"
+
+#include <algorithm>
+#include <new>
+
+#define MESSAGE_FREE_MAX 8192                         // handed over and not taken yet
+#define MESSAGE_CACHE_MAX 256                         // kept by a thread that frees more than it allocates
+#define MESSAGE_CACHE_BATCH 128                       // handed over at a time, and allocations between high water samples
+#define SLAB_CLASS_MIN_SHIFT 12                       // 4 KB
+#define SLAB_CLASS_MAX_SHIFT 24                       // 16 MB, the largest frame the protocol allows
+#define SLAB_CLASS_FREE_BYTES (4 * 1024 * 1024)       // kept per class
+#define SLAB_CLASS_FREE_MIN 2
+
+// A thread's own free messages. Only that thread touches the list; the counters are atomics
+// for messageStats() to read, but only that thread writes them.
+struct EMessageCache
+{
+	EMessagePool::FreeNode *head;
+	size_t count;
+	size_t sinceSample;                        // allocations since this thread last sampled the high water mark
+	std::atomic<unsigned long long> hits;
+	std::atomic<unsigned long long> misses;
+	std::atomic<unsigned long long> frees;
+
+	EMessageCache() : head(0), count(0), sinceSample(0), hits(0), misses(0), frees(0) {}
+};
+
+static thread_local EMessageCache *t_pMessageCache = 0;
+static thread_local bool t_messageCacheRetired = false;   // given back at thread exit, see below
+
+// gives the thread's cache back to the pool when the thread exits; anything freed later on the
+// way out goes to the shared list directly
+struct EMessageCacheOwner
+{
+	bool armed;
+
+	~EMessageCacheOwner() {
+		if (t_pMessageCache)
+			EMessagePool::instance().retire(t_pMessageCache);
+
+		t_pMessageCache = 0;
+		t_messageCacheRetired = true;
+	}
+};
+
+static thread_local EMessageCacheOwner t_messageCacheOwner;
+
+static void Count(std::atomic<unsigned long long> &counter) {
+	// written by one thread only, no read-modify-write needed
+	counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+static unsigned SlabClass(size_t size) {
+	unsigned shift = SLAB_CLASS_MIN_SHIFT;
+
+	while (shift < SLAB_CLASS_MAX_SHIFT && ((size_t)1 << shift) < size)
+		++shift;
+
+	return shift - SLAB_CLASS_MIN_SHIFT;
+}
+
+static size_t SlabClassFreeMax(unsigned slabClass) {
+	size_t n = SLAB_CLASS_FREE_BYTES >> (slabClass + SLAB_CLASS_MIN_SHIFT);
+
+	return n < SLAB_CLASS_FREE_MIN ? SLAB_CLASS_FREE_MIN : n;
+}
+
+EMessagePool::EMessagePool()
+	: m_returnedMessages(0)
+	, m_returnedMessageCount(0)
+	, m_retiredHits(0)
+	, m_retiredMisses(0)
+	, m_retiredFrees(0)
+	, m_messageHighWater(0)
+	, m_freeSlabs(SLAB_CLASS_MAX_SHIFT - SLAB_CLASS_MIN_SHIFT + 1)
+{
+}
+
+EMessagePool::~EMessagePool() {
+	trim();
+}
+
+EMessagePool &EMessagePool::instance() {
+	// never destroyed: messages and readers held by other statics may outlive any exit-time teardown
+	static EMessagePool *pool = new EMessagePool();
+
+	return *pool;
+}
+
+void EMessagePool::countOut(EMessagePoolStats &stats, bool hit) {
+	if (hit)
+		++stats.hits;
+	else
+		++stats.misses;
+
+	if (++stats.inUse > stats.highWater)
+		stats.highWater = stats.inUse;
+}
+
+EMessageCache * EMessagePool::threadCache() {
+	EMessageCache *cache = t_pMessageCache;
+
+	// 0 as well once the thread is past handing its cache back
+	if (cache || t_messageCacheRetired)
+		return cache;
+
+	cache = new EMessageCache();
+
+	{
+		EMutexGuard lock(m_csMessages);
+
+		m_messageCaches.push_back(cache);
+	}
+
+	t_pMessageCache = cache;
+	t_messageCacheOwner.armed = true;
+	return cache;
+}
+
+void * EMessagePool::allocMessage() {
+	EMessageCache *cache = threadCache();
+
+	if (!cache) {
+		{
+			EMutexGuard lock(m_csMessages);
+
+			++m_retiredMisses;
+		}
+
+		return ::operator new(sizeof(EMessage));
+	}
+
+	if (!cache->head)
+		refill(cache);
+
+	++cache->sinceSample;
+
+	FreeNode *node = cache->head;
+
+	if (node) {
+		cache->head = node->next;
+		--cache->count;
+		Count(cache->hits);
+		return node;
+	}
+
+	Count(cache->misses);
+	return ::operator new(sizeof(EMessage));
+}
+
+void EMessagePool::freeMessage(void *p) {
+	EMessageCache *cache = threadCache();
+	FreeNode *node = static_cast<FreeNode*>(p);
+
+	if (!cache) {
+		{
+			EMutexGuard lock(m_csMessages);
+
+			++m_retiredFrees;
+		}
+
+		returnMessages(node, node, 1);
+		return;
+	}
+
+	node->next = cache->head;
+	cache->head = node;
+	Count(cache->frees);
+
+	// more than this thread is likely to allocate again: pass a batch on to the allocating one
+	if (++cache->count > MESSAGE_CACHE_MAX)
+		flush(cache, MESSAGE_CACHE_BATCH);
+}
+
+void EMessagePool::refill(EMessageCache *cache) {
+	FreeNode *node = m_returnedMessages.exchange(0, std::memory_order_acquire);
+	size_t count = 0;
+
+	for (FreeNode *n = node; n; n = n->next)
+		++count;
+
+	m_returnedMessageCount.fetch_sub(count, std::memory_order_relaxed);
+	cache->head = node;
+	cache->count = count;
+
+	// the thread has used up what it had, a low point of the free messages: a good time to
+	// sample the high water mark, unless it did so a moment ago
+	if (cache->sinceSample < MESSAGE_CACHE_BATCH)
+		return;
+
+	cache->sinceSample = 0;
+
+	EMutexGuard lock(m_csMessages);
+	size_t inUse = sumMessageStats().inUse;
+
+	if (inUse > m_messageHighWater)
+		m_messageHighWater = inUse;
+}
+
+void EMessagePool::flush(EMessageCache *cache, size_t count) {
+	FreeNode *first = cache->head;
+	FreeNode *last = first;
+
+	for (size_t i = 1; i < count; ++i)
+		last = last->next;
+
+	cache->head = last->next;
+	cache->count -= count;
+	returnMessages(first, last, count);
+}
+
+void EMessagePool::returnMessages(FreeNode *first, FreeNode *last, size_t count) {
+	// more handed over than anyone has taken: back to the heap
+	if (m_returnedMessageCount.fetch_add(count, std::memory_order_relaxed) + count > MESSAGE_FREE_MAX) {
+		m_returnedMessageCount.fetch_sub(count, std::memory_order_relaxed);
+		last->next = 0;
+
+		while (first) {
+			FreeNode *next = first->next;
+
+			::operator delete(first);
+			first = next;
+		}
+
+		return;
+	}
+
+	// only ever pushed onto or taken whole, so a node cannot come back in between (no ABA)
+	FreeNode *head = m_returnedMessages.load(std::memory_order_relaxed);
+
+	do {
+		last->next = head;
+	} while (!m_returnedMessages.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+EMessagePoolStats EMessagePool::sumMessageStats() const {
+	EMessagePoolStats stats;
+	unsigned long long frees = m_retiredFrees;
+
+	stats.hits = m_retiredHits;
+	stats.misses = m_retiredMisses;
+
+	for (size_t i = 0; i < m_messageCaches.size(); ++i) {
+		stats.hits += m_messageCaches[i]->hits.load(std::memory_order_relaxed);
+		stats.misses += m_messageCaches[i]->misses.load(std::memory_order_relaxed);
+		frees += m_messageCaches[i]->frees.load(std::memory_order_relaxed);
+	}
+
+	// another thread's frees may show before the allocations they undo
+	stats.inUse = stats.hits + stats.misses > frees ? (size_t)(stats.hits + stats.misses - frees) : 0;
+	stats.highWater = m_messageHighWater > stats.inUse ? m_messageHighWater : stats.inUse;
+	return stats;
+}
+
+void EMessagePool::retire(EMessageCache *cache) {
+	if (cache->count > 0)
+		flush(cache, cache->count);
+
+	EMutexGuard lock(m_csMessages);
+
+	m_retiredHits += cache->hits.load(std::memory_order_relaxed);
+	m_retiredMisses += cache->misses.load(std::memory_order_relaxed);
+	m_retiredFrees += cache->frees.load(std::memory_order_relaxed);
+	m_messageCaches.erase(std::find(m_messageCaches.begin(), m_messageCaches.end(), cache));
+	delete cache;
+}
+
+EMessageSlab * EMessagePool::acquireSlab(size_t size) {
+	unsigned slabClass = SlabClass(size);
+	size_t capacity = (size_t)1 << (slabClass + SLAB_CLASS_MIN_SHIFT);
+	EMessageSlab *slab = 0;
+
+	if (size > capacity) {
+		// beyond the largest class, never pooled
+		capacity = size;
+		slabClass = (unsigned)m_freeSlabs.size();
+	}
+
+	{
+		EMutexGuard lock(m_csSlabs);
+
+		if (slabClass < m_freeSlabs.size() && !m_freeSlabs[slabClass].empty()) {
+			slab = m_freeSlabs[slabClass].back();
+			m_freeSlabs[slabClass].pop_back();
+		}
+
+		countOut(m_slabStats, slab != 0);
+	}
+
+	if (!slab)
+		slab = new EMessageSlab(capacity, slabClass);
+
+	slab->reset(size);
+	return slab;
+}
+
+void EMessagePool::recycleSlab(EMessageSlab *slab) {
+	unsigned slabClass = slab->sizeClass();
+
+	{
+		EMutexGuard lock(m_csSlabs);
+
+		--m_slabStats.inUse;
+
+		if (slabClass < m_freeSlabs.size() && m_freeSlabs[slabClass].size() < SlabClassFreeMax(slabClass)) {
+			m_freeSlabs[slabClass].push_back(slab);
+			return;
+		}
+	}
+
+	delete slab;
+}
+
+EMessagePoolStats EMessagePool::messageStats() {
+	EMutexGuard lock(m_csMessages);
+
+	return sumMessageStats();
+}
+
+EMessagePoolStats EMessagePool::slabStats() {
+	EMutexGuard lock(m_csSlabs);
+
+	return m_slabStats;
+}
+
+void EMessagePool::trim() {
+	FreeNode *node = m_returnedMessages.exchange(0, std::memory_order_acquire);
+	std::vector<std::vector<EMessageSlab*> > slabs(m_freeSlabs.size());
+	size_t count = 0;
+
+	{
+		EMutexGuard lock(m_csSlabs);
+
+		slabs.swap(m_freeSlabs);
+	}
+
+	while (node) {
+		FreeNode *next = node->next;
+
+		::operator delete(node);
+		node = next;
+		++count;
+	}
+
+	m_returnedMessageCount.fetch_sub(count, std::memory_order_relaxed);
+
+	for (size_t i = 0; i < slabs.size(); ++i) {
+		for (size_t j = 0; j < slabs[i].size(); ++j)
+			delete slabs[i][j];
+	}
+}
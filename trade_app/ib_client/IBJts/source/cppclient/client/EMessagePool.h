@@ -0,0 +1,99 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EMESSAGEPOOL_H
+#define TWS_API_CLIENT_EMESSAGEPOOL_H
+
+#include <atomic>
+#include <stddef.h>
+#include <vector>
+#include "platformspecific.h"
+#include "EMutex.h"
+
+class EMessageSlab;
+struct EMessageCache;
+struct EMessageCacheOwner;
+
+struct TWSAPIDLLEXP EMessagePoolStats
+{
+    EMessagePoolStats() : hits(0), misses(0), inUse(0), highWater(0) {}
+
+    unsigned long long hits;     // served from a free list
+    unsigned long long misses;   // had to go to the heap
+    size_t inUse;                // handed out and not returned yet
+    size_t highWater;            // largest inUse so far
+};
+
+// Process wide free lists for the reader's per-frame allocations: EMessage objects and the
+// receive slabs their bytes live in.
+//
+// Messages are allocated on the reader thread and freed on the thread decoding them, one
+// each per frame, so neither takes a lock: every thread keeps its own free messages, a
+// thread that frees more than it allocates hands them over in batches through a lock-free
+// list, and a thread that runs out takes that whole list. The lock is only taken on such a
+// refill, to sample the high water mark, and when a thread first uses the pool or exits.
+//
+// Slabs are taken and given back once per receive buffer, not per frame, and sit behind
+// their own lock. They are kept in power of two size classes, with a byte budget per class
+// so an oversized frame does not pin its slab forever.
+class TWSAPIDLLEXP EMessagePool
+{
+    struct FreeNode
+    {
+        FreeNode *next;
+    };
+
+    std::atomic<FreeNode*> m_returnedMessages;     // batches handed over, see freeMessage()
+    std::atomic<size_t> m_returnedMessageCount;
+
+    EMutex m_csMessages;
+    std::vector<EMessageCache*> m_messageCaches;   // of the threads using the pool
+    unsigned long long m_retiredHits;              // counted by threads gone
+    unsigned long long m_retiredMisses;
+    unsigned long long m_retiredFrees;
+    size_t m_messageHighWater;
+
+    EMutex m_csSlabs;
+    std::vector<std::vector<EMessageSlab*> > m_freeSlabs;
+    EMessagePoolStats m_slabStats;
+
+    EMessagePool();
+    ~EMessagePool();
+
+    static void countOut(EMessagePoolStats &stats, bool hit);
+
+    EMessageCache * threadCache();
+    void refill(EMessageCache *cache);
+    void flush(EMessageCache *cache, size_t count);
+    void returnMessages(FreeNode *first, FreeNode *last, size_t count);
+    EMessagePoolStats sumMessageStats() const;
+    void retire(EMessageCache *cache);
+
+    friend struct EMessageCache;
+    friend struct EMessageCacheOwner;
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EMessagePool(const EMessagePool&);
+    EMessagePool& operator=(const EMessagePool&);
+
+public:
+    static EMessagePool &instance();
+
+    // storage for one EMessage, used by its operator new/delete
+    void * allocMessage();
+    void freeMessage(void *p);
+
+    // slab of at least size bytes holding one reference; the last EMessageSlab::release() returns it
+    EMessageSlab * acquireSlab(size_t size);
+    void recycleSlab(EMessageSlab *slab);
+
+    EMessagePoolStats messageStats();
+    EMessagePoolStats slabStats();
+
+    // hands every pooled block back to the heap, but for the messages threads keep for
+    // themselves; those go back when the thread exits
+    void trim();
+};
+
+#endif
@@ -20,6 +20,150 @@ EOrderDecoder::EOrderDecoder(Contract *contract, Order *order, OrderState *order
     m_serverVersion = serverVersion;
 }
 
+bool EOrderDecoder::decodeOpenOrder(const char*& ptr, const char* endPtr) {
+    // read order id
+    decodeOrderId(ptr, endPtr);
+
+    // read contract fields
+    decodeContract(ptr, endPtr);
+
+    // read order fields
+    decodeAction(ptr, endPtr);
+    decodeTotalQuantity(ptr, endPtr);
+    decodeOrderType(ptr, endPtr);
+    decodeLmtPrice(ptr, endPtr);
+    decodeAuxPrice(ptr, endPtr);
+    decodeTIF(ptr, endPtr);
+    decodeOcaGroup(ptr, endPtr);
+    decodeAccount(ptr, endPtr);
+    decodeOpenClose(ptr, endPtr);
+    decodeOrigin(ptr, endPtr);
+    decodeOrderRef(ptr, endPtr);
+    decodeClientId(ptr, endPtr);
+    decodePermId(ptr, endPtr);
+    decodeOutsideRth(ptr, endPtr);
+    decodeHidden(ptr, endPtr);
+    decodeDiscretionaryAmount(ptr, endPtr);
+    decodeGoodAfterTime(ptr, endPtr);
+    skipSharesAllocation(ptr, endPtr);
+    decodeFAParams(ptr, endPtr);
+    decodeModelCode(ptr, endPtr);
+    decodeGoodTillDate(ptr, endPtr);
+    decodeRule80A(ptr, endPtr);
+    decodePercentOffset(ptr, endPtr);
+    decodeSettlingFirm(ptr, endPtr);
+    decodeShortSaleParams(ptr, endPtr);
+    decodeAuctionStrategy(ptr, endPtr);
+    decodeBoxOrderParams(ptr, endPtr);
+    decodePegToStkOrVolOrderParams(ptr, endPtr);
+    decodeDisplaySize(ptr, endPtr);
+    decodeBlockOrder(ptr, endPtr);
+    decodeSweepToFill(ptr, endPtr);
+    decodeAllOrNone(ptr, endPtr);
+    decodeMinQty(ptr, endPtr);
+    decodeOcaType(ptr, endPtr);
+    decodeETradeOnly(ptr, endPtr);
+    decodeFirmQuoteOnly(ptr, endPtr);
+    decodeNbboPriceCap(ptr, endPtr);
+    decodeParentId(ptr, endPtr);
+    decodeTriggerMethod(ptr, endPtr);
+    decodeVolOrderParams(ptr, endPtr, true);
+    decodeTrailParams(ptr, endPtr);
+    decodeBasisPoints(ptr, endPtr);
+    decodeComboLegs(ptr, endPtr);
+    decodeSmartComboRoutingParams(ptr, endPtr);
+    decodeScaleOrderParams(ptr, endPtr);
+    decodeHedgeParams(ptr, endPtr);
+    decodeOptOutSmartRouting(ptr, endPtr);
+    decodeClearingParams(ptr, endPtr);
+    decodeNotHeld(ptr, endPtr);
+    decodeDeltaNeutral(ptr, endPtr);
+    decodeAlgoParams(ptr, endPtr);
+    decodeSolicited(ptr, endPtr);
+    decodeWhatIfInfoAndCommission(ptr, endPtr);
+    decodeVolRandomizeFlags(ptr, endPtr);
+    decodePegBenchParams(ptr, endPtr);
+    decodeConditions(ptr, endPtr);
+    decodeAdjustedOrderParams(ptr, endPtr);
+    decodeSoftDollarTier(ptr, endPtr);
+    decodeCashQty(ptr, endPtr);
+    decodeDontUseAutoPriceForHedge(ptr, endPtr);
+    decodeIsOmsContainer(ptr, endPtr);
+    decodeDiscretionaryUpToLimitPrice(ptr, endPtr);
+    decodeUsePriceMgmtAlgo(ptr, endPtr);
+
+    return true;
+}
+
+bool EOrderDecoder::decodeCompletedOrder(const char*& ptr, const char* endPtr) {
+    // read contract fields
+    decodeContract(ptr, endPtr);
+
+    // read order fields
+    decodeAction(ptr, endPtr);
+    decodeTotalQuantity(ptr, endPtr);
+    decodeOrderType(ptr, endPtr);
+    decodeLmtPrice(ptr, endPtr);
+    decodeAuxPrice(ptr, endPtr);
+    decodeTIF(ptr, endPtr);
+    decodeOcaGroup(ptr, endPtr);
+    decodeAccount(ptr, endPtr);
+    decodeOpenClose(ptr, endPtr);
+    decodeOrigin(ptr, endPtr);
+    decodeOrderRef(ptr, endPtr);
+    decodePermId(ptr, endPtr);
+    decodeOutsideRth(ptr, endPtr);
+    decodeHidden(ptr, endPtr);
+    decodeDiscretionaryAmount(ptr, endPtr);
+    decodeGoodAfterTime(ptr, endPtr);
+    decodeFAParams(ptr, endPtr);
+    decodeModelCode(ptr, endPtr);
+    decodeGoodTillDate(ptr, endPtr);
+    decodeRule80A(ptr, endPtr);
+    decodePercentOffset(ptr, endPtr);
+    decodeSettlingFirm(ptr, endPtr);
+    decodeShortSaleParams(ptr, endPtr);
+    decodeBoxOrderParams(ptr, endPtr);
+    decodePegToStkOrVolOrderParams(ptr, endPtr);
+    decodeDisplaySize(ptr, endPtr);
+    decodeSweepToFill(ptr, endPtr);
+    decodeAllOrNone(ptr, endPtr);
+    decodeMinQty(ptr, endPtr);
+    decodeOcaType(ptr, endPtr);
+    decodeTriggerMethod(ptr, endPtr);
+    decodeVolOrderParams(ptr, endPtr, false);
+    decodeTrailParams(ptr, endPtr);
+    decodeComboLegs(ptr, endPtr);
+    decodeSmartComboRoutingParams(ptr, endPtr);
+    decodeScaleOrderParams(ptr, endPtr);
+    decodeHedgeParams(ptr, endPtr);
+    decodeClearingParams(ptr, endPtr);
+    decodeNotHeld(ptr, endPtr);
+    decodeDeltaNeutral(ptr, endPtr);
+    decodeAlgoParams(ptr, endPtr);
+    decodeSolicited(ptr, endPtr);
+    decodeOrderStatus(ptr, endPtr);
+    decodeVolRandomizeFlags(ptr, endPtr);
+    decodePegBenchParams(ptr, endPtr);
+    decodeConditions(ptr, endPtr);
+    decodeStopPriceAndLmtPriceOffset(ptr, endPtr);
+    decodeCashQty(ptr, endPtr);
+    decodeDontUseAutoPriceForHedge(ptr, endPtr);
+    decodeIsOmsContainer(ptr, endPtr);
+    decodeAutoCancelDate(ptr, endPtr);
+    decodeFilledQuantity(ptr, endPtr);
+    decodeRefFuturesConId(ptr, endPtr);
+    decodeAutoCancelParent(ptr, endPtr);
+    decodeShareholder(ptr, endPtr);
+    decodeImbalanceOnly(ptr, endPtr);
+    decodeRouteMarketableToBbo(ptr, endPtr);
+    decodeParentPermId(ptr, endPtr);
+    decodeCompletedTime(ptr, endPtr);
+    decodeCompletedStatus(ptr, endPtr);
+
+    return true;
+}
+
 bool EOrderDecoder::decodeOrderId(const char*& ptr, const char* endPtr) {
     DECODE_FIELD( m_order->orderId);
 
@@ -600,6 +744,10 @@ bool EOrderDecoder::decodeConditions(const char*& ptr, const char* endPtr) {
 
                 std::shared_ptr<OrderCondition> item = std::shared_ptr<OrderCondition>(OrderCondition::create((OrderCondition::OrderConditionType)conditionType));
 
+                // a condition type this API does not know
+                if (!item)
+                    return 0;
+
                 if (!(ptr = item->readExternal(ptr, endPtr)))
                     return 0;
 
@@ -748,3 +896,388 @@ bool EOrderDecoder::decodeUsePriceMgmtAlgo(const char*& ptr, const char* endPtr)
 
     return true;
 }
+
+// The summaries walk the same fields as decodeOpenOrder() and decodeCompletedOrder(), under
+// the same version checks, but only decode what OrderSummary holds or what decides the layout
+// of the rest (counts, the strings and prices that gate optional groups). Keep them in step
+// with the decode* methods above; samples/Cpp/ClientTests/OrderSummaryTest checks that they are.
+
+static bool skipFields(int count, const char*& ptr, const char* endPtr) {
+    for (; count > 0; --count) {
+        if (!EDecoder::CheckOffset(ptr, endPtr))
+            return false;
+
+        const char* fieldEnd = EDecoder::FindFieldEnd(ptr, endPtr);
+
+        if (!fieldEnd)
+            return false;
+
+        ptr = fieldEnd + 1;
+    }
+
+    return true;
+}
+
+#define SKIP_FIELDS(n) if (!skipFields(n, ptr, endPtr)) return false;
+
+static void initSummary(OrderSummary& summary) {
+    summary.orderId = 0;
+    summary.conId = 0;
+    summary.permId = 0;
+    summary.clientId = 0;
+    summary.parentId = 0;
+    summary.action = EStringView();
+    summary.orderType = EStringView();
+    summary.totalQuantity = 0;
+    summary.filledQuantity = UNSET_DOUBLE;
+    summary.lmtPrice = UNSET_DOUBLE;
+    summary.auxPrice = UNSET_DOUBLE;
+    summary.status = EStringView();
+}
+
+bool EOrderDecoder::summarizeOpenOrder(OrderSummary& summary, const char*& ptr, const char* endPtr) {
+    initSummary(summary);
+
+    DECODE_FIELD( summary.orderId);
+
+    // contract
+    DECODE_FIELD( summary.conId);
+    SKIP_FIELDS( m_version >= 32 ? 10 : 8);
+
+    DECODE_FIELD( summary.action);
+    if (m_serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS)	{
+        DECODE_FIELD( summary.totalQuantity);
+    } else {
+        long lTotalQuantity;
+        DECODE_FIELD(lTotalQuantity);
+        summary.totalQuantity = lTotalQuantity;
+    }
+    DECODE_FIELD( summary.orderType);
+    if (m_version < 29) {
+        DECODE_FIELD( summary.lmtPrice);
+    } else {
+        DECODE_FIELD_MAX( summary.lmtPrice);
+    }
+    if (m_version < 30) {
+        DECODE_FIELD( summary.auxPrice);
+    } else {
+        DECODE_FIELD_MAX( summary.auxPrice);
+    }
+
+    // TIF through orderRef
+    SKIP_FIELDS( 6);
+    DECODE_FIELD( summary.clientId);
+    DECODE_FIELD( summary.permId);
+
+    // outsideRth through FA params
+    SKIP_FIELDS( 9);
+    if (m_serverVersion >= MIN_SERVER_VER_MODELS_SUPPORT) {
+        SKIP_FIELDS( 1);
+    }
+
+    // goodTillDate through settlingFirm, short sale params
+    SKIP_FIELDS( 6);
+    if (m_serverVersion == MIN_SERVER_VER_SSHORTX_OLD || m_version >= 23) {
+        SKIP_FIELDS( 1);
+    }
+
+    // auctionStrategy through nbboPriceCap
+    SKIP_FIELDS( 15);
+    DECODE_FIELD( summary.parentId);
+    SKIP_FIELDS( 1);
+
+    if (!skipVolOrderParams(ptr, endPtr, true))
+        return false;
+
+    // trail and basis points params
+    SKIP_FIELDS( m_version >= 30 ? 4 : 3);
+
+    if (!skipComboLegsThroughHedgeParams(ptr, endPtr))
+        return false;
+
+    if (m_version >= 25) {
+        SKIP_FIELDS( 1);
+    }
+
+    // clearing params, notHeld
+    SKIP_FIELDS( m_version >= 22 ? 3 : 2);
+
+    if (m_version >= 20) {
+        bool deltaNeutralContractPresent = false;
+        DECODE_FIELD( deltaNeutralContractPresent);
+        if (deltaNeutralContractPresent) {
+            SKIP_FIELDS( 3);
+        }
+    }
+
+    if (m_version >= 21) {
+        EStringView algoStrategy;
+        DECODE_FIELD( algoStrategy);
+        if (!algoStrategy.empty()) {
+            int algoParamsCount = 0;
+            DECODE_FIELD( algoParamsCount);
+            SKIP_FIELDS( 2 * algoParamsCount);
+        }
+    }
+
+    if (m_version >= 33) {
+        SKIP_FIELDS( 1);
+    }
+
+    // whatIf, order state
+    SKIP_FIELDS( 1);
+    DECODE_FIELD( summary.status);
+    SKIP_FIELDS( m_serverVersion >= MIN_SERVER_VER_WHAT_IF_EXT_FIELDS ? 14 : 8);
+
+    if (m_version >= 34) {
+        SKIP_FIELDS( 2);
+    }
+
+    if (m_serverVersion >= MIN_SERVER_VER_PEGGED_TO_BENCHMARK) {
+        if (summary.orderType == "PEG BENCH") {
+            SKIP_FIELDS( 5);
+        }
+
+        if (!skipConditions(ptr, endPtr))
+            return false;
+
+        // adjusted order params
+        SKIP_FIELDS( 8);
+    }
+
+    if (m_serverVersion >= MIN_SERVER_VER_SOFT_DOLLAR_TIER) {
+        SKIP_FIELDS( 3);
+    }
+    if (m_serverVersion >= MIN_SERVER_VER_CASH_QTY) {
+        SKIP_FIELDS( 1);
+    }
+    if (m_serverVersion >= MIN_SERVER_VER_AUTO_PRICE_FOR_HEDGE) {
+        SKIP_FIELDS( 1);
+    }
+    if (m_serverVersion >= MIN_SERVER_VER_ORDER_CONTAINER) {
+        SKIP_FIELDS( 1);
+    }
+    if (m_serverVersion >= MIN_SERVER_VER_D_PEG_ORDERS) {
+        SKIP_FIELDS( 1);
+    }
+    if (m_serverVersion >= MIN_SERVER_VER_PRICE_MGMT_ALGO) {
+        SKIP_FIELDS( 1);
+    }
+
+    return true;
+}
+
+bool EOrderDecoder::summarizeCompletedOrder(OrderSummary& summary, const char*& ptr, const char* endPtr) {
+    initSummary(summary);
+
+    // contract
+    DECODE_FIELD( summary.conId);
+    SKIP_FIELDS( m_version >= 32 ? 10 : 8);
+
+    DECODE_FIELD( summary.action);
+    if (m_serverVersion >= MIN_SERVER_VER_FRACTIONAL_POSITIONS)	{
+        DECODE_FIELD( summary.totalQuantity);
+    } else {
+        long lTotalQuantity;
+        DECODE_FIELD(lTotalQuantity);
+        summary.totalQuantity = lTotalQuantity;
+    }
+    DECODE_FIELD( summary.orderType);
+    if (m_version < 29) {
+        DECODE_FIELD( summary.lmtPrice);
+    } else {
+        DECODE_FIELD_MAX( summary.lmtPrice);
+    }
+    if (m_version < 30) {
+        DECODE_FIELD( summary.auxPrice);
+    } else {
+        DECODE_FIELD_MAX( summary.auxPrice);
+    }
+
+    // TIF through orderRef
+    SKIP_FIELDS( 6);
+    DECODE_FIELD( summary.permId);
+
+    // outsideRth through FA params
+    SKIP_FIELDS( 8);
+    if (m_serverVersion >= MIN_SERVER_VER_MODELS_SUPPORT) {
+        SKIP_FIELDS( 1);
+    }
+
+    // goodTillDate through settlingFirm, short sale params
+    SKIP_FIELDS( 6);
+    if (m_serverVersion == MIN_SERVER_VER_SSHORTX_OLD || m_version >= 23) {
+        SKIP_FIELDS( 1);
+    }
+
+    // box and peg to stock params through ocaType, triggerMethod
+    SKIP_FIELDS( 11);
+
+    if (!skipVolOrderParams(ptr, endPtr, false))
+        return false;
+
+    // trail params
+    SKIP_FIELDS( m_version >= 30 ? 2 : 1);
+
+    if (!skipComboLegsThroughHedgeParams(ptr, endPtr))
+        return false;
+
+    // clearing params, notHeld
+    SKIP_FIELDS( m_version >= 22 ? 3 : 2);
+
+    if (m_version >= 20) {
+        bool deltaNeutralContractPresent = false;
+        DECODE_FIELD( deltaNeutralContractPresent);
+        if (deltaNeutralContractPresent) {
+            SKIP_FIELDS( 3);
+        }
+    }
+
+    if (m_version >= 21) {
+        EStringView algoStrategy;
+        DECODE_FIELD( algoStrategy);
+        if (!algoStrategy.empty()) {
+            int algoParamsCount = 0;
+            DECODE_FIELD( algoParamsCount);
+            SKIP_FIELDS( 2 * algoParamsCount);
+        }
+    }
+
+    if (m_version >= 33) {
+        SKIP_FIELDS( 1);
+    }
+
+    DECODE_FIELD( summary.status);
+
+    if (m_version >= 34) {
+        SKIP_FIELDS( 2);
+    }
+
+    if (m_serverVersion >= MIN_SERVER_VER_PEGGED_TO_BENCHMARK) {
+        if (summary.orderType == "PEG BENCH") {
+            SKIP_FIELDS( 5);
+        }
+
+        if (!skipConditions(ptr, endPtr))
+            return false;
+    }
+
+    // stop price and limit price offset
+    SKIP_FIELDS( 2);
+
+    if (m_serverVersion >= MIN_SERVER_VER_CASH_QTY) {
+        SKIP_FIELDS( 1);
+    }
+    if (m_serverVersion >= MIN_SERVER_VER_AUTO_PRICE_FOR_HEDGE) {
+        SKIP_FIELDS( 1);
+    }
+    if (m_serverVersion >= MIN_SERVER_VER_ORDER_CONTAINER) {
+        SKIP_FIELDS( 1);
+    }
+
+    // autoCancelDate, filledQuantity
+    SKIP_FIELDS( 1);
+    DECODE_FIELD( summary.filledQuantity);
+
+    // refFuturesConId through completedStatus
+    SKIP_FIELDS( 8);
+
+    return true;
+}
+
+bool EOrderDecoder::skipVolOrderParams(const char*& ptr, const char* endPtr, bool decodeOpenOrderAttribs) {
+    EStringView deltaNeutralOrderType;
+
+    SKIP_FIELDS( 2);
+    DECODE_FIELD( deltaNeutralOrderType);
+    SKIP_FIELDS( 1);
+
+    if (m_version >= 27 && !deltaNeutralOrderType.empty()) {
+        SKIP_FIELDS( decodeOpenOrderAttribs ? 4 : 1);
+    }
+
+    if (m_version >= 31 && !deltaNeutralOrderType.empty()) {
+        SKIP_FIELDS( decodeOpenOrderAttribs ? 4 : 3);
+    }
+
+    SKIP_FIELDS( 2);
+
+    return true;
+}
+
+bool EOrderDecoder::skipComboLegsThroughHedgeParams(const char*& ptr, const char* endPtr) {
+    // comboLegsDescrip
+    SKIP_FIELDS( 1);
+
+    if (m_version >= 29) {
+        int comboLegsCount = 0;
+        DECODE_FIELD( comboLegsCount);
+        SKIP_FIELDS( 8 * comboLegsCount);
+
+        int orderComboLegsCount = 0;
+        DECODE_FIELD( orderComboLegsCount);
+        SKIP_FIELDS( orderComboLegsCount);
+    }
+
+    if (m_version >= 26) {
+        int smartComboRoutingParamsCount = 0;
+        DECODE_FIELD( smartComboRoutingParamsCount);
+        SKIP_FIELDS( 2 * smartComboRoutingParamsCount);
+    }
+
+    // scale order params
+    double scalePriceIncrement;
+
+    SKIP_FIELDS( 2);
+    DECODE_FIELD_MAX( scalePriceIncrement);
+
+    if (m_version >= 28 && scalePriceIncrement > 0.0 && scalePriceIncrement != UNSET_DOUBLE) {
+        SKIP_FIELDS( 7);
+    }
+
+    if (m_version >= 24) {
+        EStringView hedgeType;
+        DECODE_FIELD( hedgeType);
+        if (!hedgeType.empty()) {
+            SKIP_FIELDS( 1);
+        }
+    }
+
+    return true;
+}
+
+bool EOrderDecoder::skipConditions(const char*& ptr, const char* endPtr) {
+    int conditionsSize;
+
+    DECODE_FIELD( conditionsSize);
+
+    if (conditionsSize > 0) {
+        for (; conditionsSize; conditionsSize--) {
+            int conditionType;
+
+            DECODE_FIELD( conditionType);
+
+            std::shared_ptr<OrderCondition> item = std::shared_ptr<OrderCondition>(OrderCondition::create((OrderCondition::OrderConditionType)conditionType));
+
+            if (!item)
+                return false;
+
+            if (!(ptr = item->readExternal(ptr, endPtr)))
+                return false;
+        }
+
+        SKIP_FIELDS( 2);
+    }
+
+    return true;
+}
+
+void EOrderMessage::decode(Contract &contract, Order &order, OrderState &orderState) const {
+    const char* ptr = m_begin;
+    EOrderDecoder eOrderDecoder(&contract, &order, &orderState, m_version, m_serverVersion);
+
+    if (m_completed)
+        eOrderDecoder.decodeCompletedOrder(ptr, m_end);
+    else
+        eOrderDecoder.decodeOpenOrder(ptr, m_end);
+}
@@ -10,6 +10,7 @@
 #include "Order.h"
 #include "OrderState.h"
 #include "EDecoder.h"
+#include "EOrderView.h"
 
 class EOrderDecoder
 {
@@ -17,6 +18,15 @@ public:
 	EOrderDecoder(Contract *contract, Order *order, OrderState *orderState, int version, int serverVersion);
 
 public:
+	// the whole message, in the order OPEN_ORDER and COMPLETED_ORDER carry the fields
+	bool decodeOpenOrder(const char*& ptr, const char* endPtr);
+	bool decodeCompletedOrder(const char*& ptr, const char* endPtr);
+
+	// step over the whole message decoding only the OrderSummary fields, needs no
+	// Contract, Order or OrderState
+	bool summarizeOpenOrder(OrderSummary& summary, const char*& ptr, const char* endPtr);
+	bool summarizeCompletedOrder(OrderSummary& summary, const char*& ptr, const char* endPtr);
+
 	bool decodeOrderId(const char*& ptr, const char* endPtr);
 	bool decodeContract(const char*& ptr, const char* endPtr);
 	bool decodeAction(const char*& ptr, const char* endPtr);
@@ -96,6 +106,10 @@ public:
 	bool decodeUsePriceMgmtAlgo(const char*& ptr, const char* endPtr);
 
 private:
+	bool skipVolOrderParams(const char*& ptr, const char* endPtr, bool decodeOpenOrderAttribs);
+	bool skipComboLegsThroughHedgeParams(const char*& ptr, const char* endPtr);
+	bool skipConditions(const char*& ptr, const char* endPtr);
+
 	Contract* m_contract;
 	Order* m_order;
 	OrderState* m_orderState;
@@ -0,0 +1,49 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EORDERREQUEST_H
+#define TWS_API_CLIENT_EORDERREQUEST_H
+
+#include "platformspecific.h"
+#include "CommonDefs.h"
+
+struct Contract;
+struct Order;
+class EOrderTemplate;
+
+enum OrderRequestStatus {
+    ORDER_REQUEST_PENDING,       // not yet passed to placeOrders() or cancelOrders()
+    ORDER_REQUEST_SENT,          // encoded and handed to the transport with the rest; what a full
+                                 // socket did not take yet goes out with the following sends
+    ORDER_REQUEST_REJECTED,      // not encoded, the reason went to EWrapper::error()
+    ORDER_REQUEST_FAILED         // encoded, but the flush failed and the connection was closed
+};
+
+// One order of EClient::placeOrders(): either a Contract and Order, placed as placeOrder()
+// would, or an EOrderTemplate with its quantity and limit price. The objects pointed to only
+// need to outlive the call. EClient::cancelOrders() only reads orderId.
+struct OrderRequest
+{
+    OrderId orderId;
+    const Contract *contract;
+    const Order *order;
+    const EOrderTemplate *tmpl;
+    double quantity;
+    double lmtPrice;
+    OrderRequestStatus status;
+
+    OrderRequest()
+        : orderId(0), contract(0), order(0), tmpl(0), quantity(0), lmtPrice(0), status(ORDER_REQUEST_PENDING) {}
+
+    explicit OrderRequest(OrderId id)
+        : orderId(id), contract(0), order(0), tmpl(0), quantity(0), lmtPrice(0), status(ORDER_REQUEST_PENDING) {}
+
+    OrderRequest(OrderId id, const Contract &c, const Order &o)
+        : orderId(id), contract(&c), order(&o), tmpl(0), quantity(0), lmtPrice(0), status(ORDER_REQUEST_PENDING) {}
+
+    OrderRequest(const EOrderTemplate &t, OrderId id, double qty, double price)
+        : orderId(id), contract(0), order(0), tmpl(&t), quantity(qty), lmtPrice(price), status(ORDER_REQUEST_PENDING) {}
+};
+
+#endif
@@ -0,0 +1,65 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EORDERTEMPLATE_H
+#define TWS_API_CLIENT_EORDERTEMPLATE_H
+
+#include <vector>
+#include <string.h>
+#include "platformspecific.h"
+
+// A PLACE_ORDER message encoded once by EClient::prepareOrder() and then sent any number of
+// times by EClient::placeOrder(const EOrderTemplate&, ...), which copies it and re-encodes only
+// the order id, quantity and limit price. Only valid on connections with the server version it
+// was prepared for.
+class TWSAPIDLLEXP EOrderTemplate
+{
+public:
+    enum Field { ORDER_ID, QUANTITY, LMT_PRICE, FIELD_COUNT };
+
+private:
+    friend class EClient;
+
+    std::vector<char> m_bytes;         // the whole message, length prefix slot included
+    size_t m_begin[FIELD_COUNT];       // where each replaced field starts in m_bytes
+    size_t m_end[FIELD_COUNT];         // and one past its terminating 0
+    int m_serverVersion;               // 0 until prepared
+    bool m_useV100Plus;
+
+    void mark(Field field, size_t offset) { m_begin[field] = offset; }
+
+    void capture(const char *data, size_t size, int serverVersion, bool useV100Plus) {
+        m_bytes.assign(data, data + size);
+
+        for (int i = 0; i < FIELD_COUNT; ++i) {
+            if (m_begin[i] >= size || (i > 0 && m_begin[i] < m_end[i - 1]))
+                return;
+
+            const char *end = (const char *)memchr(&m_bytes[m_begin[i]], 0, size - m_begin[i]);
+            if (!end)
+                return;
+
+            m_end[i] = end + 1 - &m_bytes[0];
+        }
+
+        m_serverVersion = serverVersion;
+        m_useV100Plus = useV100Plus;
+    }
+
+public:
+    EOrderTemplate() { reset(); }
+
+    void reset() {
+        m_bytes.clear();
+        for (int i = 0; i < FIELD_COUNT; ++i)
+            m_begin[i] = m_end[i] = (size_t)-1;
+        m_serverVersion = 0;
+        m_useV100Plus = false;
+    }
+
+    bool ready() const { return m_serverVersion != 0; }
+    int serverVersion() const { return m_serverVersion; }
+};
+
+#endif
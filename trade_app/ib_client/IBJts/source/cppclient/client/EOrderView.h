@@ -0,0 +1,66 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EORDERVIEW_H
+#define TWS_API_CLIENT_EORDERVIEW_H
+
+#include "platformspecific.h"
+#include "CommonDefs.h"
+#include "EWrapperView.h"
+
+struct Contract;
+struct Order;
+struct OrderState;
+
+// The few fields of an openOrder or completedOrder message an order tracker needs, picked
+// out while the rest of the message is stepped over undecoded. The views point into the
+// received message and are only valid until the callback returns.
+struct OrderSummary
+{
+    OrderId orderId;             // openOrder only, 0 for completed orders
+    long conId;
+    int permId;
+    long clientId;               // openOrder only
+    long parentId;               // openOrder only
+    EStringView action;
+    EStringView orderType;
+    double totalQuantity;
+    double filledQuantity;       // completedOrder only, UNSET_DOUBLE otherwise
+    double lmtPrice;
+    double auxPrice;
+    EStringView status;
+};
+
+// Where the order's fields start in the received message, so the whole Contract, Order and
+// OrderState can still be decoded if a callback needs them. Only valid until it returns.
+class TWSAPIDLLEXP EOrderMessage
+{
+    const char *m_begin;
+    const char *m_end;
+    int m_version;
+    int m_serverVersion;
+    bool m_completed;
+
+public:
+    EOrderMessage(const char *begin, const char *end, int version, int serverVersion, bool completed)
+        : m_begin(begin), m_end(end), m_version(version), m_serverVersion(serverVersion), m_completed(completed) {}
+
+    // the same objects EWrapper::openOrder() / completedOrder() would have been passed
+    void decode(Contract &contract, Order &order, OrderState &orderState) const;
+};
+
+// Opt-in summary delivery of orders. Once a view is installed (EReader::orderView()),
+// OPEN_ORDER and COMPLETED_ORDER only have their OrderSummary fields decoded and go here
+// instead of to EWrapper::openOrder() and completedOrder(), so an openOrder storm (e.g.
+// reqAllOpenOrders() after a reconnect) does not build a Contract, Order and OrderState each.
+class TWSAPIDLLEXP EOrderView
+{
+public:
+    virtual ~EOrderView() {}
+
+    virtual void openOrder(const OrderSummary &summary, const EOrderMessage &message) = 0;
+    virtual void completedOrder(const OrderSummary &summary, const EOrderMessage &message) = 0;
+};
+
+#endif
@@ -10,6 +10,7 @@
 	// Windows
 	// includes
 	#include <WinSock2.h>
+	#include <WS2tcpip.h>
 	#include <time.h>
 
 	// defines
@@ -34,11 +35,29 @@
 		return ( ioctlsocket( sockfd, FIONBIO, &mode) == 0);
 	}
 
+	inline bool SetSocketBlocking(int sockfd) {
+		unsigned long mode = 0;
+		return ( ioctlsocket( sockfd, FIONBIO, &mode) == 0);
+	}
+
+	// non-blocking connect() still under way
+	inline bool SocketConnectPending() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+
+	inline int SocketPendingError(int sockfd) {
+		int err = 0;
+		int len = sizeof(err);
+		if ( getsockopt( sockfd, SOL_SOCKET, SO_ERROR, (char*)&err, &len) != 0)
+			return WSAGetLastError();
+		return err;
+	}
+
 #else
 	// LINUX
 	// includes
 
 	#include <arpa/inet.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
 	#include <netdb.h>
 	#include <errno.h>
 	#include <sys/select.h>
@@ -60,6 +79,25 @@
 		return ( fcntl(sockfd, F_SETFL, flags | O_NONBLOCK) == 0);
 	}
 
+	inline bool SetSocketBlocking(int sockfd) {
+		int flags = fcntl(sockfd, F_GETFL);
+		if (flags == -1)
+			return false;
+
+		return ( fcntl(sockfd, F_SETFL, flags & ~O_NONBLOCK) == 0);
+	}
+
+	// non-blocking connect() still under way
+	inline bool SocketConnectPending() { return errno == EINPROGRESS; }
+
+	inline int SocketPendingError(int sockfd) {
+		int err = 0;
+		socklen_t len = sizeof(err);
+		if ( getsockopt( sockfd, SOL_SOCKET, SO_ERROR, &err, &len) != 0)
+			return errno;
+		return err;
+	}
+
 #endif
 
 #endif
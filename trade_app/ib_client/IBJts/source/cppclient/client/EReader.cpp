@@ -10,14 +10,30 @@
 #include "EPosixClientSocketPlatform.h"
 #include "EReaderSignal.h"
 #include "EMessage.h"
+#include "EReaderEventLoop.h"
 #include "DefaultEWrapper.h"
+#include "EIoUring.h"
+#include "EStaticDecoder.h"
+
+#include <chrono>
+#include <string.h>
+#include <thread>
 
 #define IN_BUF_SIZE_DEFAULT 8192
+#define IN_BUF_SLAB_SIZE (IN_BUF_SIZE_DEFAULT * 8)
+#define SOCKET_WAIT_TIMEOUT_MS 100
+#define SHRINK_AFTER_FRAMES 64
+#define LEGACY_EAGER_BYTES (64 * 1024)
+#define LEGACY_RETRY_WAIT_MS 1
+#define URING_BUF_COUNT 64
+#define URING_BUF_SIZE (IN_BUF_SIZE_DEFAULT * 2)
 
 static DefaultEWrapper defaultWrapper;
 
-EReader::EReader(EClientSocket *clientSocket, EReaderSignal *signal)
+EReader::EReader(EClientSocket *clientSocket, EReaderSignal *signal, unsigned int queueCapacity)
 	: processMsgsDecoder_(clientSocket->EClient::serverVersion(), clientSocket->getWrapper(), clientSocket)
+	, m_pMsgDecoder(0)
+    , m_buf(IN_BUF_SLAB_SIZE)
 #if defined(IB_POSIX)
     , m_hReadThread(pthread_self())
 #elif defined(IB_WIN32)
@@ -28,10 +44,32 @@ EReader::EReader(EClientSocket *clientSocket, EReaderSignal *signal)
         m_pClientSocket = clientSocket;       
 		m_pEReaderSignal = signal;
 		m_nMaxBufSize = IN_BUF_SIZE_DEFAULT;
-		m_buf.reserve(IN_BUF_SIZE_DEFAULT);
+		m_smallFrames = 0;
+		m_legacyFramed = 0;
+		m_legacyScanned = 0;
+		m_legacyRetryDue = false;
+		m_pEventLoop = 0;
+		m_pMsgRing = queueCapacity > 0 ? new ESpscQueue<EMessage*>(queueCapacity) : 0;
+#if defined(IBAPI_EPOLL)
+		m_epollFd = -1;
+		m_epollSockFd = -1;
+		m_epollOut = false;
+		m_canRead = false;
+		m_ringFull = false;
+		m_epollIn = true;
+#endif
+#if defined(IBAPI_IO_URING)
+		m_pUring = 0;
+		m_uringFailed = false;
+#endif
 }
 
 EReader::~EReader(void) {
+    if (m_pEventLoop) {
+        m_isAlive = false;
+        m_pEventLoop->remove(this);
+        m_pClientSocket->eDisconnect();
+    }
 #if defined(IB_POSIX)
     if (!pthread_equal(pthread_self(), m_hReadThread)) {
         m_isAlive = false;
@@ -45,6 +83,24 @@ EReader::~EReader(void) {
         WaitForSingleObject(m_hReadThread, INFINITE);
     }
 #endif
+#if defined(IBAPI_EPOLL)
+    if (m_epollFd >= 0)
+        close(m_epollFd);
+#endif
+#if defined(IBAPI_IO_URING)
+    delete m_pUring;
+#endif
+    if (m_pMsgRing) {
+        EMessage *msg;
+
+        while (m_pMsgRing->tryPop(msg))
+            delete msg;
+
+        delete m_pMsgRing;
+    }
+
+    for (std::deque<EMessage*>::iterator it = m_msgQueue.begin(); it != m_msgQueue.end(); ++it)
+        delete *it;
 }
 
 void EReader::start() {
@@ -57,6 +113,12 @@ void EReader::start() {
 #endif
 }
 
+void EReader::start(EReaderEventLoop *eventLoop) {
+	// fall back to a dedicated reader thread when the loop cannot take the socket
+	if (!eventLoop || !eventLoop->add(this))
+		start();
+}
+
 #if defined(IB_POSIX)
 void * EReader::readToQueueThread(void * lpParam)
 #elif defined(IB_WIN32)
@@ -95,22 +157,76 @@ bool EReader::putMessageToQueue() {
 	if (msg == 0)
 		return false;
 
-	{
-		EMutexGuard lock(m_csMsgQueue);
-		m_msgQueue.push_back(std::shared_ptr<EMessage>(msg));
-	}
+	pushMsg(msg);
 
 	m_pEReaderSignal->issueSignal();
 
 	return true;
 }
 
+void EReader::pushMsg(EMessage *msg) {
+	if (m_pMsgRing) {
+		// ring full: wake the consumer and wait for a free slot. Only the dedicated reader
+		// thread waits here, processEvents() checks ringFull() and pauses instead.
+		while (!m_pMsgRing->tryPush(msg)) {
+			if (!m_isAlive) {
+				delete msg;
+				return;
+			}
+
+			m_pEReaderSignal->issueSignal();
+			std::this_thread::yield();
+		}
+
+		return;
+	}
+
+	EMutexGuard lock(m_csMsgQueue);
+	m_msgQueue.push_back(msg);
+}
+
 bool EReader::processNonBlockingSelect() {
+	return waitAndReceive(SOCKET_WAIT_TIMEOUT_MS);
+}
+
+bool EReader::waitAndReceive(int timeoutMs) {
+	size_t buffered = m_buf.size();
+	// legacy framing held back by legacyFramingDue(): wait only a moment, a peer that has
+	// gone quiet may well have completed the frame
+	bool framingHeld = m_legacyFramed > 0 && m_legacyScanned < buffered;
+
+	if (framingHeld && timeoutMs > LEGACY_RETRY_WAIT_MS)
+		timeoutMs = LEGACY_RETRY_WAIT_MS;
+
+	bool received = pollSocket(timeoutMs);
+
+	if (framingHeld && m_buf.size() == buffered)
+		m_legacyRetryDue = true;
+
+	return received;
+}
+
+bool EReader::pollSocket(int timeoutMs) {
+#if defined(IBAPI_IO_URING)
+	bool handled;
+	bool received = processUring(timeoutMs, handled);
+
+	if (handled)
+		return received;
+#endif
+#if defined(IBAPI_EPOLL)
+	if (m_epollFd < 0)
+		m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+	if (m_epollFd >= 0)
+		return processNonBlockingEpoll(timeoutMs);
+#endif
+
 	fd_set readSet, writeSet, errorSet;
 	struct timeval tval;
 
-	tval.tv_usec = 100 * 1000; //100 ms
-	tval.tv_sec = 0;
+	tval.tv_usec = (timeoutMs % 1000) * 1000;
+	tval.tv_sec = timeoutMs / 1000;
 
 	if( m_pClientSocket->fd() >= 0 ) {
 
@@ -164,127 +280,568 @@ bool EReader::processNonBlockingSelect() {
 	return false;
 }
 
+#if defined(IBAPI_EPOLL)
+bool EReader::epollCtl(int epollFd, int op, bool out) {
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = (m_ringFull ? 0 : EPOLLIN) | EPOLLRDHUP | EPOLLET | (out ? EPOLLOUT : 0);
+	ev.data.ptr = this;
+
+	if (epoll_ctl(epollFd, op, m_pClientSocket->fd(), &ev) < 0)
+		return false;
+
+	m_epollOut = out;
+	m_epollIn = !m_ringFull;
+	return true;
+}
+
+bool EReader::updateEpollInterest(int epollFd) {
+	int fd = m_pClientSocket->fd();
+
+	if (fd < 0)
+		return false;
+
+	if (fd != m_epollSockFd) {
+		// new socket (first use or redirect): register it and assume data may already be waiting
+		if (!epollCtl(epollFd, EPOLL_CTL_ADD, !m_pClientSocket->getTransport()->isOutBufferEmpty()) && errno != EEXIST)
+			return false;
+
+		m_epollSockFd = fd;
+		m_canRead = true;
+		return true;
+	}
+
+	// write readiness is only interesting while the transport holds unsent data
+	bool out = !m_pClientSocket->getTransport()->isOutBufferEmpty();
+
+	if (out != m_epollOut || m_epollIn == m_ringFull)
+		return epollCtl(epollFd, EPOLL_CTL_MOD, out);
+
+	return true;
+}
+
+bool EReader::processNonBlockingEpoll(int timeoutMs) {
+	if (m_pClientSocket->fd() < 0)
+		return false;
+
+	if (!updateEpollInterest(m_epollFd)) {
+		m_pClientSocket->eDisconnect();
+		return false;
+	}
+
+	// edge-triggered: keep reading until a short read shows the socket is drained
+	if (m_canRead) {
+		onReceive();
+		return true;
+	}
+
+	struct epoll_event ev;
+	int ret = epoll_wait(m_epollFd, &ev, 1, timeoutMs);
+
+	if (ret == 0) { // timeout
+		// a closed and reused descriptor silently drops out of the set, re-register if so
+		if (!epollCtl(m_epollFd, EPOLL_CTL_MOD, m_epollOut) && errno == ENOENT)
+			m_epollSockFd = -1;
+		errno = 0;
+		return false;
+	}
+
+	if (ret < 0) {
+		if (errno == EINTR) {
+			errno = 0;
+			return false;
+		}
+		m_pClientSocket->eDisconnect();
+		return false;
+	}
+
+	if (m_pClientSocket->fd() < 0)
+		return false;
+
+	if (ev.events & EPOLLERR) {
+		// error on socket
+		m_pClientSocket->onError();
+	}
+
+	if (m_pClientSocket->fd() < 0)
+		return false;
+
+	if (ev.events & EPOLLOUT) {
+		// socket is ready for writing
+		onSend();
+	}
+
+	if (m_pClientSocket->fd() < 0)
+		return false;
+
+	if (ev.events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP)) {
+		// socket is ready for reading
+		m_canRead = true;
+		onReceive();
+	}
+
+	return true;
+}
+
+bool EReader::ringFull() {
+	return m_pMsgRing && m_pMsgRing->full();
+}
+
+bool EReader::processEvents(unsigned int events) {
+	if (m_pClientSocket->isSocketOK()) {
+		if (events & EPOLLERR)
+			m_pClientSocket->onError();
+
+		if ((events & EPOLLOUT) && m_pClientSocket->isSocketOK())
+			onSend();
+
+		if (events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP))
+			m_canRead = true;
+	}
+
+	// the consumer has made room again: resume with what is buffered, then the socket
+	if (m_ringFull && !ringFull()) {
+		m_ringFull = false;
+		m_canRead = true;
+	}
+
+	int frameSize = 0;
+	bool queued = false;
+	bool received = false;
+
+	for (;;) {
+		while (!m_ringFull && (frameSize = nextMsgSize()) > 0) {
+			if (!acceptFrame(frameSize)) {
+				consumeFrame(frameSize);
+				continue;
+			}
+
+			// never wait for a slow consumer here, that would stall every connection on the
+			// loop: leave the frames in m_buf and the rest in the socket until it catches up
+			if (ringFull()) {
+				m_ringFull = true;
+
+				// drained in between by a consumer that did not see the flag yet
+				if (ringFull())
+					break;
+
+				m_ringFull = false;
+			}
+
+			pushMsg(extractMsg(frameSize));
+			queued = true;
+		}
+
+		// frames held back go out before the socket is read again, so the buffer never holds
+		// more than one read past them and an end of stream is only seen once they are queued.
+		// One read per wakeup keeps a busy connection from starving the others on the loop.
+		if (m_ringFull || frameSize < 0 || received || !m_canRead || !m_pClientSocket->isSocketOK())
+			break;
+
+		onReceive();
+		received = true;
+	}
+
+	if (queued || m_ringFull)
+		m_pEReaderSignal->issueSignal();
+
+	// frames held back by a full ring are still delivered once the connection is gone
+	if (m_ringFull && m_isAlive)
+		return true;
+
+	if (frameSize == 0 && m_isAlive && m_pClientSocket->isSocketOK())
+		return true;
+
+	m_canRead = false;
+	m_pClientSocket->handleSocketError();
+	m_pEReaderSignal->issueSignal(); //letting client know that socket was closed
+	return false;
+}
+#endif
+
+#if defined(IBAPI_IO_URING)
+bool EReader::processUring(int timeoutMs, bool &handled) {
+	int fd = m_pClientSocket->fd();
+
+	if (m_pUring && m_pUring->sockFd() != fd) {
+		// disconnected or redirected: the pending recv pins the old socket open until the ring goes
+		delete m_pUring;
+		m_pUring = 0;
+	}
+
+	// readers on a shared loop keep using epoll. The handshake reader never gets a ring:
+	// a multishot recv left armed while it goes away would swallow the server's first replies.
+	handled = !m_uringFailed && !m_pEventLoop && fd >= 0 && m_pClientSocket->EClient::serverVersion() > 0;
+
+	if (!handled)
+		return false;
+
+	if (!m_pUring) {
+		m_pUring = new EIoUring();
+
+		if (!m_pUring->init(fd, URING_BUF_COUNT, URING_BUF_SIZE)) {
+			delete m_pUring;
+			m_pUring = 0;
+			m_uringFailed = true;
+			handled = false;
+			errno = 0;
+			return false;
+		}
+	}
+
+	// sends stay on the socket; while some are pending keep waking the client thread to flush them
+	if (!m_pClientSocket->getTransport()->isOutBufferEmpty()) {
+		onSend();
+		timeoutMs = 1;
+	}
+
+	m_pUring->wait(timeoutMs);
+
+	if (m_pUring->unsupported()) {
+		delete m_pUring;
+		m_pUring = 0;
+		m_uringFailed = true;
+		handled = false;
+		return false;
+	}
+
+	if (!m_pUring->hasData() && !m_pUring->eof() && !m_pUring->error())
+		return false;
+
+	onReceive();
+	return true;
+}
+#endif
+
 void EReader::onSend() {
 	m_pEReaderSignal->issueSignal();
 }
 
 void EReader::onReceive() {
-	int nOffset = m_buf.size();
-
-	m_buf.resize(m_nMaxBufSize);
-	
-	int nRes = m_pClientSocket->receive(m_buf.data() + nOffset, m_buf.size() - nOffset);
+	size_t space;
+	char *pWrite = m_buf.prepareWrite(m_nMaxBufSize, space);
 
-	if (nRes <= 0)
+	if (space == 0)
 		return;
 
- 	m_buf.resize(nRes + nOffset);	
-}
+#if defined(IBAPI_IO_URING)
+	if (m_pUring && m_pUring->sockFd() == m_pClientSocket->fd()) {
+		int nRead = m_pUring->read(pWrite, space);
 
-bool EReader::bufferedRead(char *buf, unsigned int size) {
-	while (size > 0) {
-		while (m_buf.size() < size && m_buf.size() < m_nMaxBufSize) {
-			if (!processNonBlockingSelect() && !m_pClientSocket->isSocketOK())
-				return false;
+		if (nRead > 0) {
+			m_lastReceiveTime.nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+			m_lastReceiveTime.kernel = false;
+			m_buf.commit(nRead);
+		}
+		else if (m_pUring->eof() || m_pUring->error()) {
+			errno = m_pUring->error();
+			delete m_pUring;
+			m_pUring = 0;
+
+			if (errno == 0)
+				m_pClientSocket->onClose();
+			else
+				m_pClientSocket->handleSocketError();
 		}
 
-		int nBytes = (std::min<unsigned int>)(m_nMaxBufSize, size);
+		return;
+	}
+#endif
 
-		std::copy(m_buf.begin(), m_buf.begin() + nBytes, buf);
-		std::copy(m_buf.begin() + nBytes, m_buf.end(), m_buf.begin());
-		m_buf.resize(m_buf.size() - nBytes);
+	int nRes = m_pClientSocket->receive(pWrite, space, &m_lastReceiveTime);
 
-		size -= nBytes;
-		buf += nBytes;
+	if (nRes <= 0) {
+#if defined(IBAPI_EPOLL)
+		m_canRead = false;
+#endif
+		return;
 	}
 
-	return true;
+	m_buf.commit(nRes);
+#if defined(IBAPI_EPOLL)
+	// a short read drained the socket, the next edge will report new data
+	m_canRead = (size_t)nRes == space;
+#endif
 }
 
-EMessage * EReader::readSingleMsg() {
+int EReader::nextMsgSize() {
+	// size of the first complete frame held in m_buf, 0 if more data is needed, -1 if the stream is corrupt
 	if (m_pClientSocket->usingV100Plus()) {
-		int msgSize;
-
-		if (!bufferedRead((char *)&msgSize, sizeof(msgSize)))
+		if (m_buf.size() < (size_t)HEADER_LEN)
 			return 0;
 
-		msgSize = ntohl(msgSize);
+		unsigned int netLen;
+
+		memcpy(&netLen, m_buf.begin(), HEADER_LEN);
+
+		int msgSize = ntohl(netLen);
 
 		if (msgSize <= 0 || msgSize > MAX_MSG_LEN)
-			return 0;
+			return -1;
 
-		std::vector<char> buf = std::vector<char>(msgSize);
+		// let the buffer grow until it can hold the whole frame
+		if (m_nMaxBufSize < (unsigned int)(msgSize + HEADER_LEN))
+			m_nMaxBufSize = msgSize + HEADER_LEN;
+
+		return m_buf.size() >= (size_t)(msgSize + HEADER_LEN) ? msgSize + HEADER_LEN : 0;
+	}
+	else {
+		if (m_buf.size() >= m_nMaxBufSize * 3/4) 
+			m_nMaxBufSize *= 2;
 
-		if (!bufferedRead(buf.data(), buf.size()))
+		if (m_buf.empty() || !legacyFramingDue())
 			return 0;
 
-		return new EMessage(buf);
+		const char *pBegin = m_buf.begin();
+		int frameSize = EDecoder(m_pClientSocket->EClient::serverVersion(), &defaultWrapper).parseAndProcessMsg(pBegin, m_buf.end());
+
+		// a dry run that fails has walked every complete field in the buffer
+		m_legacyFramed = frameSize > 0 ? 0 : m_buf.size();
+		m_legacyScanned = m_legacyFramed;
+		m_legacyRetryDue = false;
+
+		return frameSize;
 	}
-	else {
-		const char *pBegin = 0;
-		const char *pEnd = 0;
-		int msgSize = 0;
-
-		while (msgSize == 0)
-		{
-			if (m_buf.size() >= m_nMaxBufSize * 3/4) 
-				m_nMaxBufSize *= 2;
-
-			if (!processNonBlockingSelect() && !m_pClientSocket->isSocketOK())
-				return 0;
-		
-			pBegin = m_buf.data();
-			pEnd = pBegin + m_buf.size();
-			msgSize = EDecoder(m_pClientSocket->EClient::serverVersion(), &defaultWrapper).parseAndProcessMsg(pBegin, pEnd);
+}
+
+bool EReader::legacyFramingDue() {
+	// Without a length prefix a frame is only found by a dry-run decode from its start, so
+	// retrying on every read of a frame that trickles in would cost quadratic time.
+	if (m_legacyFramed == 0)
+		return true;
+
+	size_t size = m_buf.size();
+
+	// the last attempt stopped at the first incomplete field, it cannot get further until a field ends
+	const char *fieldEnd = m_legacyScanned < size
+		? (const char *)memchr(m_buf.begin() + m_legacyScanned, 0, size - m_legacyScanned) : 0;
+
+	if (!fieldEnd) {
+		m_legacyScanned = size;
+		return false;
+	}
+
+	m_legacyScanned = fieldEnd - m_buf.begin();
+
+	// past LEGACY_EAGER_BYTES hold the retry back until the data it has not seen is as large as
+	// what it re-walks, or the peer pauses (waitAndReceive()); the dry runs over one frame then
+	// add up to a small multiple of its size. A shared event loop does its own waiting, so
+	// readers on one do not hold back.
+	return m_legacyRetryDue || m_pEventLoop || m_legacyFramed <= LEGACY_EAGER_BYTES
+		|| size - m_legacyFramed >= m_legacyFramed;
+}
+
+bool EReader::acceptFrame(int frameSize) {
+	// the frame carrying the server version has no msgId, nothing is dropped before it is in
+	if (m_pClientSocket->EClient::serverVersion() <= 0)
+		return true;
+
+	int offset = m_pClientSocket->usingV100Plus() ? HEADER_LEN : 0;
+	const char *ptr = m_buf.begin() + offset;
+	int msgId;
+
+	if (!EDecoder::DecodeField(msgId, ptr, m_buf.begin() + frameSize))
+		return true;
+
+	return m_msgFilter.accepts(msgId);
+}
+
+EMessage * EReader::extractMsg(int frameSize) {
+	int offset = m_pClientSocket->usingV100Plus() ? HEADER_LEN : 0;
+	EMessage * msg = new EMessage(m_buf.slab(), m_buf.begin() + offset, m_buf.begin() + frameSize);
+
+	msg->receiveTime(m_lastReceiveTime);
+
+	consumeFrame(frameSize);
+	return msg;
+}
+
+void EReader::consumeFrame(int frameSize) {
+	m_buf.consume(frameSize);
+
+	if (m_nMaxBufSize <= IN_BUF_SIZE_DEFAULT)
+		return;
+
+	// back to the default window only after a run of ordinary frames, so a stream of large
+	// ones (historical data, open orders) does not regrow the buffer for each of them
+	if ((unsigned int)frameSize > IN_BUF_SIZE_DEFAULT) {
+		m_smallFrames = 0;
+	}
+	else if (++m_smallFrames >= SHRINK_AFTER_FRAMES && m_buf.size() < IN_BUF_SIZE_DEFAULT) {
+		m_nMaxBufSize = IN_BUF_SIZE_DEFAULT;
+		m_smallFrames = 0;
+		m_buf.shrink();
+	}
+}
+
+int EReader::decodeBuffered() {
+	// decode every complete frame in place, straight out of the receive buffer
+	int offset = m_pClientSocket->usingV100Plus() ? HEADER_LEN : 0;
+	int frameSize;
+	int count = 0;
+
+	while ((frameSize = nextMsgSize()) > 0) {
+		const char *pBegin = m_buf.begin() + offset;
+
+		if (acceptFrame(frameSize)) {
+			m_currentReceiveTime = m_lastReceiveTime;
+			decodeMsg(pBegin, m_buf.begin() + frameSize);
 		}
-	
-		std::vector<char> msgData(msgSize);
 
-		if (!bufferedRead(msgData.data(), msgSize))
+		consumeFrame(frameSize);
+		++count;
+	}
+
+	return frameSize < 0 ? -1 : count;
+}
+
+bool EReader::pollOnce(int timeoutMs) {
+	m_pClientSocket->onSend();
+
+	int count = decodeBuffered();
+
+	if (count == 0 && m_pClientSocket->isSocketOK()) {
+		waitAndReceive(timeoutMs);
+		count = decodeBuffered();
+	}
+
+	if (count < 0 || !m_pClientSocket->isSocketOK()) {
+		m_pClientSocket->handleSocketError();
+		return false;
+	}
+
+	return true;
+}
+
+void EReader::run() {
+	while (m_isAlive && pollOnce(SOCKET_WAIT_TIMEOUT_MS))
+		;
+}
+
+void EReader::stop() {
+	m_isAlive = false;
+}
+
+EMessage * EReader::readSingleMsg() {
+	for (;;) {
+		int frameSize = nextMsgSize();
+
+		if (frameSize < 0)
 			return 0;
 
-		if (m_buf.size() < IN_BUF_SIZE_DEFAULT && m_buf.capacity() > IN_BUF_SIZE_DEFAULT)
-		{
-			m_buf.resize(m_nMaxBufSize = IN_BUF_SIZE_DEFAULT);
-			m_buf.shrink_to_fit();
+		if (frameSize > 0) {
+			if (acceptFrame(frameSize))
+				return extractMsg(frameSize);
+
+			consumeFrame(frameSize);
+			continue;
 		}
 
-		EMessage * msg = new EMessage(msgData);
+		if (!processNonBlockingSelect() && !m_pClientSocket->isSocketOK())
+			return 0;
+	}
+}
+
+EMessage * EReader::popMsg() {
+	if (m_pMsgRing) {
+		EMessage *msg;
+
+		if (!m_pMsgRing->tryPop(msg))
+			return 0;
 
+		ringDrained();
 		return msg;
 	}
-}
 
-std::shared_ptr<EMessage> EReader::getMsg(void) {
 	EMutexGuard lock(m_csMsgQueue);
 
 	if (m_msgQueue.size() == 0) {
-		return std::shared_ptr<EMessage>();
+		return 0;
 	}
 
-	std::shared_ptr<EMessage> msg = m_msgQueue.front();
+	EMessage *msg = m_msgQueue.front();
 	m_msgQueue.pop_front();
 
 	return msg;
 }
 
+void EReader::ringDrained() {
+#if defined(IBAPI_EPOLL)
+	// an event-loop reader paused on the full ring resumes at once instead of at its next poll
+	if (m_ringFull && m_pEventLoop)
+		m_pEventLoop->wake();
+#endif
+}
+
+std::shared_ptr<EMessage> EReader::getMsg(void) {
+	return std::shared_ptr<EMessage>(popMsg());
+}
+
 
 void EReader::processMsgs(void) {
 	m_pClientSocket->onSend();
 
-	std::shared_ptr<EMessage> msg = getMsg();
+	if (m_pMsgRing) {
+		m_pMsgRing->drain([this](EMessage *msg) {
+			const char *pBegin = msg->begin();
+
+			m_currentReceiveTime = msg->receiveTime();
+			decodeMsg(pBegin, msg->end());
+			delete msg;
+		});
 
-	if (!msg.get())
+		ringDrained();
 		return;
+	}
+
+	// raw pointers here, a shared_ptr control block per message is an allocation of its own
+	EMessage *msg = popMsg();
+
+	while (msg) {
+		const char *pBegin = msg->begin();
+
+		m_currentReceiveTime = msg->receiveTime();
 
-	const char *pBegin = msg->begin();
+		int parsed = decodeMsg(pBegin, msg->end());
 
-	while (processMsgsDecoder_.parseAndProcessMsg(pBegin, msg->end()) > 0) {
-		msg = getMsg();
+		delete msg;
 
-		if (!msg.get())
+		if (parsed <= 0)
 			break;
 
-		pBegin = msg->begin();
-	} 
+		msg = popMsg();
+	}
+}
+
+int EReader::decodeMsg(const char*& beginPtr, const char* endPtr) {
+	if (m_pMsgDecoder)
+		return m_pMsgDecoder->parseAndProcessMsg(beginPtr, endPtr, processMsgsDecoder_);
+
+	return processMsgsDecoder_.parseAndProcessMsg(beginPtr, endPtr);
+}
+
+void EReader::wrapperView(EWrapperView *view) {
+	processMsgsDecoder_.wrapperView(view);
+}
+
+void EReader::historicalTickSink(EHistoricalTickSink *sink) {
+	processMsgsDecoder_.historicalTickSink(sink);
+}
+
+void EReader::orderView(EOrderView *view) {
+	processMsgsDecoder_.orderView(view);
+}
+
+void EReader::decoder(EMessageDecoder *decoder) {
+	m_pMsgDecoder = decoder;
+}
+
+EMessageFilter &EReader::msgFilter() {
+	return m_msgFilter;
+}
+
+const EReceiveTime &EReader::msgReceiveTime() const {
+	return m_currentReceiveTime;
 }
@@ -11,19 +11,32 @@
 #include "EDecoder.h"
 #include "EMutex.h"
 #include "EReaderOSSignal.h"
+#include "ERecvBuffer.h"
+#include "ESpscQueue.h"
+#include "EMessage.h"
+#include "EMessageFilter.h"
 
 class EClientSocket;
 struct EReaderSignal;
 class EMessage;
+class EReaderEventLoop;
+class EIoUring;
+class EWrapperView;
+class EHistoricalTickSink;
+class EOrderView;
+class EMessageDecoder;
 
 class TWSAPIDLLEXP EReader
 {  
     EClientSocket *m_pClientSocket;
     EReaderSignal *m_pEReaderSignal;
     EDecoder processMsgsDecoder_;
-    std::deque<std::shared_ptr<EMessage>> m_msgQueue;
+    EMessageDecoder *m_pMsgDecoder;
+    EMessageFilter m_msgFilter;
+    std::deque<EMessage*> m_msgQueue;
     EMutex m_csMsgQueue;
-    std::vector<char> m_buf;
+    ESpscQueue<EMessage*> *m_pMsgRing;
+    ERecvBuffer m_buf;
     std::atomic<bool> m_isAlive;
 #if defined(IB_POSIX)
     pthread_t m_hReadThread;
@@ -31,18 +44,64 @@ class TWSAPIDLLEXP EReader
     HANDLE m_hReadThread;
 #endif
 	unsigned int m_nMaxBufSize;
+	unsigned int m_smallFrames;          // frames consumed since the last one larger than the default window
+	size_t m_legacyFramed;               // bytes a failed legacy framing attempt walked, 0 when none is pending
+	size_t m_legacyScanned;              // how far past that the data is known to hold no new field end
+	bool m_legacyRetryDue;               // a short wait brought nothing new, retry the framing held back
+    EReceiveTime m_lastReceiveTime;      // of the most recent read, stamped onto the frames it completes
+    EReceiveTime m_currentReceiveTime;   // of the message being decoded
+    EReaderEventLoop *m_pEventLoop;
+#if defined(IBAPI_EPOLL)
+    int m_epollFd;       // private epoll set, used when the reader runs its own thread
+    int m_epollSockFd;   // socket currently registered for edge-triggered events
+    bool m_epollOut;     // EPOLLOUT armed, only while the transport has unsent data
+    bool m_canRead;      // read edge seen but socket not drained yet
+    std::atomic<bool> m_ringFull;  // event loop only: ring full, socket reads paused until the consumer drains it
+    bool m_epollIn;      // EPOLLIN armed, dropped while m_ringFull
+#endif
+#if defined(IBAPI_IO_URING)
+    EIoUring *m_pUring;  // receive engine of the reader's own thread or inline loop
+    bool m_uringFailed;  // io_uring unavailable here, stay on the socket path
+#endif
 
 	void onReceive();
 	void onSend();
-	bool bufferedRead(char *buf, unsigned int size);
+	int nextMsgSize();
+	bool legacyFramingDue();
+	bool acceptFrame(int frameSize);
+	EMessage * extractMsg(int frameSize);
+	void ringDrained();
+	void consumeFrame(int frameSize);
+	void pushMsg(EMessage *msg);
+	bool waitAndReceive(int timeoutMs);
+	bool pollSocket(int timeoutMs);
+	int decodeBuffered();
+	int decodeMsg(const char*& beginPtr, const char* endPtr);
+#if defined(IBAPI_EPOLL)
+	bool processNonBlockingEpoll(int timeoutMs);
+	bool epollCtl(int epollFd, int op, bool out);
+	bool updateEpollInterest(int epollFd);
+	bool processEvents(unsigned int events);
+	bool ringFull();
+
+	friend class EReaderEventLoop;
+#endif
+#if defined(IBAPI_IO_URING)
+	bool processUring(int timeoutMs, bool &handled);
+#endif
 
 public:
-    EReader(EClientSocket *clientSocket, EReaderSignal *signal);
+    // queueCapacity > 0 hands messages over through a lock-free single-producer/single-consumer
+    // ring of that many slots instead of the locked deque. processMsgs() and getMsg() must
+    // then always be called from the same thread. A full ring makes a dedicated reader thread
+    // wait; a reader on an EReaderEventLoop stops reading its socket until the ring drains.
+    EReader(EClientSocket *clientSocket, EReaderSignal *signal, unsigned int queueCapacity = 0);
     ~EReader(void);
 
 protected:
 	bool processNonBlockingSelect();
     std::shared_ptr<EMessage> getMsg(void);
+    EMessage * popMsg();
     void readToQueue();
 #if defined(IB_POSIX)
     static void * readToQueueThread(void * lpParam);
@@ -58,6 +117,34 @@ public:
     void processMsgs(void);
 	bool putMessageToQueue();
 	void start();
+	void start(EReaderEventLoop *eventLoop);
+
+	// inline mode, used instead of start() and processMsgs(): reads, frames and decodes on
+	// the calling thread, so EWrapper callbacks fire straight from the socket read.
+	// pollOnce() waits at most timeoutMs for data and returns false once the connection is gone.
+	bool pollOnce(int timeoutMs = 0);
+	void run();
+	void stop();
+
+	// route the messages EWrapperView covers to view, decoded without copying their strings
+	void wrapperView(EWrapperView *view);
+
+	// deliver historical ticks to sink in columnar chunks instead of to the EWrapper
+	void historicalTickSink(EHistoricalTickSink *sink);
+
+	// deliver open and completed orders to view as summaries, decoded in full only on demand
+	void orderView(EOrderView *view);
+
+	// decode through decoder first (e.g. an EStaticDecoder), which passes what it does not
+	// handle on to the reader's own EDecoder; 0 goes back to decoding everything there
+	void decoder(EMessageDecoder *decoder);
+
+	// message ids to drop unread, checked by the reader before a frame is queued or decoded
+	EMessageFilter &msgFilter();
+
+	// when the message whose EWrapper callbacks are running arrived; only meaningful on the
+	// thread calling processMsgs() or pollOnce(), from inside those callbacks
+	const EReceiveTime &msgReceiveTime() const;
 };
 
 #endif
\ No newline at end of file
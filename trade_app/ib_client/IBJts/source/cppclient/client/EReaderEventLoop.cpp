@@ -0,0 +1,237 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "EReaderEventLoop.h"
+#include "EReader.h"
+#include "EClientSocket.h"
+#include "EPosixClientSocketPlatform.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#if defined(IBAPI_EPOLL)
+#include <sys/eventfd.h>
+#endif
+
+#define LOOP_WAIT_TIMEOUT_MS 100
+#define LOOP_MAX_EVENTS 64
+#define LOOP_RING_FULL_WAIT_MS 1
+
+#if defined(IBAPI_EPOLL)
+// the loop whose thread this is, 0 on any other thread
+static thread_local EReaderEventLoop *t_pRunningLoop = 0;
+#endif
+
+EReaderEventLoop::EReaderEventLoop()
+{
+    m_isAlive = true;
+#if defined(IBAPI_EPOLL)
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_hLoopThread = pthread_self();
+
+    if (m_epollFd >= 0 && m_wakeFd >= 0) {
+        struct epoll_event ev;
+
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = 0;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+    }
+    m_started = false;
+#endif
+}
+
+EReaderEventLoop::~EReaderEventLoop(void)
+{
+    stop();
+#if defined(IBAPI_EPOLL)
+    if (m_epollFd >= 0)
+        close(m_epollFd);
+    if (m_wakeFd >= 0)
+        close(m_wakeFd);
+#endif
+}
+
+bool EReaderEventLoop::add(EReader *reader)
+{
+#if defined(IBAPI_EPOLL)
+    if (m_epollFd < 0 || !reader->m_pClientSocket->isSocketOK())
+        return false;
+
+    EMutexGuard lock(m_csReaders);
+
+    if (!reader->updateEpollInterest(m_epollFd))
+        return false;
+
+    reader->m_pEventLoop = this;
+    m_readers.insert(reader);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void EReaderEventLoop::remove(EReader *reader)
+{
+#if defined(IBAPI_EPOLL)
+    // from a callback of the loop, which is not working on any other reader meanwhile
+    if (t_pRunningLoop == this) {
+        detach(reader);
+        return;
+    }
+
+    // the loop may be in the middle of this reader, which the caller may delete next
+    EMutexGuard dispatch(m_csDispatch);
+
+    detach(reader);
+#endif
+}
+
+void EReaderEventLoop::start()
+{
+#if defined(IBAPI_EPOLL)
+    if (m_started || m_epollFd < 0)
+        return;
+
+    m_started = pthread_create(&m_hLoopThread, NULL, runThread, this) == 0;
+#endif
+}
+
+void EReaderEventLoop::stop()
+{
+    m_isAlive = false;
+#if defined(IBAPI_EPOLL)
+    if (m_started) {
+        pthread_join(m_hLoopThread, NULL);
+        m_started = false;
+    }
+#endif
+}
+
+void EReaderEventLoop::wake()
+{
+#if defined(IBAPI_EPOLL)
+    uint64_t one = 1;
+
+    if (m_wakeFd >= 0 && write(m_wakeFd, &one, sizeof(one)) < 0)
+        errno = 0;
+#endif
+}
+
+#if defined(IBAPI_EPOLL)
+bool EReaderEventLoop::attached(EReader *reader)
+{
+    EMutexGuard lock(m_csReaders);
+
+    return m_readers.find(reader) != m_readers.end();
+}
+
+void EReaderEventLoop::detach(EReader *reader)
+{
+    EMutexGuard lock(m_csReaders);
+
+    if (m_readers.find(reader) == m_readers.end())
+        return;
+
+    // a closed descriptor has already left the set and its number may belong to someone else now
+    if (reader->m_pClientSocket->fd() == reader->m_epollSockFd)
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, reader->m_epollSockFd, 0);
+
+    m_readers.erase(reader);
+}
+
+void * EReaderEventLoop::runThread(void * lpParam)
+{
+    EReaderEventLoop *pThis = reinterpret_cast<EReaderEventLoop *>(lpParam);
+
+    pThis->run();
+    return 0;
+}
+
+void EReaderEventLoop::run()
+{
+    struct epoll_event events[LOOP_MAX_EVENTS];
+    std::vector<EReader*> readers;
+    int timeout = LOOP_WAIT_TIMEOUT_MS;
+
+    t_pRunningLoop = this;
+
+    while (m_isAlive) {
+        int ret = epoll_wait(m_epollFd, events, LOOP_MAX_EVENTS, timeout);
+
+        if (ret < 0) {
+            if (errno != EINTR)
+                break;
+            ret = 0;
+        }
+
+        // m_csReaders is only taken to look readers up: the EWrapper callbacks a reader makes
+        // on a socket error may add() and remove() readers
+        EMutexGuard dispatch(m_csDispatch);
+
+        for (int i = 0; i < ret; ++i) {
+            EReader *reader = static_cast<EReader *>(events[i].data.ptr);
+
+            // wake(): the pass over the readers below does the rest
+            if (!reader) {
+                uint64_t count;
+
+                if (read(m_wakeFd, &count, sizeof(count)) < 0)
+                    errno = 0;
+                continue;
+            }
+
+            // removed, or finished earlier in this batch
+            if (!attached(reader))
+                continue;
+
+            if (!reader->processEvents(events[i].events))
+                detach(reader);
+        }
+
+        // no further edge will come for sockets left undrained, so service them here
+        // and keep polling without blocking until they are empty
+        timeout = LOOP_WAIT_TIMEOUT_MS;
+
+        {
+            EMutexGuard lock(m_csReaders);
+
+            readers.assign(m_readers.begin(), m_readers.end());
+        }
+
+        for (size_t i = 0; i < readers.size(); ++i) {
+            EReader *reader = readers[i];
+            bool alive = true;
+
+            // removed by a callback earlier in this pass
+            if (!attached(reader))
+                continue;
+
+            if (reader->m_canRead || reader->m_ringFull)
+                alive = reader->processEvents(0);
+
+            // a reader paused on its ring may outlive its socket until the ring is drained
+            if (alive && !(reader->m_ringFull && !reader->m_pClientSocket->isSocketOK())
+                && !reader->updateEpollInterest(m_epollFd)) {
+                reader->m_pClientSocket->eDisconnect();
+                alive = reader->processEvents(0);
+            }
+
+            if (!alive)
+                detach(reader);
+            else if (reader->m_ringFull) {
+                // paused on a full ring: look again shortly for the consumer to have drained it
+                if (timeout > LOOP_RING_FULL_WAIT_MS)
+                    timeout = LOOP_RING_FULL_WAIT_MS;
+            }
+            else if (reader->m_canRead)
+                timeout = 0;
+        }
+    }
+
+    t_pRunningLoop = 0;
+}
+#endif
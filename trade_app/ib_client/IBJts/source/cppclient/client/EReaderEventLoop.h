@@ -0,0 +1,53 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EREADEREVENTLOOP_H
+#define TWS_API_CLIENT_EREADEREVENTLOOP_H
+
+#include <atomic>
+#include <set>
+#include "platformspecific.h"
+#include "EMutex.h"
+
+class EReader;
+
+// One reader thread serving several EClientSocket connections. Each EReader attached
+// with EReader::start(EReaderEventLoop*) has its socket registered edge-triggered on a
+// shared epoll set; complete frames are queued to that reader's own message queue and
+// signal, exactly as its dedicated thread would have done.
+// Without epoll support add() fails and EReader::start() falls back to its own thread.
+class TWSAPIDLLEXP EReaderEventLoop
+{
+    std::set<EReader*> m_readers;
+    EMutex m_csReaders;
+    std::atomic<bool> m_isAlive;
+#if defined(IBAPI_EPOLL)
+    EMutex m_csDispatch;  // held by the loop while it works on its readers, see remove()
+    int m_epollFd;
+    int m_wakeFd;        // eventfd in the epoll set, see wake()
+    pthread_t m_hLoopThread;
+    bool m_started;
+
+    bool attached(EReader *reader);
+    void detach(EReader *reader);
+    void run();
+    static void * runThread(void * lpParam);
+#endif
+
+public:
+    EReaderEventLoop();
+    ~EReaderEventLoop(void);
+
+    // both may be called from the EWrapper callbacks the loop makes, e.g. error() or
+    // connectionClosed(). Once remove() returns, the loop no longer touches the reader.
+    bool add(EReader *reader);
+    void remove(EReader *reader);
+    void start();
+    void stop();
+
+    // makes the loop look at its readers again now, e.g. once a full message ring was drained
+    void wake();
+};
+
+#endif
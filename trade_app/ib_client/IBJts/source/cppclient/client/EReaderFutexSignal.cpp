@@ -0,0 +1,121 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "EReaderFutexSignal.h"
+
+#include <chrono>
+
+#if defined(IBAPI_FUTEX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define SPIN_PAUSE() _mm_pause()
+#elif defined(__aarch64__)
+#define SPIN_PAUSE() __asm__ __volatile__("yield")
+#else
+#define SPIN_PAUSE()
+#endif
+
+#define SPIN_PAUSES_PER_CLOCK_CHECK 64
+
+
+EReaderFutexSignal::EReaderFutexSignal(unsigned long waitTimeout, unsigned long spinMicros)
+	: m_signalled(0)
+	, m_parked(0)
+	, m_waitTimeout(waitTimeout)
+	, m_spinMicros(spinMicros)
+#if !defined(IBAPI_FUTEX)
+	, m_osSignal(waitTimeout)
+#endif
+{
+}
+
+
+EReaderFutexSignal::~EReaderFutexSignal(void)
+{
+}
+
+
+void EReaderFutexSignal::issueSignal() {
+	// only the 0 -> 1 transition may need a wakeup, later signals coalesce into it.
+	// Both sides use seq_cst so either the consumer sees the flag or we see it parked.
+	if (m_signalled.exchange(1) != 0)
+		return;
+
+	if (m_parked.load() == 0)
+		return;
+
+#if defined(IBAPI_FUTEX)
+	syscall(SYS_futex, reinterpret_cast<int *>(&m_signalled), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+	m_osSignal.issueSignal();
+#endif
+}
+
+void EReaderFutexSignal::waitForSignal() {
+	if (consume())
+		return;
+
+	if (m_spinMicros > 0) {
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(m_spinMicros);
+
+		do {
+			for (int i = 0; i < SPIN_PAUSES_PER_CLOCK_CHECK && m_signalled.load(std::memory_order_relaxed) == 0; ++i)
+				SPIN_PAUSE();
+
+			if (consume())
+				return;
+		} while (std::chrono::steady_clock::now() < deadline);
+	}
+
+	park();
+}
+
+bool EReaderFutexSignal::consume() {
+	// plain load first so a spinning consumer does not keep stealing the cache line
+	return m_signalled.load(std::memory_order_relaxed) != 0 && m_signalled.exchange(0) != 0;
+}
+
+void EReaderFutexSignal::park() {
+	m_parked.store(1);
+
+#if defined(IBAPI_FUTEX)
+	static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word must be a plain int");
+
+	std::chrono::steady_clock::time_point deadline;
+
+	if (m_waitTimeout != INFINITE)
+		deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_waitTimeout);
+
+	while (m_signalled.exchange(0) == 0) {
+		struct timespec ts;
+		struct timespec *pts = NULL;
+
+		if (m_waitTimeout != INFINITE) {
+			std::chrono::nanoseconds left = deadline - std::chrono::steady_clock::now();
+
+			if (left.count() <= 0)
+				break;
+
+			ts.tv_sec = (time_t)(left.count() / (1000 * 1000 * 1000));
+			ts.tv_nsec = (long)(left.count() % (1000 * 1000 * 1000));
+			pts = &ts;
+		}
+
+		// returns at once if a signal landed after the exchange above
+		syscall(SYS_futex, reinterpret_cast<int *>(&m_signalled), FUTEX_WAIT_PRIVATE, 0, pts, NULL, 0);
+	}
+#else
+	if (m_signalled.exchange(0) == 0) {
+		m_osSignal.waitForSignal();
+		m_signalled.exchange(0);
+	}
+#endif
+
+	m_parked.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,39 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EREADERFUTEXSIGNAL_H
+#define TWS_API_CLIENT_EREADERFUTEXSIGNAL_H
+
+#include <atomic>
+#include "EReaderSignal.h"
+#include "EReaderOSSignal.h"
+#include "platformspecific.h"
+
+// Coalescing signal: issueSignal() only sets a flag unless the consumer is parked, so a
+// burst of messages costs one wakeup at most and no lock at all while the consumer is busy.
+// waitForSignal() optionally busy-spins for spinMicros before parking, which trades a core
+// for wakeup latency. Parks on a futex on Linux, on an EReaderOSSignal elsewhere.
+class TWSAPIDLLEXP EReaderFutexSignal :
+	public EReaderSignal
+{
+    std::atomic<int> m_signalled;   // futex word: 1 once a signal is pending
+    std::atomic<int> m_parked;      // consumer is (about to be) blocked
+    unsigned long m_waitTimeout;    // in milliseconds
+    unsigned long m_spinMicros;
+#if !defined(IBAPI_FUTEX)
+    EReaderOSSignal m_osSignal;
+#endif
+
+    bool consume();
+    void park();
+
+public:
+	EReaderFutexSignal(unsigned long waitTimeout = INFINITE, unsigned long spinMicros = 0);
+	virtual ~EReaderFutexSignal(void);
+
+	virtual void issueSignal();
+	virtual void waitForSignal();
+};
+
+#endif
@@ -0,0 +1,66 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#include "StdAfx.h"
+#include "ERecvBuffer.h"
+#include "EMessage.h"
+
+#include <string.h>
+
+ERecvBuffer::ERecvBuffer(size_t slabSize)
+	: m_slab(EMessageSlab::create(slabSize))
+	, m_data(m_slab->data())
+	, m_capacity(m_slab->capacity())
+	, m_slabSize(slabSize)
+	, m_head(0)
+	, m_tail(0)
+{
+}
+
+ERecvBuffer::~ERecvBuffer() {
+	m_slab->release();
+}
+
+void ERecvBuffer::relocate(size_t capacity) {
+	size_t used = size();
+	EMessageSlab *slab = EMessageSlab::create(capacity);
+
+	memcpy(slab->data(), begin(), used);
+	m_slab->release();
+
+	m_slab = slab;
+	m_data = slab->data();
+	m_capacity = slab->capacity();
+	m_head = 0;
+	m_tail = used;
+}
+
+char * ERecvBuffer::prepareWrite(size_t window, size_t &space) {
+	size_t used = size();
+
+	space = used < window ? window - used : 0;
+
+	if (space == 0 || m_tail + space <= m_capacity)
+		return m_data + m_tail;
+
+	if (window > m_capacity || m_slab->isShared()) {
+		// queued messages still point into this slab, leave it to them
+		relocate(window > m_slabSize ? window : m_slabSize);
+	}
+	else {
+		memmove(m_data, m_data + m_head, used);
+		m_head = 0;
+		m_tail = used;
+	}
+
+	return m_data + m_tail;
+}
+
+void ERecvBuffer::consume(size_t n) {
+	m_head += n;
+}
+
+void ERecvBuffer::shrink() {
+	if (m_capacity > m_slabSize && size() <= m_slabSize)
+		relocate(m_slabSize);
+}
@@ -0,0 +1,53 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_ERECVBUFFER_H
+#define TWS_API_CLIENT_ERECVBUFFER_H
+
+#include <stddef.h>
+#include "platformspecific.h"
+
+class EMessageSlab;
+
+// Receive buffer for EReader. Unread bytes live in [head, tail) of one refcounted slab,
+// so a frame is handed out by offset and consumed by moving head forward, and messages
+// can keep pointing into the slab instead of copying their frame.
+// Bytes are only moved when the free space past tail runs out, and then only the unread
+// remainder (normally one partial frame) goes back to the front, or into a fresh slab
+// while queued messages still reference the current one.
+class TWSAPIDLLEXP ERecvBuffer
+{
+    EMessageSlab *m_slab;
+    char *m_data;
+    size_t m_capacity;
+    size_t m_slabSize;
+    size_t m_head;
+    size_t m_tail;
+
+    void relocate(size_t capacity);
+
+    // disable copy
+    ERecvBuffer(const ERecvBuffer&);
+    ERecvBuffer& operator=(const ERecvBuffer&);
+
+public:
+    explicit ERecvBuffer(size_t slabSize);
+    ~ERecvBuffer();
+
+    const char * begin() const { return m_data + m_head; }
+    const char * end() const { return m_data + m_tail; }
+    size_t size() const { return m_tail - m_head; }
+    bool empty() const { return m_head == m_tail; }
+    size_t capacity() const { return m_capacity; }
+    EMessageSlab * slab() const { return m_slab; }
+
+    // make room for up to `window` unread bytes and return where the next read goes
+    char * prepareWrite(size_t window, size_t &space);
+    void commit(size_t n) { m_tail += n; }
+    void consume(size_t n);
+    // drop back to the default slab size after an oversized frame has gone
+    void shrink();
+};
+
+#endif
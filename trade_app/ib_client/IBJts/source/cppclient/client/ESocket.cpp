@@ -6,13 +6,18 @@
 #include "ESocket.h"
 
 #include <assert.h>
+#include <string.h>
 
 #if defined(IB_POSIX)
 #include <sys/socket.h>
+#include <sys/uio.h>
 #endif
 
 
-ESocket::ESocket() {
+ESocket::ESocket()
+	: m_outHead(0)
+	, m_batchDepth(0)
+{
 }
 
 void ESocket::fd(int fd) {
@@ -31,16 +36,34 @@ int ESocket::bufferedSend(const char* buf, size_t sz)
 	if( sz <= 0)
 		return 0;
 
-	if( !m_outBuffer.empty()) {
-		m_outBuffer.insert( m_outBuffer.end(), buf, buf + sz);
-		return sendBufferedData();
+	if( m_batchDepth > 0) {
+		appendToBuffer( buf, sz);
+		return (int)sz;
+	}
+
+	size_t pending = m_outBuffer.size() - m_outHead;
+
+	if( pending > 0) {
+		// backlog and new message go out together, the backlog first
+		int nResult = send( &m_outBuffer[m_outHead], pending, buf, sz);
+		size_t sent = (std::max)( nResult, 0);
+
+		if( sent < pending) {
+			CleanupBuffer( (int)sent);
+			appendToBuffer( buf, sz);
+		}
+		else {
+			CleanupBuffer( (int)pending);
+			appendToBuffer( buf + (sent - pending), sz - (sent - pending));
+		}
+		return nResult;
 	}
 
 	int nResult = send(buf, sz);
 
 	if( nResult < (int)sz) {
 		int sent = (std::max)( nResult, 0);
-		m_outBuffer.insert( m_outBuffer.end(), buf + sent, buf + sz);
+		appendToBuffer( buf + sent, sz - sent);
 	}
 
 	return nResult;
@@ -48,17 +71,45 @@ int ESocket::bufferedSend(const char* buf, size_t sz)
 
 int ESocket::sendBufferedData()
 {
-	if( m_outBuffer.empty())
+	if( m_outHead == m_outBuffer.size())
 		return 0;
 
-	int nResult = send( &m_outBuffer[0], m_outBuffer.size());
+	int nResult = send( &m_outBuffer[m_outHead], m_outBuffer.size() - m_outHead);
 	if( nResult <= 0) {
 		return nResult;
 	}
-	CleanupBuffer( m_outBuffer, nResult);
+	CleanupBuffer( nResult);
 	return nResult;
 }
 
+std::vector<char> &ESocket::encodeBuffer()
+{
+	CompactBuffer();
+
+	return m_outBuffer;
+}
+
+int ESocket::sendEncoded()
+{
+	if( m_batchDepth > 0)
+		return (int)(m_outBuffer.size() - m_outHead);
+
+	return sendBufferedData();
+}
+
+void ESocket::beginBatch()
+{
+	++m_batchDepth;
+}
+
+int ESocket::endBatch()
+{
+	if( m_batchDepth > 0 && --m_batchDepth > 0)
+		return 0;
+
+	return sendBufferedData();
+}
+
 int ESocket::send(const char* buf, size_t sz)
 {
 	if( sz <= 0)
@@ -75,32 +126,84 @@ int ESocket::send(const char* buf, size_t sz)
 	return nResult;
 }
 
+int ESocket::send(const char* buf1, size_t sz1, const char* buf2, size_t sz2)
+{
+#if defined(IB_POSIX)
+	struct iovec iov[2];
+	struct msghdr msg;
+
+	iov[0].iov_base = const_cast<char*>(buf1);
+	iov[0].iov_len = sz1;
+	iov[1].iov_base = const_cast<char*>(buf2);
+	iov[1].iov_len = sz2;
+
+	memset( &msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+
+	int nResult = ::sendmsg( m_fd, &msg, 0);
+#elif defined(IB_WIN32)
+	WSABUF bufs[2];
+	DWORD sent = 0;
+
+	bufs[0].buf = const_cast<char*>(buf1);
+	bufs[0].len = (ULONG)sz1;
+	bufs[1].buf = const_cast<char*>(buf2);
+	bufs[1].len = (ULONG)sz2;
+
+	int nResult = WSASend( m_fd, bufs, 2, &sent, 0, NULL, NULL) == SOCKET_ERROR ? -1 : (int)sent;
+#else
+#   error "Not implemented on this platform"
+#endif
+
+	if( nResult == -1) {
+		return -1;
+	}
+	if( nResult <= 0) {
+		return 0;
+	}
+	return nResult;
+}
+
 static const size_t BufferSizeHighMark = 1 * 1024 * 1024; // 1Mb
 
-void ESocket::CleanupBuffer(std::vector<char>& buffer, int processed)
+void ESocket::CleanupBuffer(int processed)
 {
-	assert( buffer.empty() || processed <= (int)buffer.size());
-
-	if( buffer.empty())
-		return;
+	assert( processed <= (int)(m_outBuffer.size() - m_outHead));
 
 	if( processed <= 0)
 		return;
 
-	if( (size_t)processed == buffer.size()) {
-		if( buffer.capacity() >= BufferSizeHighMark) {
-			std::vector<char>().swap(buffer);
+	m_outHead += processed;
+
+	if( m_outHead == m_outBuffer.size()) {
+		if( m_outBuffer.capacity() >= BufferSizeHighMark) {
+			std::vector<char>().swap(m_outBuffer);
 		}
 		else {
-			buffer.clear();
+			m_outBuffer.clear();
 		}
+		m_outHead = 0;
 	}
-	else {
-		buffer.erase( buffer.begin(), buffer.begin() + processed);
+}
+
+void ESocket::CompactBuffer()
+{
+	// compact only once the sent part outweighs what is left, which keeps it amortized O(1)
+	if( m_outHead > 0 && m_outHead >= m_outBuffer.size() - m_outHead) {
+		m_outBuffer.erase( m_outBuffer.begin(), m_outBuffer.begin() + m_outHead);
+		m_outHead = 0;
 	}
 }
 
+void ESocket::appendToBuffer(const char* buf, size_t sz)
+{
+	CompactBuffer();
+
+	m_outBuffer.insert( m_outBuffer.end(), buf, buf + sz);
+}
+
 bool ESocket::isOutBufferEmpty() const
 {
-	return m_outBuffer.empty();
+	return m_outHead == m_outBuffer.size();
 }
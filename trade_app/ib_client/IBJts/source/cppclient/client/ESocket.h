@@ -13,10 +13,15 @@ class ESocket :
 {
     int m_fd;
 	std::vector<char> m_outBuffer;
+	size_t m_outHead;   // first unsent byte of m_outBuffer, consumed by moving it forward
+	int m_batchDepth;
 
     int bufferedSend(const char* buf, size_t sz);
     int send(const char* buf, size_t sz);
-    void CleanupBuffer(std::vector<char>& buffer, int processed);
+    int send(const char* buf1, size_t sz1, const char* buf2, size_t sz2);
+    void CleanupBuffer(int processed);
+    void CompactBuffer();
+    void appendToBuffer(const char* buf, size_t sz);
 
 public:
     ESocket();
@@ -26,6 +31,16 @@ public:
     bool isOutBufferEmpty() const;
     int sendBufferedData();
     void fd(int fd);
+
+    // messages are encoded in place at the end of the out buffer (EMessageEncoder);
+    // sendEncoded() then writes out everything pending, unless a batch is open
+    std::vector<char> &encodeBuffer();
+    int sendEncoded();
+
+    // messages sent between beginBatch() and the matching endBatch() are only buffered,
+    // endBatch() then writes them all with a single syscall
+    void beginBatch();
+    int endBatch();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_ESPSCQUEUE_H
+#define TWS_API_CLIENT_ESPSCQUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include "platformspecific.h"
+
+#define IBAPI_CACHE_LINE_SIZE 64
+
+// Bounded lock-free ring for exactly one producer thread and one consumer thread.
+// Each side owns its index on a separate cache line and keeps a cached copy of the
+// other side's index, so the shared lines are only touched when the cached view says
+// the ring looks full (producer) or empty (consumer).
+template<class T>
+class ESpscQueue
+{
+    char m_pad0[IBAPI_CACHE_LINE_SIZE];
+    std::vector<T> m_slots;
+    size_t m_mask;
+
+    char m_pad1[IBAPI_CACHE_LINE_SIZE];
+    std::atomic<size_t> m_head;   // next slot to pop, written by the consumer
+    size_t m_tailCache;           // consumer's last view of m_tail
+
+    char m_pad2[IBAPI_CACHE_LINE_SIZE];
+    std::atomic<size_t> m_tail;   // next slot to fill, written by the producer
+    size_t m_headCache;           // producer's last view of m_head
+
+    char m_pad3[IBAPI_CACHE_LINE_SIZE];
+
+    static size_t roundUp(size_t n) {
+        size_t size = 2;
+
+        while (size < n)
+            size <<= 1;
+
+        return size;
+    }
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    ESpscQueue(const ESpscQueue&);
+    ESpscQueue& operator=(const ESpscQueue&);
+
+public:
+    // capacity is rounded up to a power of two
+    explicit ESpscQueue(size_t capacity)
+        : m_slots(roundUp(capacity))
+        , m_mask(m_slots.size() - 1)
+        , m_head(0)
+        , m_tailCache(0)
+        , m_tail(0)
+        , m_headCache(0)
+    {
+    }
+
+    size_t capacity() const { return m_slots.size(); }
+
+    // producer side
+    bool tryPush(const T &value) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_headCache > m_mask) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+
+            if (tail - m_headCache > m_mask)
+                return false;
+        }
+
+        m_slots[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // producer side: no slot free, even after a fresh look at how far the consumer got
+    bool full() {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_headCache > m_mask) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            return tail - m_headCache > m_mask;
+        }
+
+        return false;
+    }
+
+    // consumer side
+    bool tryPop(T &value) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tailCache) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+
+            if (head == m_tailCache)
+                return false;
+        }
+
+        value = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: hands every message published so far to f with a single acquire of
+    // the producer index and a single release of the consumer index, returns the count.
+    // The slots are only given back to the producer once f has seen all of them.
+    template<class F>
+    size_t drain(F f) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+
+        m_tailCache = tail;
+
+        for (size_t i = head; i != tail; ++i)
+            f(m_slots[i & m_mask]);
+
+        if (tail != head)
+            m_head.store(tail, std::memory_order_release);
+
+        return tail - head;
+    }
+};
+
+#endif
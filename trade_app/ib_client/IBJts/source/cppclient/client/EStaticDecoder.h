@@ -0,0 +1,320 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_ESTATICDECODER_H
+#define TWS_API_CLIENT_ESTATICDECODER_H
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "platformspecific.h"
+#include "CommonDefs.h"
+#include "TickAttrib.h"
+#include "TickAttribBidAsk.h"
+#include "TickAttribLast.h"
+#include "EDecoder.h"
+#include "EMarketDataParser.h"
+#include "EVersionTier.h"
+#include "EWrapperView.h"
+
+// What EReader::decoder() puts in front of the reader's own EDecoder. Same contract as
+// EDecoder::parseAndProcessMsg(); messages it does not take itself go to fallback.
+class TWSAPIDLLEXP EMessageDecoder
+{
+public:
+    virtual ~EMessageDecoder() {}
+
+    virtual int parseAndProcessMsg(const char*& beginPtr, const char* endPtr, EDecoder &fallback) = 0;
+};
+
+// Calls into the handler of an EStaticDecoder. Each callback has an overload that is only
+// viable when the handler declares a matching method, returning std::true_type, and a
+// catch-all returning std::false_type; the return type tells the decoder whether the
+// handler wants the message at all. Methods carrying strings are looked up with
+// EStringView first and const std::string& second.
+namespace EStaticDispatch {
+
+    struct Missing {};
+    struct Copying : Missing {};
+    struct Provided : Copying {};
+
+    template<class H> auto tickPrice(H &h, Provided, TickerId tickerId, TickType field, double price, const TickAttrib &attrib)
+        -> decltype(h.tickPrice(tickerId, field, price, attrib), std::true_type()) {
+        h.tickPrice(tickerId, field, price, attrib);
+        return std::true_type();
+    }
+    template<class H> std::false_type tickPrice(H &, Missing, TickerId, TickType, double, const TickAttrib &) { return std::false_type(); }
+
+    template<class H> auto tickSize(H &h, Provided, TickerId tickerId, TickType field, int size)
+        -> decltype(h.tickSize(tickerId, field, size), std::true_type()) {
+        h.tickSize(tickerId, field, size);
+        return std::true_type();
+    }
+    template<class H> std::false_type tickSize(H &, Missing, TickerId, TickType, int) { return std::false_type(); }
+
+    template<class H> auto tickGeneric(H &h, Provided, TickerId tickerId, TickType tickType, double value)
+        -> decltype(h.tickGeneric(tickerId, tickType, value), std::true_type()) {
+        h.tickGeneric(tickerId, tickType, value);
+        return std::true_type();
+    }
+    template<class H> std::false_type tickGeneric(H &, Missing, TickerId, TickType, double) { return std::false_type(); }
+
+    template<class H> auto tickString(H &h, Provided, TickerId tickerId, TickType tickType, const EStringView &value)
+        -> decltype(h.tickString(tickerId, tickType, value), std::true_type()) {
+        h.tickString(tickerId, tickType, value);
+        return std::true_type();
+    }
+    template<class H> auto tickString(H &h, Copying, TickerId tickerId, TickType tickType, const EStringView &value)
+        -> decltype(h.tickString(tickerId, tickType, std::string()), std::true_type()) {
+        h.tickString(tickerId, tickType, value.str());
+        return std::true_type();
+    }
+    template<class H> std::false_type tickString(H &, Missing, TickerId, TickType, const EStringView &) { return std::false_type(); }
+
+    template<class H> auto updateMktDepth(H &h, Provided, TickerId id, int position, int operation, int side, double price, int size)
+        -> decltype(h.updateMktDepth(id, position, operation, side, price, size), std::true_type()) {
+        h.updateMktDepth(id, position, operation, side, price, size);
+        return std::true_type();
+    }
+    template<class H> std::false_type updateMktDepth(H &, Missing, TickerId, int, int, int, double, int) { return std::false_type(); }
+
+    template<class H> auto updateMktDepthL2(H &h, Provided, TickerId id, int position, const EStringView &marketMaker, int operation,
+        int side, double price, int size, bool isSmartDepth)
+        -> decltype(h.updateMktDepthL2(id, position, marketMaker, operation, side, price, size, isSmartDepth), std::true_type()) {
+        h.updateMktDepthL2(id, position, marketMaker, operation, side, price, size, isSmartDepth);
+        return std::true_type();
+    }
+    template<class H> auto updateMktDepthL2(H &h, Copying, TickerId id, int position, const EStringView &marketMaker, int operation,
+        int side, double price, int size, bool isSmartDepth)
+        -> decltype(h.updateMktDepthL2(id, position, std::string(), operation, side, price, size, isSmartDepth), std::true_type()) {
+        h.updateMktDepthL2(id, position, marketMaker.str(), operation, side, price, size, isSmartDepth);
+        return std::true_type();
+    }
+    template<class H> std::false_type updateMktDepthL2(H &, Missing, TickerId, int, const EStringView &, int, int, double, int, bool) { return std::false_type(); }
+
+    template<class H> auto tickByTickAllLast(H &h, Provided, int reqId, int tickType, time_t time, double price, int size,
+        const TickAttribLast &attribs, const EStringView &exchange, const EStringView &specialConditions)
+        -> decltype(h.tickByTickAllLast(reqId, tickType, time, price, size, attribs, exchange, specialConditions), std::true_type()) {
+        h.tickByTickAllLast(reqId, tickType, time, price, size, attribs, exchange, specialConditions);
+        return std::true_type();
+    }
+    template<class H> auto tickByTickAllLast(H &h, Copying, int reqId, int tickType, time_t time, double price, int size,
+        const TickAttribLast &attribs, const EStringView &exchange, const EStringView &specialConditions)
+        -> decltype(h.tickByTickAllLast(reqId, tickType, time, price, size, attribs, std::string(), std::string()), std::true_type()) {
+        h.tickByTickAllLast(reqId, tickType, time, price, size, attribs, exchange.str(), specialConditions.str());
+        return std::true_type();
+    }
+    template<class H> std::false_type tickByTickAllLast(H &, Missing, int, int, time_t, double, int,
+        const TickAttribLast &, const EStringView &, const EStringView &) { return std::false_type(); }
+
+    template<class H> auto tickByTickBidAsk(H &h, Provided, int reqId, time_t time, double bidPrice, double askPrice,
+        int bidSize, int askSize, const TickAttribBidAsk &attribs)
+        -> decltype(h.tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, attribs), std::true_type()) {
+        h.tickByTickBidAsk(reqId, time, bidPrice, askPrice, bidSize, askSize, attribs);
+        return std::true_type();
+    }
+    template<class H> std::false_type tickByTickBidAsk(H &, Missing, int, time_t, double, double, int, int,
+        const TickAttribBidAsk &) { return std::false_type(); }
+
+    template<class H> auto tickByTickMidPoint(H &h, Provided, int reqId, time_t time, double midPoint)
+        -> decltype(h.tickByTickMidPoint(reqId, time, midPoint), std::true_type()) {
+        h.tickByTickMidPoint(reqId, time, midPoint);
+        return std::true_type();
+    }
+    template<class H> std::false_type tickByTickMidPoint(H &, Missing, int, time_t, double) { return std::false_type(); }
+
+    template<class H> auto pnl(H &h, Provided, int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL)
+        -> decltype(h.pnl(reqId, dailyPnL, unrealizedPnL, realizedPnL), std::true_type()) {
+        h.pnl(reqId, dailyPnL, unrealizedPnL, realizedPnL);
+        return std::true_type();
+    }
+    template<class H> std::false_type pnl(H &, Missing, int, double, double, double) { return std::false_type(); }
+
+    template<class H> auto pnlSingle(H &h, Provided, int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value)
+        -> decltype(h.pnlSingle(reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value), std::true_type()) {
+        h.pnlSingle(reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
+        return std::true_type();
+    }
+    template<class H> std::false_type pnlSingle(H &, Missing, int, int, double, double, double, double) { return std::false_type(); }
+
+    template<class A, class B, class C = std::false_type>
+    struct Any : std::integral_constant<bool, A::value || B::value || C::value> {};
+}
+
+// Decoder for the market data and PnL messages, bound to Handler at compile time. Handler is
+// any class with some of the EWrapper methods these messages end in (tickPrice, tickSize,
+// tickGeneric, tickString, updateMktDepth, updateMktDepthL2, tickByTickAllLast,
+// tickByTickBidAsk, tickByTickMidPoint, pnl, pnlSingle); string fields may be taken as
+// EStringView or const std::string&. The fields are read by the same EMarketDataParser code
+// as in EDecoder, instantiated for the connection's version tier, and the calls are direct,
+// so the compiler can inline the handler into the decode. A message whose callbacks Handler does not declare is dropped
+// without decoding its fields, which relies on endPtr being the end of the message (EReader
+// always hands over one frame). Every other message goes to the fallback EDecoder and so to
+// its EWrapper, as before.
+//
+// Exceptions thrown by Handler propagate to the caller of processMsgs() or pollOnce().
+template<class Handler>
+class EStaticDecoder : public EMessageDecoder
+{
+    typedef EStaticDispatch::Provided Provided;
+
+    typedef decltype(EStaticDispatch::tickPrice(std::declval<Handler&>(), Provided(), TickerId(), TickType(), 0.0, TickAttrib())) HasTickPrice;
+    typedef decltype(EStaticDispatch::tickSize(std::declval<Handler&>(), Provided(), TickerId(), TickType(), 0)) HasTickSize;
+    typedef decltype(EStaticDispatch::tickGeneric(std::declval<Handler&>(), Provided(), TickerId(), TickType(), 0.0)) HasTickGeneric;
+    typedef decltype(EStaticDispatch::tickString(std::declval<Handler&>(), Provided(), TickerId(), TickType(), EStringView())) HasTickString;
+    typedef decltype(EStaticDispatch::updateMktDepth(std::declval<Handler&>(), Provided(), TickerId(), 0, 0, 0, 0.0, 0)) HasMktDepth;
+    typedef decltype(EStaticDispatch::updateMktDepthL2(std::declval<Handler&>(), Provided(), TickerId(), 0, EStringView(), 0, 0, 0.0, 0, false)) HasMktDepthL2;
+    typedef decltype(EStaticDispatch::tickByTickAllLast(std::declval<Handler&>(), Provided(), 0, 0, time_t(), 0.0, 0,
+        TickAttribLast(), EStringView(), EStringView())) HasTickByTickAllLast;
+    typedef decltype(EStaticDispatch::tickByTickBidAsk(std::declval<Handler&>(), Provided(), 0, time_t(), 0.0, 0.0, 0, 0,
+        TickAttribBidAsk())) HasTickByTickBidAsk;
+    typedef decltype(EStaticDispatch::tickByTickMidPoint(std::declval<Handler&>(), Provided(), 0, time_t(), 0.0)) HasTickByTickMidPoint;
+    typedef decltype(EStaticDispatch::pnl(std::declval<Handler&>(), Provided(), 0, 0.0, 0.0, 0.0)) HasPnL;
+    typedef decltype(EStaticDispatch::pnlSingle(std::declval<Handler&>(), Provided(), 0, 0, 0.0, 0.0, 0.0, 0.0)) HasPnLSingle;
+
+    // what EMarketDataParser calls back into: the handler, through EStaticDispatch
+    class Sink
+    {
+        Handler &m_handler;
+
+    public:
+        explicit Sink(Handler &handler) : m_handler(handler) {}
+
+        bool wantsTickByTick(int tickType) const {
+            return tickType == 1 || tickType == 2 ? HasTickByTickAllLast::value
+                : tickType == 3 ? HasTickByTickBidAsk::value
+                : tickType == 4 ? HasTickByTickMidPoint::value : true;
+        }
+
+        void tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib &attrib) {
+            EStaticDispatch::tickPrice(m_handler, Provided(), tickerId, field, price, attrib);
+        }
+        void tickSize(TickerId tickerId, TickType field, int size) {
+            EStaticDispatch::tickSize(m_handler, Provided(), tickerId, field, size);
+        }
+        void tickGeneric(TickerId tickerId, TickType tickType, double value) {
+            EStaticDispatch::tickGeneric(m_handler, Provided(), tickerId, tickType, value);
+        }
+        void tickString(TickerId tickerId, TickType tickType, const EStringView &value) {
+            EStaticDispatch::tickString(m_handler, Provided(), tickerId, tickType, value);
+        }
+        void updateMktDepth(TickerId id, int position, int operation, int side, double price, int size) {
+            EStaticDispatch::updateMktDepth(m_handler, Provided(), id, position, operation, side, price, size);
+        }
+        void updateMktDepthL2(TickerId id, int position, const EStringView &marketMaker, int operation,
+            int side, double price, int size, bool isSmartDepth) {
+            EStaticDispatch::updateMktDepthL2(m_handler, Provided(), id, position, marketMaker, operation, side, price, size, isSmartDepth);
+        }
+        void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size,
+            const TickAttribLast &attribs, const EStringView &exchange, const EStringView &specialConditions) {
+            EStaticDispatch::tickByTickAllLast(m_handler, Provided(), reqId, tickType, time, price, size, attribs, exchange, specialConditions);
+        }
+        void tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice,
+            int bidSize, int askSize, const TickAttribBidAsk &attribs) {
+            EStaticDispatch::tickByTickBidAsk(m_handler, Provided(), reqId, time, bidPrice, askPrice, bidSize, askSize, attribs);
+        }
+        void tickByTickMidPoint(int reqId, time_t time, double midPoint) {
+            EStaticDispatch::tickByTickMidPoint(m_handler, Provided(), reqId, time, midPoint);
+        }
+        void pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) {
+            EStaticDispatch::pnl(m_handler, Provided(), reqId, dailyPnL, unrealizedPnL, realizedPnL);
+        }
+        void pnlSingle(int reqId, int pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {
+            EStaticDispatch::pnlSingle(m_handler, Provided(), reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value);
+        }
+    };
+
+    Sink m_sink;
+
+    // not wanted by Handler, the whole message is consumed unread
+    static const char* skipMsg(const char* ptr, const char* endPtr) { return endPtr; }
+
+    // disable copy (compatible with pre C++11 compiler hence =delete not used)
+    EStaticDecoder(const EStaticDecoder&);
+    EStaticDecoder& operator=(const EStaticDecoder&);
+
+public:
+    explicit EStaticDecoder(Handler &handler) : m_sink(handler) {}
+
+    int parseAndProcessMsg(const char*& beginPtr, const char* endPtr, EDecoder &fallback);
+};
+
+template<class Handler>
+int EStaticDecoder<Handler>::parseAndProcessMsg(const char*& beginPtr, const char* endPtr, EDecoder &fallback) {
+	// process a single message from the buffer;
+	// return number of bytes consumed
+
+	const int serverVersion = fallback.serverVersion();
+
+	if (serverVersion == 0)
+		return fallback.parseAndProcessMsg(beginPtr, endPtr);
+
+	const char* ptr = beginPtr;
+
+	int msgId;
+	DECODE_FIELD( msgId);
+
+	// the fields are walked by EMarketDataParser as in EDecoder, the versioned messages through
+	// the instantiation for the connection's version tier
+	const bool latest = IsLatestVersion(serverVersion);
+
+	switch( msgId) {
+	case TICK_PRICE:
+		ptr = !EStaticDispatch::Any<HasTickPrice, HasTickSize>::value ? skipMsg(ptr, endPtr)
+			: latest ? EMarketDataParser::tickPrice<EVersionLatest>(m_sink, serverVersion, ptr, endPtr)
+			: EMarketDataParser::tickPrice<EVersionAny>(m_sink, serverVersion, ptr, endPtr);
+		break;
+
+	case TICK_SIZE:
+		ptr = HasTickSize::value ? EMarketDataParser::tickSize(m_sink, ptr, endPtr) : skipMsg(ptr, endPtr);
+		break;
+
+	case TICK_GENERIC:
+		ptr = HasTickGeneric::value ? EMarketDataParser::tickGeneric(m_sink, ptr, endPtr) : skipMsg(ptr, endPtr);
+		break;
+
+	case TICK_STRING:
+		ptr = HasTickString::value ? EMarketDataParser::tickString(m_sink, ptr, endPtr) : skipMsg(ptr, endPtr);
+		break;
+
+	case MARKET_DEPTH:
+		ptr = HasMktDepth::value ? EMarketDataParser::marketDepth(m_sink, ptr, endPtr) : skipMsg(ptr, endPtr);
+		break;
+
+	case MARKET_DEPTH_L2:
+		ptr = !HasMktDepthL2::value ? skipMsg(ptr, endPtr)
+			: latest ? EMarketDataParser::marketDepthL2<EVersionLatest>(m_sink, serverVersion, ptr, endPtr)
+			: EMarketDataParser::marketDepthL2<EVersionAny>(m_sink, serverVersion, ptr, endPtr);
+		break;
+
+	case TICK_BY_TICK:
+		ptr = EStaticDispatch::Any<HasTickByTickAllLast, HasTickByTickBidAsk, HasTickByTickMidPoint>::value
+			? EMarketDataParser::tickByTick(m_sink, ptr, endPtr) : skipMsg(ptr, endPtr);
+		break;
+
+	case PNL:
+		ptr = !HasPnL::value ? skipMsg(ptr, endPtr)
+			: latest ? EMarketDataParser::pnl<EVersionLatest>(m_sink, serverVersion, ptr, endPtr)
+			: EMarketDataParser::pnl<EVersionAny>(m_sink, serverVersion, ptr, endPtr);
+		break;
+
+	case PNL_SINGLE:
+		ptr = !HasPnLSingle::value ? skipMsg(ptr, endPtr)
+			: latest ? EMarketDataParser::pnlSingle<EVersionLatest>(m_sink, serverVersion, ptr, endPtr)
+			: EMarketDataParser::pnlSingle<EVersionAny>(m_sink, serverVersion, ptr, endPtr);
+		break;
+
+	default:
+		return fallback.parseAndProcessMsg(beginPtr, endPtr);
+	}
+
+	if (!ptr)
+		return 0;
+
+	int processed = ptr - beginPtr;
+	beginPtr = ptr;
+	return processed;
+}
+
+#endif
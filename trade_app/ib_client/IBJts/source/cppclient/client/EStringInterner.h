@@ -0,0 +1,72 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_ESTRINGINTERNER_H
+#define TWS_API_CLIENT_ESTRINGINTERNER_H
+
+#include <string>
+#include <vector>
+#include <string.h>
+#include "platformspecific.h"
+#include "EWrapperView.h"
+
+// Maps each distinct string to a small id, 0, 1, 2, ... in order of first appearance. Meant
+// for the few distinct values a field takes (exchanges, conditions): once a value has been
+// seen, intern() finds its id without allocating. Ids stay valid for the interner's lifetime.
+class TWSAPIDLLEXP EStringInterner
+{
+    std::vector<std::string> m_strings;
+    std::vector<int> m_slots;            // open addressing by hash, id + 1, 0 when free
+
+    static unsigned int hash(const char *data, size_t size) {
+        unsigned int h = 2166136261u;
+        for (size_t i = 0; i < size; ++i)
+            h = (h ^ (unsigned char)data[i]) * 16777619u;
+        return h;
+    }
+
+    size_t slotOf(const char *data, size_t size) const {
+        size_t mask = m_slots.size() - 1;
+        size_t slot = hash(data, size) & mask;
+
+        for (;;) {
+            int id = m_slots[slot] - 1;
+            if (id < 0 || (m_strings[id].size() == size && memcmp(m_strings[id].data(), data, size) == 0))
+                return slot;
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    void grow() {
+        std::vector<int> slots(m_slots.size() * 2, 0);
+        m_slots.swap(slots);
+
+        for (size_t id = 0; id < m_strings.size(); ++id)
+            m_slots[slotOf(m_strings[id].data(), m_strings[id].size())] = (int)id + 1;
+    }
+
+public:
+    EStringInterner() : m_slots(64, 0) {}
+
+    int intern(const EStringView &value) {
+        size_t slot = slotOf(value.data(), value.size());
+
+        if (m_slots[slot])
+            return m_slots[slot] - 1;
+
+        int id = (int)m_strings.size();
+        m_strings.push_back(value.str());
+        m_slots[slot] = id + 1;
+
+        if (m_strings.size() * 2 > m_slots.size())
+            grow();
+
+        return id;
+    }
+
+    const std::string &str(int id) const { return m_strings[id]; }
+    int size() const { return (int)m_strings.size(); }
+};
+
+#endif
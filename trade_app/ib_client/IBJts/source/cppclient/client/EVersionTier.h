@@ -0,0 +1,38 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EVERSIONTIER_H
+#define TWS_API_CLIENT_EVERSIONTIER_H
+
+#include "platformspecific.h"
+#include "EDecoder.h"
+
+// Server version ranges the hot encode and decode routines are instantiated for. Those
+// routines take the version their feature checks compare against from
+// Tier::serverVersion(m_serverVersion). A connection that negotiated the newest version this
+// client speaks runs the EVersionLatest instantiation, where that is the constant
+// MAX_CLIENT_VER and every check folds away at compile time; any other version runs the
+// EVersionAny one and compares as before.
+struct EVersionAny
+{
+    static int serverVersion(int version) { return version; }
+};
+
+struct EVersionLatest
+{
+    static int serverVersion(int) { return MAX_CLIENT_VER; }
+};
+
+// whether a connection at version runs the EVersionLatest instantiations. Define
+// IBAPI_NO_VERSION_TIERS to run EVersionAny at every version, e.g. to check the two against
+// each other (samples/Cpp/ClientTests).
+inline bool IsLatestVersion(int version) {
+#if defined(IBAPI_NO_VERSION_TIERS)
+    return false;
+#else
+    return version == MAX_CLIENT_VER;
+#endif
+}
+
+#endif
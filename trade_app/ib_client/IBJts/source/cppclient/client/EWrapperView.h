@@ -0,0 +1,57 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_EWRAPPERVIEW_H
+#define TWS_API_CLIENT_EWRAPPERVIEW_H
+
+#include <string>
+#include <string.h>
+#include "platformspecific.h"
+#include "EWrapper.h"
+
+// Non-owning view of one decoded string field. It points straight into the received
+// message and is only valid until the callback it was passed to returns; copy it with
+// str() to keep it. The field's NUL terminator is part of the message, so c_str() is safe.
+class TWSAPIDLLEXP EStringView
+{
+    const char *m_data;
+    size_t m_size;
+
+public:
+    EStringView() : m_data(""), m_size(0) {}
+    EStringView(const char *data, size_t size) : m_data(data), m_size(size) {}
+    explicit EStringView(const std::string &s) : m_data(s.c_str()), m_size(s.size()) {}
+
+    const char *data() const { return m_data; }
+    const char *c_str() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    std::string str() const { return std::string(m_data, m_size); }
+
+    bool operator==(const char *s) const { return strlen(s) == m_size && memcmp(m_data, s, m_size) == 0; }
+    bool operator!=(const char *s) const { return !(*this == s); }
+};
+
+// Opt-in callbacks for the frequent messages that carry strings. Once a view is installed
+// (EReader::wrapperView()), these messages are delivered here with their string fields as
+// EStringView instead of through the matching EWrapper methods, so decoding them does not
+// allocate. Every other message still goes to the EWrapper.
+class TWSAPIDLLEXP EWrapperView
+{
+public:
+    virtual ~EWrapperView() {}
+
+    virtual void tickByTickAllLast(int reqId, int tickType, time_t time, double price, int size,
+        const TickAttribLast& tickAttribLast, const EStringView& exchange, const EStringView& specialConditions) = 0;
+    virtual void tickString(TickerId tickerId, TickType tickType, const EStringView& value) = 0;
+    virtual void tickReqParams(int tickerId, double minTick, const EStringView& bboExchange, int snapshotPermissions) = 0;
+    virtual void updateMktDepthL2(TickerId id, int position, const EStringView& marketMaker, int operation,
+        int side, double price, int size, bool isSmartDepth) = 0;
+    virtual void orderStatus(OrderId orderId, const EStringView& status, double filled,
+        double remaining, double avgFillPrice, int permId, int parentId,
+        double lastFillPrice, int clientId, const EStringView& whyHeld, double mktCapPrice) = 0;
+    virtual void error(int id, int errorCode, const EStringView& errorString) = 0;
+};
+
+#endif
@@ -0,0 +1,33 @@
+﻿/* Copyright (C) 2019 Interactive Brokers LLC. All rights reserved. This code is subject to the terms
+ * and conditions of the IB API Non-Commercial License or the IB API Commercial License, as applicable. */
+
+#pragma once
+#ifndef TWS_API_CLIENT_SOCKETOPTIONS_H
+#define TWS_API_CLIENT_SOCKETOPTIONS_H
+
+// Options applied to the gateway socket by EClientSocket::eConnect(). Integer options
+// left at -1 keep the kernel default. After connecting, EClientSocket::effectiveSocketOptions()
+// holds the values as the kernel reports them (Linux doubles the buffer sizes it is given).
+// busyPollMicros, quickAck, priority and rxTimestamps are Linux only and stay -1/false elsewhere.
+struct SocketOptions
+{
+	SocketOptions()
+		: noDelay(true)
+		, rcvBuf(-1)
+		, sndBuf(-1)
+		, busyPollMicros(-1)
+		, quickAck(false)
+		, priority(-1)
+		, rxTimestamps(true)
+	{}
+
+	bool noDelay;        // TCP_NODELAY, on by default so small order messages skip Nagle
+	int rcvBuf;          // SO_RCVBUF in bytes, set before connect so the window scale can use it
+	int sndBuf;          // SO_SNDBUF in bytes
+	int busyPollMicros;  // SO_BUSY_POLL
+	bool quickAck;       // TCP_QUICKACK, re-armed after every read since the kernel clears it
+	int priority;        // SO_PRIORITY
+	bool rxTimestamps;   // SO_TIMESTAMPNS, kernel receive times for EMessage::receiveTime()
+};
+
+#endif
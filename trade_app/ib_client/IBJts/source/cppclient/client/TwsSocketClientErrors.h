@@ -35,6 +35,7 @@ static const CodeMsgPair UNKNOWN_ID(505, "Fatal Error: Unknown message id.");
 static const CodeMsgPair UNSUPPORTED_VERSION(506, "Unsupported version");
 static const CodeMsgPair BAD_LENGTH(507, "Bad message length");
 static const CodeMsgPair BAD_MESSAGE(508, "Bad message");
+static const CodeMsgPair FAIL_SEND_ORDER(512, "Order sending error - ");
 static const CodeMsgPair SOCKET_EXCEPTION(509, "Exception caught while reading socket - ");
 static const CodeMsgPair FAIL_CREATE_SOCK(520, "Failed to create socket");
 static const CodeMsgPair SSL_FAIL(530, "SSL specific error: ");
@@ -22,6 +22,7 @@
 #include <time.h>
 #define IB_WIN32
 #define atoll _atoi64
+#undef IBAPI_IO_URING
 #else
 
 #include <arpa/inet.h>
@@ -44,6 +45,21 @@
 #error "Not supported on this platform"
 #endif
 
+#if defined(__linux__) && !defined(IBAPI_NO_EPOLL) // edge-triggered epoll reader loop, define IBAPI_NO_EPOLL to fall back to select()
+#include <sys/epoll.h>
+#define IBAPI_EPOLL
+#endif
+
+#if defined(__linux__) && !defined(IBAPI_NO_FUTEX) // EReaderFutexSignal parks on a futex, define IBAPI_NO_FUTEX to use a condition variable
+#define IBAPI_FUTEX
+#endif
+
+// IBAPI_IO_URING (off by default, pass -DIBAPI_IO_URING) makes EReader receive through an
+// io_uring multishot recv, see EIoUring.h; it needs Linux 6.0+ and a seccomp profile that allows io_uring
+#if !defined(__linux__)
+#undef IBAPI_IO_URING
+#endif
+
 #endif // #ifdef _MSC_VER
 
 #ifndef TWSAPIDLLEXP